@@ -86,7 +86,7 @@ class FlashTool(tk.Tk):
         super().__init__()
         self.title("ESP-01S Radio — Hog Worxs Labs")
         self.configure(bg=BG)
-        self.geometry("660x720")
+        self.geometry("660x770")
         self.resizable(False, False)
 
         self.config_content = read_config()
@@ -132,6 +132,7 @@ class FlashTool(tk.Tk):
             ("WIFI_TX_RATE",         "TX Rate",         "combo_tx",   "lower = more range"),
             ("UART_BAUD_RATE",       "Baud Rate",       "combo_baud", "match RP2040"),
             ("MAX_PACKET_SIZE",      "Max Packet Size", "entry",      "16-256 bytes"),
+            ("LINK_PACKET_RATE_HZ",  "Packet Rate",     "entry",      "frames/s, 0 = no check"),
         ]
 
         for i, (define, label, wtype, hint) in enumerate(rows):
@@ -211,6 +212,7 @@ class FlashTool(tk.Tk):
         self.entries["CUSTOM_BSSID"].set(get_define(c, "CUSTOM_BSSID"))
         self.entries["MAX_PACKET_SIZE"].set(get_define(c, "MAX_PACKET_SIZE"))
         self.entries["UART_BAUD_RATE"].set(get_define(c, "UART_BAUD_RATE"))
+        self.entries["LINK_PACKET_RATE_HZ"].set(get_define(c, "LINK_PACKET_RATE_HZ"))
         tx = get_define(c, "WIFI_TX_RATE")
         self.entries["WIFI_TX_RATE"].set(TX_RATES.get(tx, TX_RATES[TX_RATE_KEYS[0]]))
 
@@ -255,6 +257,15 @@ class FlashTool(tk.Tk):
             self._log("ERROR: Packet size must be a number", RED)
             return False
 
+        try:
+            hz = int(self.entries["LINK_PACKET_RATE_HZ"].get())
+            if not 0 <= hz <= 5000:
+                self._log("ERROR: Packet rate must be 0-5000", RED)
+                return False
+        except ValueError:
+            self._log("ERROR: Packet rate must be a number", RED)
+            return False
+
         return True
 
     def _apply_config(self):
@@ -263,6 +274,7 @@ class FlashTool(tk.Tk):
         c = set_define(c, "CUSTOM_BSSID", self.entries["CUSTOM_BSSID"].get().strip().upper())
         c = set_define(c, "MAX_PACKET_SIZE", self.entries["MAX_PACKET_SIZE"].get().strip())
         c = set_define(c, "UART_BAUD_RATE", self.entries["UART_BAUD_RATE"].get().strip())
+        c = set_define(c, "LINK_PACKET_RATE_HZ", self.entries["LINK_PACKET_RATE_HZ"].get().strip())
         tx_disp = self.entries["WIFI_TX_RATE"].get()
         for key, desc in TX_RATES.items():
             if desc == tx_disp:
@@ -302,6 +314,12 @@ class FlashTool(tk.Tk):
                 return
             self.after(0, self._log, "Build OK", GREEN)
 
+            # Capacity model notes (src/airtime.c): rate x size vs the channel
+            for line in (r.stdout + r.stderr).splitlines():
+                m = re.search(r"#pragma message: (capacity: [^']*)", line)
+                if m:
+                    self.after(0, self._log, "WARNING: " + m.group(1), YELLOW)
+
             self.after(0, self._log, f"Flashing {port}...", YELLOW)
             r = subprocess.run(["make", "flash", f"SERIAL_PORT={port}"],
                                cwd=SCRIPT_DIR, capture_output=True, text=True)
@@ -0,0 +1,34 @@
+/* ==================================================
+ * Host SDK Shim: c_types.h
+ * Fixed-width types and section attributes, as the
+ * Non-OS SDK defines them, for the Linux host build
+ * ================================================== */
+
+#ifndef C_TYPES_H
+#define C_TYPES_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef uint8_t  uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef int8_t   sint8;
+typedef int16_t  sint16;
+typedef int32_t  sint32;
+typedef int8_t   int8;
+typedef int16_t  int16;
+typedef int32_t  int32;
+
+typedef unsigned char bool;
+#define true                    1
+#define false                   0
+
+#define BIT(nr)                 (1UL << (nr))
+
+/* Code placement means nothing on the host */
+#define ICACHE_FLASH_ATTR
+#define ICACHE_RODATA_ATTR
+#define STORE_ATTR
+
+#endif /* C_TYPES_H */
@@ -0,0 +1,57 @@
+/* ==================================================
+ * Host SDK Shim: driver/uart_register.h
+ * ESP8266 UART register map (the subset src/uart.c
+ * uses), emulated by host/sim_uart.c
+ * ================================================== */
+
+#ifndef UART_REGISTER_H
+#define UART_REGISTER_H
+
+#define REG_UART_BASE(i)                (0x60000000 + (i) * 0xF00)
+
+#define UART_FIFO(i)                    (REG_UART_BASE(i) + 0x00)
+#define UART_INT_RAW(i)                 (REG_UART_BASE(i) + 0x04)
+#define UART_INT_ST(i)                  (REG_UART_BASE(i) + 0x08)
+#define UART_INT_ENA(i)                 (REG_UART_BASE(i) + 0x0C)
+#define UART_INT_CLR(i)                 (REG_UART_BASE(i) + 0x10)
+#define UART_CLKDIV(i)                  (REG_UART_BASE(i) + 0x14)
+#define UART_STATUS(i)                  (REG_UART_BASE(i) + 0x1C)
+#define UART_CONF0(i)                   (REG_UART_BASE(i) + 0x20)
+#define UART_CONF1(i)                   (REG_UART_BASE(i) + 0x24)
+
+/* Interrupt bits (INT_RAW / INT_ST / INT_ENA / INT_CLR) */
+#define UART_RXFIFO_FULL_INT_ST         (1u << 0)
+#define UART_TXFIFO_EMPTY_INT_ST        (1u << 1)
+#define UART_RXFIFO_TOUT_INT_ST         (1u << 8)
+#define UART_RXFIFO_FULL_INT_ENA        UART_RXFIFO_FULL_INT_ST
+#define UART_TXFIFO_EMPTY_INT_ENA       UART_TXFIFO_EMPTY_INT_ST
+#define UART_RXFIFO_TOUT_INT_ENA        UART_RXFIFO_TOUT_INT_ST
+#define UART_RXFIFO_FULL_INT_CLR        UART_RXFIFO_FULL_INT_ST
+#define UART_TXFIFO_EMPTY_INT_CLR       UART_TXFIFO_EMPTY_INT_ST
+#define UART_RXFIFO_TOUT_INT_CLR        UART_RXFIFO_TOUT_INT_ST
+
+/* STATUS */
+#define UART_RXFIFO_CNT                 0x000000FF
+#define UART_RXFIFO_CNT_S               0
+#define UART_TXFIFO_CNT                 0x000000FF
+#define UART_TXFIFO_CNT_S               16
+
+/* CLKDIV */
+#define UART_CLKDIV_CNT                 0x000FFFFF
+
+/* CONF0 */
+#define UART_BIT_NUM                    0x00000003
+#define UART_BIT_NUM_S                  2
+#define UART_PARITY_EN                  0x00000001
+#define UART_PARITY_EN_S                1
+#define UART_STOP_BIT_NUM               0x00000003
+#define UART_STOP_BIT_NUM_S             4
+
+/* CONF1 */
+#define UART_RXFIFO_FULL_THRHD          0x0000007F
+#define UART_RXFIFO_FULL_THRHD_S        0
+#define UART_RX_TOUT_THRHD              0x0000007F
+#define UART_RX_TOUT_THRHD_S            24
+#define UART_RX_TOUT_EN                 (1u << 31)
+
+#endif /* UART_REGISTER_H */
@@ -0,0 +1,20 @@
+/* ==================================================
+ * Host SDK Shim: eagle_soc.h
+ * Peripheral register access, routed to the simulated
+ * UART0 (host/sim_uart.c)
+ * ================================================== */
+
+#ifndef EAGLE_SOC_H
+#define EAGLE_SOC_H
+
+#include "c_types.h"
+
+uint32_t sim_reg_read(uint32_t addr);
+void sim_reg_write(uint32_t addr, uint32_t value);
+
+#define READ_PERI_REG(addr)             sim_reg_read(addr)
+#define WRITE_PERI_REG(addr, val)       sim_reg_write((addr), (val))
+#define SET_PERI_REG_MASK(reg, mask)    WRITE_PERI_REG((reg), READ_PERI_REG(reg) | (mask))
+#define CLEAR_PERI_REG_MASK(reg, mask)  WRITE_PERI_REG((reg), READ_PERI_REG(reg) & ~(mask))
+
+#endif /* EAGLE_SOC_H */
@@ -0,0 +1,23 @@
+/* ==================================================
+ * Host SDK Shim: ets_sys.h
+ * Interrupt control. The simulator calls the UART
+ * "ISR" from its loop only, between tasks, so masking
+ * is a flag and the global lock is a no-op.
+ * ================================================== */
+
+#ifndef ETS_SYS_H
+#define ETS_SYS_H
+
+#include "c_types.h"
+
+void sim_uart_intr_attach(void (*handler)(void *), void *arg);
+void sim_uart_intr_enable(bool enable);
+
+#define ETS_UART_INTR_ATTACH(func, arg) sim_uart_intr_attach((void (*)(void *))(func), (arg))
+#define ETS_UART_INTR_ENABLE()          sim_uart_intr_enable(true)
+#define ETS_UART_INTR_DISABLE()         sim_uart_intr_enable(false)
+
+#define ETS_INTR_LOCK()                 do {} while (0)
+#define ETS_INTR_UNLOCK()               do {} while (0)
+
+#endif /* ETS_SYS_H */
@@ -0,0 +1,17 @@
+/* ==================================================
+ * Host SDK Shim: gpio.h
+ * The status LED has nowhere to go
+ * ================================================== */
+
+#ifndef GPIO_H
+#define GPIO_H
+
+#include "eagle_soc.h"
+
+#define PERIPHS_IO_MUX_GPIO2_U          0
+#define FUNC_GPIO2                      0
+
+#define PIN_FUNC_SELECT(reg, func)      do { (void)(reg); (void)(func); } while (0)
+#define GPIO_OUTPUT_SET(gpio, level)    do { (void)(gpio); (void)(level); } while (0)
+
+#endif /* GPIO_H */
@@ -0,0 +1,15 @@
+/* ==================================================
+ * Host SDK Shim: mem.h
+ * ================================================== */
+
+#ifndef MEM_H
+#define MEM_H
+
+#include <stdlib.h>
+#include "c_types.h"
+
+#define os_malloc               malloc
+#define os_zalloc(s)            calloc(1, (s))
+#define os_free                 free
+
+#endif /* MEM_H */
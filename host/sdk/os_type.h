@@ -0,0 +1,34 @@
+/* ==================================================
+ * Host SDK Shim: os_type.h
+ * Software timers and task events
+ * ================================================== */
+
+#ifndef OS_TYPE_H
+#define OS_TYPE_H
+
+#include "c_types.h"
+
+typedef void os_timer_func_t(void *timer_arg);
+
+/* Software timer (the SDK's ETSTimer, with a host time base) */
+typedef struct _os_timer_t {
+    struct _os_timer_t *timer_next;     /* Armed timer list, by expiry */
+    uint64_t            timer_expire;   /* Host microseconds */
+    uint32_t            timer_period;   /* Microseconds, 0 = one-shot */
+    os_timer_func_t    *timer_func;
+    void               *timer_arg;
+} os_timer_t;
+
+typedef os_timer_t ETSTimer;
+
+typedef uint32_t os_signal_t;
+typedef uint32_t os_param_t;
+
+typedef struct {
+    os_signal_t sig;
+    os_param_t  par;
+} os_event_t;
+
+typedef void (*os_task_t)(os_event_t *e);
+
+#endif /* OS_TYPE_H */
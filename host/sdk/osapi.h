@@ -0,0 +1,40 @@
+/* ==================================================
+ * Host SDK Shim: osapi.h
+ * libc-backed memory/string helpers, console output
+ * and software timers run by the simulator loop
+ * ================================================== */
+
+#ifndef OSAPI_H
+#define OSAPI_H
+
+#include <string.h>
+#include <stdio.h>
+#include "c_types.h"
+#include "os_type.h"
+
+#define os_memcpy               memcpy
+#define os_memcmp               memcmp
+#define os_memset               memset
+#define os_memmove              memmove
+#define os_strlen               strlen
+#define os_strcmp               strcmp
+#define os_strncmp              strncmp
+#define os_strcpy               strcpy
+#define os_sprintf              sprintf
+
+/**
+ * Console output (stderr, or UART0 with --uart-console)
+ */
+int os_printf(const char *fmt, ...);
+
+/**
+ * Busy-wait (sleeps on the host)
+ */
+void os_delay_us(uint32_t us);
+
+void os_timer_disarm(os_timer_t *ptimer);
+void os_timer_setfn(os_timer_t *ptimer, os_timer_func_t *pfunction, void *parg);
+void os_timer_arm(os_timer_t *ptimer, uint32_t ms, bool repeat);
+void os_timer_arm_us(os_timer_t *ptimer, uint32_t us, bool repeat);
+
+#endif /* OSAPI_H */
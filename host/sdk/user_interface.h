@@ -0,0 +1,99 @@
+/* ==================================================
+ * Host SDK Shim: user_interface.h
+ * System, task and WiFi calls the firmware makes,
+ * implemented by the simulator (host/sim_*.c)
+ * ================================================== */
+
+#ifndef USER_INTERFACE_H
+#define USER_INTERFACE_H
+
+#include "c_types.h"
+#include "os_type.h"
+
+/* ==================================================
+ * SYSTEM
+ * ================================================== */
+
+#define USER_TASK_PRIO_0        0
+#define USER_TASK_PRIO_1        1
+#define USER_TASK_PRIO_2        2
+#define USER_TASK_PRIO_MAX      3
+
+#define UART_CLK_FREQ           80000000
+
+typedef enum {
+    SYSTEM_PARTITION_INVALID = 0,
+    SYSTEM_PARTITION_BOOTLOADER,
+    SYSTEM_PARTITION_OTA_1,
+    SYSTEM_PARTITION_OTA_2,
+    SYSTEM_PARTITION_RF_CAL,
+    SYSTEM_PARTITION_PHY_DATA,
+    SYSTEM_PARTITION_SYSTEM_PARAMETER
+} partition_type_t;
+
+typedef struct {
+    partition_type_t type;
+    uint32_t addr;
+    uint32_t size;
+} partition_item_t;
+
+enum flash_size_map {
+    FLASH_SIZE_4M_MAP_256_256 = 0,
+    FLASH_SIZE_2M,
+    FLASH_SIZE_8M_MAP_512_512,
+    FLASH_SIZE_16M_MAP_512_512,
+    FLASH_SIZE_32M_MAP_512_512,
+    FLASH_SIZE_16M_MAP_1024_1024,
+    FLASH_SIZE_32M_MAP_1024_1024
+};
+
+typedef void (*init_done_cb_t)(void);
+
+uint32 system_get_time(void);
+uint32 system_get_free_heap_size(void);
+void system_timer_reinit(void);
+void system_soft_wdt_feed(void);
+void system_init_done_cb(init_done_cb_t cb);
+bool system_os_task(os_task_t task, uint8 prio, os_event_t *queue, uint8 qlen);
+bool system_os_post(uint8 prio, os_signal_t sig, os_param_t par);
+bool system_partition_table_regist(const partition_item_t *table, uint32 num, uint32 map);
+enum flash_size_map system_get_flash_size_map(void);
+void system_phy_set_max_tpw(uint8 max_tpw);
+void uart_div_modify(uint8 uart_no, uint32 div);
+
+/* ==================================================
+ * WIFI
+ * ================================================== */
+
+#define NULL_MODE               0
+#define STATION_MODE            1
+#define SOFTAP_MODE             2
+#define STATIONAP_MODE          3
+
+#define STATION_IF              0
+#define SOFTAP_IF               1
+
+enum phy_mode {
+    PHY_MODE_11B = 1,
+    PHY_MODE_11G = 2,
+    PHY_MODE_11N = 3
+};
+
+typedef void (*freedom_outside_cb_t)(uint8 status);
+typedef void (*wifi_promiscuous_cb_t)(uint8 *buf, uint16 len);
+
+bool wifi_set_opmode(uint8 opmode);
+bool wifi_station_set_auto_connect(uint8 set);
+bool wifi_set_channel(uint8 channel);
+uint8 wifi_get_channel(void);
+bool wifi_set_phy_mode(enum phy_mode mode);
+bool wifi_get_macaddr(uint8 if_index, uint8 *macaddr);
+
+int wifi_register_send_pkt_freedom_cb(freedom_outside_cb_t cb);
+int wifi_send_pkt_freedom(uint8 *buf, int len, bool sys_seq);
+
+void wifi_set_promiscuous_rx_cb(wifi_promiscuous_cb_t cb);
+void wifi_promiscuous_enable(uint8 promiscuous);
+bool wifi_promiscuous_set_mac(const uint8_t *address);
+
+#endif /* USER_INTERFACE_H */
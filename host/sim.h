@@ -0,0 +1,162 @@
+/* ==================================================
+ * Host Simulator
+ * Runs the unmodified firmware (src/) on Linux:
+ * SDK calls are served by the host/sdk shims, UART0 is
+ * a pseudo-terminal paced at the configured baud rate,
+ * and the radio is a UDP "air" shared with other
+ * simulator instances
+ * ================================================== */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include "c_types.h"
+
+/* No wake-up needed */
+#define SIM_NEVER               UINT64_MAX
+
+/* ==================================================
+ * CLOCK (sim_main.c)
+ * ================================================== */
+
+/**
+ * Microseconds since the simulator started (never wraps)
+ *
+ * @return: Host monotonic time
+ */
+uint64_t sim_now_us(void);
+
+/* ==================================================
+ * SDK CORE (sim_sdk.c)
+ * ================================================== */
+
+/**
+ * Fire due timers, then run posted tasks until none are left
+ *
+ * @param now: sim_now_us()
+ */
+void sim_sdk_run(uint64_t now);
+
+/**
+ * Get the time the SDK core next has work
+ *
+ * @return: Next timer expiry, SIM_NEVER if none
+ */
+uint64_t sim_sdk_next_us(void);
+
+/**
+ * Call the callback registered with system_init_done_cb()
+ */
+void sim_sdk_init_done(void);
+
+/**
+ * Send os_printf() output to UART0 instead of stderr
+ *
+ * @param on: true to mirror the hardware (console shares UART0)
+ */
+void sim_sdk_set_uart_console(bool on);
+
+/* ==================================================
+ * UART0 (sim_uart.c)
+ * ================================================== */
+
+/**
+ * Create the pseudo-terminal that stands in for UART0
+ *
+ * @param link_path: Symlink to create to the PTY slave (NULL = none)
+ * @return: false if the PTY cannot be set up
+ */
+bool sim_uart_open(const char *link_path);
+
+/**
+ * Run the line at a fixed rate instead of the one set in CLKDIV
+ *
+ * @param baud: Bits per second (8N1)
+ */
+void sim_uart_set_baud(uint32_t baud);
+
+/**
+ * Remove the symlink and print the line loss counters (at exit)
+ */
+void sim_uart_close(void);
+
+/**
+ * Get the PTY master, to wait for input
+ *
+ * @return: File descriptor
+ */
+int sim_uart_fd(void);
+
+/**
+ * Move bytes between the PTY and the FIFOs at the line rate,
+ * and run the UART interrupt handler while it has work
+ *
+ * @param now: sim_now_us()
+ */
+void sim_uart_service(uint64_t now);
+
+/**
+ * Get the time the next character is due on either line
+ *
+ * @return: Wake-up time, SIM_NEVER if both lines are idle
+ */
+uint64_t sim_uart_next_us(void);
+
+/**
+ * Write console text straight into the TX FIFO, waiting
+ * for room like the SDK's character output does
+ *
+ * @param text: Bytes
+ * @param len: Length
+ */
+void sim_uart_console(const char *text, uint16_t len);
+
+/* ==================================================
+ * RADIO (sim_air.c)
+ * ================================================== */
+
+#define SIM_AIR_MAX_PEERS       8
+
+struct sim_air_config {
+    uint16_t port;                          /* Our UDP port on 127.0.0.1 */
+    uint8_t peer_count;
+    uint32_t peer_addr[SIM_AIR_MAX_PEERS];  /* IPv4, network order */
+    uint16_t peer_port[SIM_AIR_MAX_PEERS];
+    uint8_t mac[6];
+    int8_t rssi;                            /* Reported for every frame heard */
+    uint16_t loss_permille;                 /* Frames lost on receive */
+    uint32_t seed;
+};
+
+/**
+ * Open the air socket
+ *
+ * @param cfg: Settings
+ * @return: false if the port cannot be bound
+ */
+bool sim_air_open(const struct sim_air_config *cfg);
+
+/**
+ * Get the air socket, to wait for frames
+ *
+ * @return: File descriptor
+ */
+int sim_air_fd(void);
+
+/**
+ * Complete a transmission whose airtime has passed, and hand
+ * received frames to the promiscuous callback
+ *
+ * @param now: sim_now_us()
+ */
+void sim_air_service(uint64_t now);
+
+/**
+ * Get the time the frame on air completes
+ *
+ * @return: Completion time, SIM_NEVER if idle
+ */
+uint64_t sim_air_next_us(void);
+
+#endif /* SIM_H */
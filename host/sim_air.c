@@ -0,0 +1,319 @@
+/* ==================================================
+ * Host Simulator: Radio
+ *
+ * The wifi_* calls src/wifi_raw.c makes, over a UDP
+ * "air" on 127.0.0.1. An injected frame waits DIFS and
+ * a random CWmin backoff, occupies the radio for its
+ * airtime (airtime_frame_us() at WIFI_TX_RATE), is then
+ * sent to every peer and completed through the freedom
+ * callback. Received datagrams reach the promiscuous
+ * callback with an RxControl header when promiscuous
+ * mode is on, the channel matches and the frame
+ * survives the configured loss. Like the SDK, only
+ * the first 112 bytes of a management frame and 36 of
+ * a data frame reach the callback, followed by the
+ * buffer's cnt/len tail.
+ *
+ * Datagram: [0xA5][channel][rate][802.11 frame]
+ *
+ * There is no collision or contention model: peers
+ * transmitting at the same time are all heard.
+ * ================================================== */
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "osapi.h"
+#include "user_interface.h"
+#include "user_config.h"
+#include "wifi_raw.h"
+#include "airtime.h"
+
+#define SIM_AIR_MAGIC           0xA5
+#define SIM_AIR_HEADER_SIZE     3
+#define SIM_AIR_MAX_FRAME       1600
+
+/* What the SDK hands the promiscuous callback per frame type:
+ * RxControl, the captured frame bytes, then a cnt/length tail */
+#define SIM_RX_MGMT_LEN         128         /* sniffer_buf2 */
+#define SIM_RX_MGMT_CAPTURE     112
+#define SIM_RX_DATA_LEN         60          /* sniffer_buf */
+#define SIM_RX_DATA_CAPTURE     36
+
+/* ==================================================
+ * STATE
+ * ================================================== */
+
+static struct sim_air_config air;
+static int air_fd = -1;
+static uint32_t air_rng = 1;
+
+/* Radio */
+static uint8_t air_channel = 1;
+static bool air_promiscuous = false;
+static bool air_mac_filter = false;
+static uint8_t air_filter_mac[6];
+static freedom_outside_cb_t air_tx_cb = NULL;
+static wifi_promiscuous_cb_t air_rx_cb = NULL;
+
+/* Frame on air */
+static uint8_t air_tx_buf[SIM_AIR_HEADER_SIZE + SIM_AIR_MAX_FRAME];
+static uint16_t air_tx_len = 0;
+static uint64_t air_tx_done_us = SIM_NEVER;
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+static uint32_t air_random(void)
+{
+    air_rng ^= air_rng << 13;
+    air_rng ^= air_rng >> 17;
+    air_rng ^= air_rng << 5;
+    return air_rng;
+}
+
+/**
+ * Send the completed frame to every peer
+ */
+static void air_broadcast(void)
+{
+    struct sockaddr_in to;
+    uint8_t i;
+
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+
+    for (i = 0; i < air.peer_count; i++) {
+        to.sin_addr.s_addr = air.peer_addr[i];
+        to.sin_port = htons(air.peer_port[i]);
+        /* A peer that is not running yet just misses the frame */
+        sendto(air_fd, air_tx_buf, air_tx_len, 0, (struct sockaddr *)&to, sizeof(to));
+    }
+}
+
+/**
+ * Hand one received datagram to the promiscuous callback
+ */
+static void air_deliver(const uint8_t *dgram, uint16_t len)
+{
+    uint8_t buf[SIM_RX_MGMT_LEN];
+    struct RxControl *rx_ctrl = (struct RxControl *)buf;
+    const struct ieee80211_hdr *hdr;
+    uint16_t frame_len = len - SIM_AIR_HEADER_SIZE;
+    uint16_t cb_len;
+    uint16_t capture;
+    uint16_t copy;
+    uint8_t *tail;
+    uint8_t type;
+
+    if (len < SIM_AIR_HEADER_SIZE + IEEE80211_HEADER_SIZE || dgram[0] != SIM_AIR_MAGIC) {
+        return;
+    }
+    if (!air_promiscuous || air_rx_cb == NULL || dgram[1] != air_channel) {
+        return;
+    }
+    if (air.loss_permille != 0 && air_random() % 1000 < air.loss_permille) {
+        return;
+    }
+
+    hdr = (const struct ieee80211_hdr *)(dgram + SIM_AIR_HEADER_SIZE);
+    if (air_mac_filter &&
+        memcmp(hdr->addr1, air_filter_mac, 6) != 0 &&
+        memcmp(hdr->addr2, air_filter_mac, 6) != 0 &&
+        memcmp(hdr->addr3, air_filter_mac, 6) != 0) {
+        return;
+    }
+
+    memset(buf, 0, sizeof(buf));
+    rx_ctrl->rssi = air.rssi;
+    rx_ctrl->rate = dgram[2];
+    rx_ctrl->legacy_length = frame_len + AIRTIME_FCS_SIZE;
+    rx_ctrl->channel = air_channel;
+    rx_ctrl->is_group = (hdr->addr1[0] & 0x01) ? 1 : 0;
+
+    /* The SDK's len argument says which buffer type it is */
+    type = (hdr->frame_control >> 2) & 0x03;
+    if (type == 0) {
+        cb_len = SIM_RX_MGMT_LEN;
+        capture = SIM_RX_MGMT_CAPTURE;
+    } else if (type == 2) {
+        cb_len = SIM_RX_DATA_LEN;
+        capture = SIM_RX_DATA_CAPTURE;
+    } else {
+        cb_len = sizeof(*rx_ctrl);
+        capture = 0;
+    }
+
+    /* Longer frames are cut off; the receiver must not trust bytes
+     * past the capture */
+    copy = (frame_len < capture) ? frame_len : capture;
+    memcpy(buf + sizeof(*rx_ctrl), hdr, copy);
+
+    /* Tail: cnt = 1 frame, then its length (sniffer_buf2.len), or for
+     * data frames lenseq[0] = [length][seq][address3] */
+    if (capture > 0) {
+        tail = buf + sizeof(*rx_ctrl) + capture;
+        tail[0] = 1;
+        tail[2] = rx_ctrl->legacy_length & 0xFF;
+        tail[3] = rx_ctrl->legacy_length >> 8;
+        if (type == 2) {
+            tail[4] = hdr->seq_ctrl & 0xFF;
+            tail[5] = hdr->seq_ctrl >> 8;
+            memcpy(tail + 6, hdr->addr3, 6);
+        }
+    }
+
+    air_rx_cb(buf, cb_len);
+}
+
+/* ==================================================
+ * SIMULATOR INTERFACE
+ * ================================================== */
+
+bool sim_air_open(const struct sim_air_config *cfg)
+{
+    struct sockaddr_in addr;
+
+    air = *cfg;
+    air_rng = cfg->seed ? cfg->seed : 1;
+
+    air_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (air_fd < 0) {
+        perror("sim: socket");
+        return false;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(cfg->port);
+    if (bind(air_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        perror("sim: bind");
+        return false;
+    }
+
+    fprintf(stderr, "sim: air on udp/%u, %u peer(s), MAC %02X:%02X:%02X:%02X:%02X:%02X\n",
+            cfg->port, cfg->peer_count, cfg->mac[0], cfg->mac[1], cfg->mac[2],
+            cfg->mac[3], cfg->mac[4], cfg->mac[5]);
+    return true;
+}
+
+int sim_air_fd(void)
+{
+    return air_fd;
+}
+
+void sim_air_service(uint64_t now)
+{
+    uint8_t dgram[SIM_AIR_HEADER_SIZE + SIM_AIR_MAX_FRAME];
+    ssize_t got;
+
+    if (air_tx_done_us <= now) {
+        air_tx_done_us = SIM_NEVER;
+        air_broadcast();
+        if (air_tx_cb != NULL) {
+            air_tx_cb(0);
+        }
+    }
+
+    while ((got = recv(air_fd, dgram, sizeof(dgram), MSG_DONTWAIT)) > 0) {
+        air_deliver(dgram, got);
+    }
+}
+
+uint64_t sim_air_next_us(void)
+{
+    return air_tx_done_us;
+}
+
+/* ==================================================
+ * SDK WIFI CALLS
+ * ================================================== */
+
+bool wifi_set_opmode(uint8 opmode)
+{
+    return true;
+}
+
+bool wifi_station_set_auto_connect(uint8 set)
+{
+    return true;
+}
+
+bool wifi_set_channel(uint8 channel)
+{
+    if (channel < 1 || channel > 14) {
+        return false;
+    }
+    air_channel = channel;
+    return true;
+}
+
+uint8 wifi_get_channel(void)
+{
+    return air_channel;
+}
+
+bool wifi_set_phy_mode(enum phy_mode mode)
+{
+    return true;
+}
+
+bool wifi_get_macaddr(uint8 if_index, uint8 *macaddr)
+{
+    memcpy(macaddr, air.mac, 6);
+    return true;
+}
+
+int wifi_register_send_pkt_freedom_cb(freedom_outside_cb_t cb)
+{
+    air_tx_cb = cb;
+    return 0;
+}
+
+int wifi_send_pkt_freedom(uint8 *buf, int len, bool sys_seq)
+{
+    /* One frame at a time, as on the ESP */
+    if (air_tx_done_us != SIM_NEVER || len < IEEE80211_HEADER_SIZE || len > SIM_AIR_MAX_FRAME) {
+        return -1;
+    }
+
+    air_tx_buf[0] = SIM_AIR_MAGIC;
+    air_tx_buf[1] = air_channel;
+    air_tx_buf[2] = WIFI_TX_RATE;
+    memcpy(air_tx_buf + SIM_AIR_HEADER_SIZE, buf, len);
+    air_tx_len = SIM_AIR_HEADER_SIZE + len;
+    air_tx_done_us = sim_now_us() + AIRTIME_DIFS_US +
+                     (air_random() % (AIRTIME_CW_MIN + 1)) * AIRTIME_SLOT_US +
+                     airtime_frame_us(len - IEEE80211_HEADER_SIZE);
+    return 0;
+}
+
+void wifi_set_promiscuous_rx_cb(wifi_promiscuous_cb_t cb)
+{
+    air_rx_cb = cb;
+}
+
+void wifi_promiscuous_enable(uint8 promiscuous)
+{
+    air_promiscuous = promiscuous ? true : false;
+    if (!air_promiscuous) {
+        air_mac_filter = false;
+    }
+}
+
+bool wifi_promiscuous_set_mac(const uint8_t *address)
+{
+    if (!air_promiscuous) {
+        return false;
+    }
+    memcpy(air_filter_mac, address, 6);
+    air_mac_filter = true;
+    return true;
+}
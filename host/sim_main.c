@@ -0,0 +1,281 @@
+/* ==================================================
+ * Host Simulator: Entry Point
+ *
+ * Boots the firmware the way the SDK does (user_pre_init,
+ * user_init, then the init-done callback) and runs one
+ * event loop in place of the SDK scheduler: move UART
+ * characters, complete and receive radio frames, fire
+ * timers and tasks, then sleep until the next of those
+ * is due or the PTY or air socket has input.
+ *
+ *   esp-radio-sim --pty-link /tmp/esp-a --air 47100 --peer 47101
+ *   esp-radio-sim --pty-link /tmp/esp-b --air 47101 --peer 47100
+ *
+ * Flight controller tools then open /tmp/esp-a and
+ * /tmp/esp-b as serial ports.
+ * ================================================== */
+
+#define _GNU_SOURCE
+#include <arpa/inet.h>
+#include <getopt.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "sim.h"
+#include "cycles.h"
+
+/* Longest sleep, so a stuck peer never stalls the loop for long */
+#define SIM_MAX_WAIT_US         100000
+
+#define SIM_DEFAULT_AIR_PORT    47100
+#define SIM_DEFAULT_RSSI        (-50)
+
+/* Firmware entry points (src/main.c) */
+void user_pre_init(void);
+void user_init(void);
+
+static volatile sig_atomic_t sim_stop = 0;
+static uint64_t sim_start_ns = 0;
+
+/* ==================================================
+ * CLOCK
+ * ================================================== */
+
+static uint64_t sim_mono_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t sim_now_us(void)
+{
+    return (sim_mono_ns() - sim_start_ns) / 1000;
+}
+
+uint32_t cycles_now(void)
+{
+    /* 80 MHz CCOUNT: 2 cycles per 25 ns */
+    return (uint32_t)((sim_mono_ns() - sim_start_ns) * 2 / 25);
+}
+
+/* ==================================================
+ * COMMAND LINE
+ * ================================================== */
+
+static void usage(const char *prog)
+{
+    fprintf(stderr,
+        "usage: %s [options]\n"
+        "  --pty-link PATH     symlink to the UART0 pseudo-terminal\n"
+        "  --air PORT          UDP port of this radio on 127.0.0.1 (default %u)\n"
+        "  --peer [HOST:]PORT  radio that hears our frames (repeatable)\n"
+        "  --mac XX:XX:XX:XX:XX:XX  station MAC (default from the port)\n"
+        "  --rssi DBM          RSSI reported for received frames (default %d)\n"
+        "  --loss PERCENT      frames lost on receive (default 0)\n"
+        "  --uart-console      os_printf to UART0, as on hardware (default stderr)\n"
+        "  --baud N            UART0 line rate, overriding UART_BAUD_RATE\n"
+        "  --seed N            loss pattern seed\n",
+        prog, SIM_DEFAULT_AIR_PORT, SIM_DEFAULT_RSSI);
+}
+
+static bool parse_peer(struct sim_air_config *cfg, const char *arg)
+{
+    const char *colon = strrchr(arg, ':');
+    struct in_addr in;
+    char host[64];
+    long port;
+
+    if (cfg->peer_count == SIM_AIR_MAX_PEERS) {
+        return false;
+    }
+
+    in.s_addr = htonl(INADDR_LOOPBACK);
+    if (colon != NULL) {
+        if ((size_t)(colon - arg) >= sizeof(host)) {
+            return false;
+        }
+        memcpy(host, arg, colon - arg);
+        host[colon - arg] = '\0';
+        if (inet_pton(AF_INET, host, &in) != 1) {
+            return false;
+        }
+        arg = colon + 1;
+    }
+
+    port = strtol(arg, NULL, 10);
+    if (port <= 0 || port > 65535) {
+        return false;
+    }
+
+    cfg->peer_addr[cfg->peer_count] = in.s_addr;
+    cfg->peer_port[cfg->peer_count] = port;
+    cfg->peer_count++;
+    return true;
+}
+
+static bool parse_mac(uint8_t *mac, const char *arg)
+{
+    unsigned int b[6];
+    uint8_t i;
+
+    if (sscanf(arg, "%x:%x:%x:%x:%x:%x", &b[0], &b[1], &b[2], &b[3], &b[4], &b[5]) != 6) {
+        return false;
+    }
+    for (i = 0; i < 6; i++) {
+        mac[i] = b[i];
+    }
+    return true;
+}
+
+/* ==================================================
+ * MAIN LOOP
+ * ================================================== */
+
+static void on_signal(int sig)
+{
+    sim_stop = 1;
+}
+
+int main(int argc, char **argv)
+{
+    static const struct option opts[] = {
+        { "pty-link",     required_argument, NULL, 'p' },
+        { "air",          required_argument, NULL, 'a' },
+        { "peer",         required_argument, NULL, 'P' },
+        { "mac",          required_argument, NULL, 'm' },
+        { "rssi",         required_argument, NULL, 'r' },
+        { "loss",         required_argument, NULL, 'l' },
+        { "uart-console", no_argument,       NULL, 'c' },
+        { "baud",         required_argument, NULL, 'b' },
+        { "seed",         required_argument, NULL, 's' },
+        { "help",         no_argument,       NULL, 'h' },
+        { NULL, 0, NULL, 0 }
+    };
+    struct sim_air_config air;
+    const char *pty_link = NULL;
+    bool have_mac = false;
+    struct pollfd fds[2];
+    long baud = 0;
+    int opt;
+
+    memset(&air, 0, sizeof(air));
+    air.port = SIM_DEFAULT_AIR_PORT;
+    air.rssi = SIM_DEFAULT_RSSI;
+    air.seed = 1;
+
+    while ((opt = getopt_long(argc, argv, "h", opts, NULL)) != -1) {
+        switch (opt) {
+        case 'p':
+            pty_link = optarg;
+            break;
+        case 'a':
+            air.port = strtol(optarg, NULL, 10);
+            break;
+        case 'P':
+            if (!parse_peer(&air, optarg)) {
+                fprintf(stderr, "sim: bad peer '%s'\n", optarg);
+                return 2;
+            }
+            break;
+        case 'm':
+            if (!parse_mac(air.mac, optarg)) {
+                fprintf(stderr, "sim: bad MAC '%s'\n", optarg);
+                return 2;
+            }
+            have_mac = true;
+            break;
+        case 'r':
+            air.rssi = strtol(optarg, NULL, 10);
+            break;
+        case 'l':
+            air.loss_permille = strtod(optarg, NULL) * 10;
+            break;
+        case 'c':
+            sim_sdk_set_uart_console(true);
+            break;
+        case 'b':
+            baud = strtol(optarg, NULL, 10);
+            if (baud <= 0) {
+                fprintf(stderr, "sim: bad baud rate '%s'\n", optarg);
+                return 2;
+            }
+            break;
+        case 's':
+            air.seed = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    /* Espressif OUI, unique per air port */
+    if (!have_mac) {
+        air.mac[0] = 0x5C;
+        air.mac[1] = 0xCF;
+        air.mac[2] = 0x7F;
+        air.mac[3] = 0x00;
+        air.mac[4] = air.port >> 8;
+        air.mac[5] = air.port & 0xFF;
+    }
+
+    sim_start_ns = sim_mono_ns();
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    if (!sim_uart_open(pty_link) || !sim_air_open(&air)) {
+        sim_uart_close();
+        return 1;
+    }
+    if (baud != 0) {
+        sim_uart_set_baud(baud);
+    }
+
+    user_pre_init();
+    user_init();
+    sim_sdk_init_done();
+
+    fds[0].fd = sim_uart_fd();
+    fds[0].events = POLLIN;
+    fds[1].fd = sim_air_fd();
+    fds[1].events = POLLIN;
+
+    while (!sim_stop) {
+        uint64_t now = sim_now_us();
+        uint64_t next;
+        uint64_t wait_us;
+        struct timespec ts;
+
+        sim_uart_service(now);
+        sim_air_service(now);
+        sim_sdk_run(now);
+        sim_uart_service(sim_now_us());
+
+        next = sim_sdk_next_us();
+        if (sim_uart_next_us() < next) {
+            next = sim_uart_next_us();
+        }
+        if (sim_air_next_us() < next) {
+            next = sim_air_next_us();
+        }
+
+        now = sim_now_us();
+        wait_us = (next > now) ? next - now : 0;
+        if (wait_us > SIM_MAX_WAIT_US) {
+            wait_us = SIM_MAX_WAIT_US;
+        }
+        ts.tv_sec = wait_us / 1000000;
+        ts.tv_nsec = (wait_us % 1000000) * 1000;
+        ppoll(fds, 2, &ts, NULL);
+    }
+
+    sim_uart_close();
+    fprintf(stderr, "sim: stopped\n");
+    return 0;
+}
@@ -0,0 +1,277 @@
+/* ==================================================
+ * Host Simulator: SDK Core
+ *
+ * Software timers, task queues, console output and
+ * the system calls with no hardware behind them. The
+ * firmware sees the same single-threaded world as on
+ * the ESP: timers and tasks run to completion, one at
+ * a time, from the simulator loop.
+ * ================================================== */
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+/* Reported free heap (the host heap says nothing about the ESP's) */
+#define SIM_FREE_HEAP           40960
+
+/* ==================================================
+ * STATE
+ * ================================================== */
+
+/* Armed timers, earliest first */
+static os_timer_t *timer_list = NULL;
+
+/* Registered tasks, one per priority */
+struct sim_task {
+    os_task_t task;
+    os_event_t *queue;
+    uint8_t len;
+    uint8_t head;
+    uint8_t count;
+};
+static struct sim_task tasks[USER_TASK_PRIO_MAX];
+
+static init_done_cb_t init_done_cb = NULL;
+static bool console_uart = false;
+
+/* ==================================================
+ * TIMERS
+ * ================================================== */
+
+/**
+ * Insert an armed timer in expiry order
+ */
+static void timer_insert(os_timer_t *t)
+{
+    os_timer_t **pp = &timer_list;
+
+    while (*pp != NULL && (*pp)->timer_expire <= t->timer_expire) {
+        pp = &(*pp)->timer_next;
+    }
+    t->timer_next = *pp;
+    *pp = t;
+}
+
+void os_timer_disarm(os_timer_t *ptimer)
+{
+    os_timer_t **pp = &timer_list;
+
+    while (*pp != NULL) {
+        if (*pp == ptimer) {
+            *pp = ptimer->timer_next;
+            break;
+        }
+        pp = &(*pp)->timer_next;
+    }
+    ptimer->timer_next = NULL;
+}
+
+void os_timer_setfn(os_timer_t *ptimer, os_timer_func_t *pfunction, void *parg)
+{
+    os_timer_disarm(ptimer);
+    ptimer->timer_func = pfunction;
+    ptimer->timer_arg = parg;
+}
+
+void os_timer_arm_us(os_timer_t *ptimer, uint32_t us, bool repeat)
+{
+    os_timer_disarm(ptimer);
+    ptimer->timer_expire = sim_now_us() + us;
+    ptimer->timer_period = repeat ? us : 0;
+    timer_insert(ptimer);
+}
+
+void os_timer_arm(os_timer_t *ptimer, uint32_t ms, bool repeat)
+{
+    os_timer_arm_us(ptimer, ms * 1000, repeat);
+}
+
+/* ==================================================
+ * TASKS
+ * ================================================== */
+
+bool system_os_task(os_task_t task, uint8 prio, os_event_t *queue, uint8 qlen)
+{
+    if (prio >= USER_TASK_PRIO_MAX || qlen == 0) {
+        return false;
+    }
+
+    tasks[prio].task = task;
+    tasks[prio].queue = queue;
+    tasks[prio].len = qlen;
+    tasks[prio].head = 0;
+    tasks[prio].count = 0;
+    return true;
+}
+
+bool system_os_post(uint8 prio, os_signal_t sig, os_param_t par)
+{
+    struct sim_task *t;
+    os_event_t *e;
+
+    if (prio >= USER_TASK_PRIO_MAX || tasks[prio].task == NULL) {
+        return false;
+    }
+
+    t = &tasks[prio];
+    if (t->count == t->len) {
+        return false;
+    }
+
+    e = &t->queue[(t->head + t->count) % t->len];
+    e->sig = sig;
+    e->par = par;
+    t->count++;
+    return true;
+}
+
+/**
+ * Run one posted event, highest priority first
+ *
+ * @return: false if no task had an event
+ */
+static bool task_run_one(void)
+{
+    int prio;
+
+    for (prio = USER_TASK_PRIO_MAX - 1; prio >= 0; prio--) {
+        struct sim_task *t = &tasks[prio];
+        os_event_t e;
+
+        if (t->count == 0) {
+            continue;
+        }
+
+        e = t->queue[t->head];
+        t->head = (t->head + 1) % t->len;
+        t->count--;
+        t->task(&e);
+        return true;
+    }
+
+    return false;
+}
+
+/* ==================================================
+ * SIMULATOR INTERFACE
+ * ================================================== */
+
+void sim_sdk_run(uint64_t now)
+{
+    while (timer_list != NULL && timer_list->timer_expire <= now) {
+        os_timer_t *t = timer_list;
+
+        timer_list = t->timer_next;
+        t->timer_next = NULL;
+
+        /* Re-arm before the call, which may disarm or re-arm it */
+        if (t->timer_period != 0) {
+            t->timer_expire += t->timer_period;
+            if (t->timer_expire <= now) {
+                t->timer_expire = now + t->timer_period;
+            }
+            timer_insert(t);
+        }
+        t->timer_func(t->timer_arg);
+    }
+
+    while (task_run_one()) {
+    }
+}
+
+uint64_t sim_sdk_next_us(void)
+{
+    return timer_list != NULL ? timer_list->timer_expire : SIM_NEVER;
+}
+
+void sim_sdk_init_done(void)
+{
+    if (init_done_cb != NULL) {
+        init_done_cb();
+    }
+}
+
+void sim_sdk_set_uart_console(bool on)
+{
+    console_uart = on;
+}
+
+/* ==================================================
+ * SYSTEM CALLS
+ * ================================================== */
+
+int os_printf(const char *fmt, ...)
+{
+    char text[512];
+    va_list ap;
+    int n;
+
+    va_start(ap, fmt);
+    n = vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+
+    if (n < 0) {
+        return n;
+    }
+    if (n >= (int)sizeof(text)) {
+        n = sizeof(text) - 1;
+    }
+
+    if (console_uart) {
+        sim_uart_console(text, n);
+    } else {
+        fputs(text, stderr);
+    }
+    return n;
+}
+
+void os_delay_us(uint32_t us)
+{
+    usleep(us);
+}
+
+uint32 system_get_time(void)
+{
+    return (uint32)sim_now_us();
+}
+
+uint32 system_get_free_heap_size(void)
+{
+    return SIM_FREE_HEAP;
+}
+
+void system_init_done_cb(init_done_cb_t cb)
+{
+    init_done_cb = cb;
+}
+
+bool system_partition_table_regist(const partition_item_t *table, uint32 num, uint32 map)
+{
+    return true;
+}
+
+enum flash_size_map system_get_flash_size_map(void)
+{
+    return FLASH_SIZE_8M_MAP_512_512;
+}
+
+void system_timer_reinit(void)
+{
+}
+
+void system_soft_wdt_feed(void)
+{
+}
+
+void system_phy_set_max_tpw(uint8 max_tpw)
+{
+}
+
+void uart_div_modify(uint8 uart_no, uint32 div)
+{
+}
@@ -0,0 +1,416 @@
+/* ==================================================
+ * Host Simulator: UART0
+ *
+ * Emulates the UART0 registers src/uart.c drives - the
+ * 128-byte RX and TX FIFOs, the FIFO counters and the
+ * RX-full / RX-timeout / TX-empty interrupts - so the
+ * real driver, ring buffers and frame tracker run
+ * unchanged. The far side of the line is a Linux
+ * pseudo-terminal: characters move between it and the
+ * FIFOs no faster than the baud rate set in CLKDIV
+ * (10 bits per character, 8N1), in both directions.
+ * The interrupt handler runs as soon as a FIFO crosses
+ * its threshold, even in the middle of a slice.
+ *
+ * Characters the line loses are counted and printed at
+ * exit: RX overruns (FIFO full when a character
+ * arrived) and TX bytes the PTY would not take.
+ * ================================================== */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "ets_sys.h"
+#include "eagle_soc.h"
+#include "user_interface.h"
+#include "driver/uart_register.h"
+
+/* Hardware FIFO depth (both directions) */
+#define SIM_FIFO_SIZE           128
+
+/* TX-empty interrupt while fewer characters than this are queued */
+#define SIM_TX_EMPTY_THRHD      16
+
+/* Characters are moved in slices, not one wake-up each */
+#define SIM_UART_SLICE_US       250
+
+/* Bytes read from the PTY ahead of the line */
+#define SIM_RX_STAGE_SIZE       4096
+
+/* ==================================================
+ * STATE
+ * ================================================== */
+
+static int pty_master = -1;
+static int pty_slave = -1;
+static char pty_link[256];
+
+/* Line rate (fixed: --baud overrides CLKDIV) */
+static uint32_t char_ns = 10000000000ULL / 115200;
+static bool char_ns_fixed = false;
+
+/* Characters lost on the line */
+static uint32_t rx_overrun_count = 0;
+static uint32_t pty_drop_count = 0;
+
+/* FIFOs */
+static uint8_t rx_fifo[SIM_FIFO_SIZE];
+static uint16_t rx_fifo_head = 0;
+static uint16_t rx_fifo_count = 0;
+static uint8_t tx_fifo[SIM_FIFO_SIZE];
+static uint16_t tx_fifo_head = 0;
+static uint16_t tx_fifo_count = 0;
+
+/* Registers */
+static uint32_t reg_int_ena = 0;
+static uint32_t reg_conf0 = 0;
+static uint32_t reg_conf1 = 0;
+static uint32_t reg_clkdiv = 0;
+
+/* Time the last character finished on each line (host ns), and
+ * whether the line ran dry since: only then does it restart at now */
+static uint64_t rx_next_ns = 0;
+static uint64_t tx_next_ns = 0;
+static bool rx_idle = true;
+static bool tx_idle = true;
+
+/* PTY input not yet on the line */
+static uint8_t rx_stage[SIM_RX_STAGE_SIZE];
+static uint16_t rx_stage_pos = 0;
+static uint16_t rx_stage_len = 0;
+
+/* Interrupt handler (ETS_UART_INTR_ATTACH) */
+static void (*intr_handler)(void *) = NULL;
+static void *intr_arg = NULL;
+static bool intr_enabled = false;
+
+/* ==================================================
+ * REGISTERS
+ * ================================================== */
+
+/**
+ * Raw interrupt status from the FIFO levels (level-triggered,
+ * so INT_CLR has nothing to clear)
+ */
+static uint32_t uart_int_raw(void)
+{
+    uint32_t raw = 0;
+    uint16_t full_thrhd = (reg_conf1 >> UART_RXFIFO_FULL_THRHD_S) & UART_RXFIFO_FULL_THRHD;
+
+    if (rx_fifo_count > 0 && rx_fifo_count >= full_thrhd) {
+        raw |= UART_RXFIFO_FULL_INT_ST;
+    }
+    if (rx_fifo_count > 0) {
+        raw |= UART_RXFIFO_TOUT_INT_ST;
+    }
+    if (tx_fifo_count < SIM_TX_EMPTY_THRHD) {
+        raw |= UART_TXFIFO_EMPTY_INT_ST;
+    }
+    return raw;
+}
+
+uint32_t sim_reg_read(uint32_t addr)
+{
+    uint8_t byte;
+
+    if (addr == UART_FIFO(0)) {
+        if (rx_fifo_count == 0) {
+            return 0;
+        }
+        byte = rx_fifo[rx_fifo_head];
+        rx_fifo_head = (rx_fifo_head + 1) % SIM_FIFO_SIZE;
+        rx_fifo_count--;
+        return byte;
+    }
+    if (addr == UART_INT_RAW(0)) {
+        return uart_int_raw();
+    }
+    if (addr == UART_INT_ST(0)) {
+        return uart_int_raw() & reg_int_ena;
+    }
+    if (addr == UART_INT_ENA(0)) {
+        return reg_int_ena;
+    }
+    if (addr == UART_STATUS(0)) {
+        return ((uint32_t)rx_fifo_count << UART_RXFIFO_CNT_S) |
+               ((uint32_t)tx_fifo_count << UART_TXFIFO_CNT_S);
+    }
+    if (addr == UART_CLKDIV(0)) {
+        return reg_clkdiv;
+    }
+    if (addr == UART_CONF0(0)) {
+        return reg_conf0;
+    }
+    if (addr == UART_CONF1(0)) {
+        return reg_conf1;
+    }
+    return 0;
+}
+
+void sim_reg_write(uint32_t addr, uint32_t value)
+{
+    if (addr == UART_FIFO(0)) {
+        /* A full FIFO drops the character, as the hardware does */
+        if (tx_fifo_count < SIM_FIFO_SIZE) {
+            tx_fifo[(tx_fifo_head + tx_fifo_count) % SIM_FIFO_SIZE] = value & 0xFF;
+            tx_fifo_count++;
+        }
+    } else if (addr == UART_INT_ENA(0)) {
+        reg_int_ena = value;
+    } else if (addr == UART_CLKDIV(0)) {
+        reg_clkdiv = value & UART_CLKDIV_CNT;
+        if (reg_clkdiv != 0 && !char_ns_fixed) {
+            char_ns = 10ULL * 1000000000ULL * reg_clkdiv / UART_CLK_FREQ;
+        }
+    } else if (addr == UART_CONF0(0)) {
+        reg_conf0 = value;
+    } else if (addr == UART_CONF1(0)) {
+        reg_conf1 = value;
+    }
+}
+
+void sim_uart_intr_attach(void (*handler)(void *), void *arg)
+{
+    intr_handler = handler;
+    intr_arg = arg;
+}
+
+void sim_uart_intr_enable(bool enable)
+{
+    intr_enabled = enable;
+}
+
+/* ==================================================
+ * LINE
+ * ================================================== */
+
+/**
+ * Run the interrupt handler while an enabled interrupt is pending
+ * (bounded: a handler that cannot clear its cause must not hang us)
+ */
+static void uart_dispatch(void)
+{
+    uint8_t rounds;
+
+    for (rounds = 0; rounds < 4; rounds++) {
+        if (!intr_enabled || intr_handler == NULL || (uart_int_raw() & reg_int_ena) == 0) {
+            return;
+        }
+        intr_handler(intr_arg);
+    }
+}
+
+/**
+ * Pass line output to the PTY
+ */
+static void uart_pty_write(const uint8_t *out, uint16_t n)
+{
+    ssize_t put = write(pty_master, out, n);
+
+    /* Nobody reading and the PTY buffer full: the bytes are gone,
+     * as they would be on a wire with nothing attached */
+    if (put < 0) {
+        if (errno != EAGAIN && errno != EIO) {
+            perror("sim: pty write");
+        }
+        put = 0;
+    }
+    pty_drop_count += n - put;
+}
+
+/**
+ * Shift characters out of the TX FIFO to the PTY up to now
+ */
+static void uart_line_tx(uint64_t now_ns)
+{
+    uint8_t out[SIM_FIFO_SIZE];
+    uint16_t n = 0;
+
+    if (tx_fifo_count == 0) {
+        return;
+    }
+
+    /* Idle line: the first character starts now, not in the past.
+     * A busy line that fell behind (late wake-up) catches up instead */
+    if (tx_idle && tx_next_ns + char_ns < now_ns) {
+        tx_next_ns = now_ns - char_ns;
+    }
+    tx_idle = false;
+
+    while (tx_fifo_count > 0 && tx_next_ns + char_ns <= now_ns) {
+        out[n++] = tx_fifo[tx_fifo_head];
+        tx_fifo_head = (tx_fifo_head + 1) % SIM_FIFO_SIZE;
+        tx_fifo_count--;
+        tx_next_ns += char_ns;
+
+        if (n == sizeof(out)) {
+            uart_pty_write(out, n);
+            n = 0;
+        }
+        /* TX-empty interrupt refills the FIFO while the line runs */
+        if (tx_fifo_count == SIM_TX_EMPTY_THRHD - 1) {
+            uart_dispatch();
+        }
+    }
+
+    if (n > 0) {
+        uart_pty_write(out, n);
+    }
+    tx_idle = (tx_fifo_count == 0);
+}
+
+/**
+ * Shift characters from the PTY into the RX FIFO up to now
+ */
+static void uart_line_rx(uint64_t now_ns)
+{
+    uint16_t full_thrhd = (reg_conf1 >> UART_RXFIFO_FULL_THRHD_S) & UART_RXFIFO_FULL_THRHD;
+    ssize_t got;
+
+    if (rx_stage_pos == rx_stage_len) {
+        rx_stage_pos = 0;
+        rx_stage_len = 0;
+        got = read(pty_master, rx_stage, sizeof(rx_stage));
+        if (got > 0) {
+            rx_stage_len = got;
+        }
+    }
+
+    if (rx_stage_pos == rx_stage_len) {
+        rx_idle = true;
+        return;
+    }
+
+    if (rx_idle && rx_next_ns + char_ns < now_ns) {
+        rx_next_ns = now_ns - char_ns;
+    }
+    rx_idle = false;
+
+    /* A full FIFO loses the character (overrun) */
+    while (rx_stage_pos < rx_stage_len && rx_next_ns + char_ns <= now_ns) {
+        if (rx_fifo_count < SIM_FIFO_SIZE) {
+            rx_fifo[(rx_fifo_head + rx_fifo_count) % SIM_FIFO_SIZE] = rx_stage[rx_stage_pos];
+            rx_fifo_count++;
+        } else {
+            rx_overrun_count++;
+        }
+        rx_stage_pos++;
+        rx_next_ns += char_ns;
+
+        /* RX-full interrupt empties the FIFO while the line runs */
+        if (rx_fifo_count == full_thrhd) {
+            uart_dispatch();
+        }
+    }
+}
+
+/* ==================================================
+ * SIMULATOR INTERFACE
+ * ================================================== */
+
+bool sim_uart_open(const char *link_path)
+{
+    struct termios tio;
+    const char *name;
+
+    pty_master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (pty_master < 0 || grantpt(pty_master) != 0 || unlockpt(pty_master) != 0) {
+        perror("sim: posix_openpt");
+        return false;
+    }
+
+    name = ptsname(pty_master);
+
+    /* Hold the slave open so the master never sees a hangup
+     * between clients, and make it raw: binary frames must
+     * pass the line discipline untouched */
+    pty_slave = open(name, O_RDWR | O_NOCTTY);
+    if (pty_slave < 0 || tcgetattr(pty_slave, &tio) != 0) {
+        perror("sim: pty slave");
+        return false;
+    }
+    cfmakeraw(&tio);
+    tcsetattr(pty_slave, TCSANOW, &tio);
+
+    if (link_path != NULL) {
+        unlink(link_path);
+        if (symlink(name, link_path) != 0) {
+            perror("sim: symlink");
+            return false;
+        }
+        snprintf(pty_link, sizeof(pty_link), "%s", link_path);
+    }
+
+    fprintf(stderr, "sim: UART0 on %s%s%s\n", name,
+            link_path ? " -> " : "", link_path ? link_path : "");
+    return true;
+}
+
+void sim_uart_set_baud(uint32_t baud)
+{
+    char_ns = 10000000000ULL / baud;
+    char_ns_fixed = true;
+}
+
+void sim_uart_close(void)
+{
+    if (pty_link[0] != '\0') {
+        unlink(pty_link);
+    }
+    fprintf(stderr, "sim: UART0 rx_overrun=%u pty_drop=%u\n", rx_overrun_count, pty_drop_count);
+}
+
+int sim_uart_fd(void)
+{
+    return pty_master;
+}
+
+void sim_uart_service(uint64_t now)
+{
+    uint64_t now_ns = now * 1000;
+
+    uart_line_rx(now_ns);
+    uart_dispatch();
+    uart_line_tx(now_ns);
+    uart_dispatch();
+}
+
+uint64_t sim_uart_next_us(void)
+{
+    uint64_t next = SIM_NEVER;
+
+    if (tx_fifo_count > 0) {
+        next = (tx_next_ns + char_ns) / 1000;
+    }
+    if (rx_stage_pos < rx_stage_len && (rx_next_ns + char_ns) / 1000 < next) {
+        next = (rx_next_ns + char_ns) / 1000;
+    }
+    if (next != SIM_NEVER) {
+        next += SIM_UART_SLICE_US;
+    }
+    return next;
+}
+
+void sim_uart_console(const char *text, uint16_t len)
+{
+    struct timespec pause = { 0, 0 };
+    uint16_t i;
+
+    for (i = 0; i < len; i++) {
+        /* The SDK's character output spins until the FIFO has room */
+        while (tx_fifo_count == SIM_FIFO_SIZE) {
+            pause.tv_nsec = char_ns;
+            nanosleep(&pause, NULL);
+            uart_line_tx(sim_now_us() * 1000);
+        }
+        sim_reg_write(UART_FIFO(0), (uint8_t)text[i]);
+    }
+}
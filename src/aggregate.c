@@ -0,0 +1,282 @@
+/* ==================================================
+ * Frame Aggregation Implementation
+ *
+ * On-air payload format (AGG_ENABLED=1):
+ *   [LEN_HI][LEN_LO][payload][LEN_HI][LEN_LO][payload]...
+ * Each record is exactly a UART frame, so RX delivery is a
+ * validated copy with no re-framing.
+ * ================================================== */
+
+#include "aggregate.h"
+#include "user_config.h"
+#include "wifi_raw.h"
+#include "uart.h"
+#include "ctrl.h"
+#include "latency.h"
+#include "rates.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+#if AGG_MAX_PAYLOAD > MAX_AIR_PAYLOAD_SIZE
+#error "AGG_MAX_PAYLOAD must not exceed MAX_AIR_PAYLOAD_SIZE (RX capture)"
+#endif
+
+/* The FHSS/TDMA sync fields come out of the same capture */
+#if MAX_AIR_PAYLOAD_SIZE < 64
+#error "FHSS/TDMA sync fields leave under 64 payload bytes in the RX capture"
+#endif
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+/* Pending 802.11 payload being packed */
+static uint8_t agg_buffer[MAX_AIR_PAYLOAD_SIZE];
+static uint16_t agg_len = 0;
+
+/* system_get_time() when the first record was packed */
+static uint32_t agg_start_us = 0;
+
+/* Highest traffic class packed so far (priority skips the hold) */
+static uint8_t agg_class = TC_BULK;
+
+/* Link the packed frame goes out on (one BSSID per 802.11 frame) */
+static uint8_t agg_link = 0;
+
+/* User records packed so far (local records not counted) */
+static uint8_t agg_records = 0;
+
+/* Statistics */
+static uint32_t agg_tx_frame_count = 0;
+static uint32_t agg_tx_lost_count = 0;
+static uint32_t agg_rx_frame_count = 0;
+static uint32_t agg_rx_malformed_count = 0;
+
+/* ==================================================
+ * TX PATH
+ * ================================================== */
+
+void agg_init(void)
+{
+    agg_len = 0;
+    agg_start_us = 0;
+    agg_records = 0;
+    agg_reset_stats();
+}
+
+bool agg_flush(void)
+{
+    if (agg_len == 0) {
+        return true;
+    }
+
+    /* Keep the packed frame if the radio is still sending */
+    if (!wifi_raw_tx_ready()) {
+        return false;
+    }
+
+    LAT_US(LAT_AGG_HOLD, system_get_time() - agg_start_us);
+    if (wifi_raw_send(agg_buffer, agg_len, agg_class, agg_link, true) == 0) {
+        agg_tx_frame_count += agg_records;
+    } else if (agg_records > 0) {
+        /* wifi_raw_send() traced the failure and counted one drop;
+         * every record packed into the frame is lost with it */
+        agg_tx_lost_count += agg_records;
+        RATE_ADD(RATE_DROPS, agg_records - 1);
+    }
+    agg_len = 0;
+    agg_records = 0;
+    agg_class = TC_BULK;
+    return true;
+}
+
+bool agg_submit(uint8_t tclass, uint8_t link, const uint8_t *frame, uint16_t len)
+{
+#if AGG_ENABLED
+    uint16_t record_len = AGG_RECORD_HEADER_SIZE + len;
+
+    /* Flush first if this record would overflow the pack limit
+     * or is for another link */
+    if (agg_len > 0 && (agg_len + record_len > AGG_MAX_PAYLOAD || link != agg_link)) {
+        if (!agg_flush()) {
+            return false;
+        }
+    }
+
+    if (agg_len == 0) {
+        agg_start_us = system_get_time();
+        agg_link = link;
+    }
+
+    /* Append record (oversize frames go out alone) */
+    agg_buffer[agg_len]     = ((len >> 8) & 0xFF) | UART_CLASS_FLAGS(tclass);
+    agg_buffer[agg_len + 1] = len & 0xFF;
+    os_memcpy(agg_buffer + agg_len + AGG_RECORD_HEADER_SIZE, frame, len);
+    agg_len += record_len;
+    agg_records++;
+
+    if (tclass > agg_class) {
+        agg_class = tclass;
+    }
+
+    /* No room for even a 1-byte record - send without waiting */
+    if (agg_len + AGG_RECORD_HEADER_SIZE + 1 > AGG_MAX_PAYLOAD) {
+        agg_flush();
+    }
+
+    return true;
+#else
+    if (!wifi_raw_tx_ready()) {
+        return false;
+    }
+
+    if (wifi_raw_send(frame, len, tclass, link, true) == 0) {
+        agg_tx_frame_count++;
+    } else {
+        agg_tx_lost_count++;
+    }
+    return true;
+#endif
+}
+
+bool agg_submit_local(uint8_t link, const uint8_t *msg, uint16_t len)
+{
+#if AGG_ENABLED
+    uint16_t record_len = AGG_RECORD_HEADER_SIZE + len;
+
+    /* Piggyback only - never forces a flush of pending user frames,
+     * so a frame pending for another link makes the caller wait */
+    if (len == 0 || agg_len + record_len > AGG_MAX_PAYLOAD ||
+        (agg_len > 0 && link != agg_link)) {
+        return false;
+    }
+
+    if (agg_len == 0) {
+        agg_start_us = system_get_time();
+        agg_link = link;
+    }
+
+    agg_buffer[agg_len]     = ((len >> 8) & 0xFF) | UART_LEN_LOCAL_BIT;
+    agg_buffer[agg_len + 1] = len & 0xFF;
+    os_memcpy(agg_buffer + agg_len + AGG_RECORD_HEADER_SIZE, msg, len);
+    agg_len += record_len;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void agg_poll(void)
+{
+    if (agg_len == 0) {
+        return;
+    }
+
+    /* Priority frames never wait for more records */
+    if (agg_class == TC_PRIORITY ||
+        (system_get_time() - agg_start_us) >= AGG_HOLD_TIME_US) {
+        agg_flush();
+    }
+}
+
+/* ==================================================
+ * RX PATH
+ * ================================================== */
+
+int agg_deliver(const uint8_t *payload, uint16_t len, uint8_t tclass, uint8_t link,
+                const uint8_t *meta, uint8_t meta_len)
+{
+#if AGG_ENABLED
+    uint16_t pos = 0;
+    int frames = 0;
+
+    /* An empty aggregate carries nothing: not a valid frame */
+    if (len == 0) {
+        agg_rx_malformed_count++;
+        return -1;
+    }
+
+    /* Validate every record before writing any, so a corrupt
+     * aggregate never desyncs the UART stream mid-way */
+    while (pos < len) {
+        uint16_t rec_len;
+
+        if (len - pos < AGG_RECORD_HEADER_SIZE + 1) {
+            agg_rx_malformed_count++;
+            return -1;
+        }
+
+        rec_len = UART_FRAME_LEN(payload[pos], payload[pos + 1]);
+        if (rec_len == 0 || rec_len > MAX_PACKET_SIZE ||
+            rec_len > len - pos - AGG_RECORD_HEADER_SIZE) {
+            agg_rx_malformed_count++;
+            return -1;
+        }
+
+        pos += AGG_RECORD_HEADER_SIZE + rec_len;
+    }
+
+    /* Local records are for this ESP; the rest go to their class's
+     * UART ring, tagged with the link they arrived on */
+    for (pos = 0; pos < len; ) {
+        uint8_t flags = payload[pos];
+        uint16_t rec_len = UART_FRAME_LEN(flags, payload[pos + 1]);
+        const uint8_t *rec = payload + pos + AGG_RECORD_HEADER_SIZE;
+
+        if (UART_FRAME_IS_LOCAL(flags)) {
+            ctrl_air_rx(rec, rec_len, link);
+        } else {
+            uart_write_frame_trailer((flags & UART_LEN_CLASS_BIT) | UART_LINK_FLAGS(link),
+                                     rec, rec_len, meta, meta_len);
+            frames++;
+        }
+        pos += AGG_RECORD_HEADER_SIZE + rec_len;
+    }
+
+    agg_rx_frame_count += frames;
+    return frames;
+#else
+    if (len == 0 || len > MAX_PACKET_SIZE) {
+        agg_rx_malformed_count++;
+        return -1;
+    }
+
+    /* Protocol: [LEN_HI][LEN_LO][payload...] */
+    uart_write_frame_trailer(UART_CLASS_FLAGS(tclass) | UART_LINK_FLAGS(link),
+                             payload, len, meta, meta_len);
+    agg_rx_frame_count++;
+    return 1;
+#endif
+}
+
+/* ==================================================
+ * STATISTICS
+ * ================================================== */
+
+uint32_t agg_get_tx_frame_count(void)
+{
+    return agg_tx_frame_count;
+}
+
+uint32_t agg_get_tx_lost_count(void)
+{
+    return agg_tx_lost_count;
+}
+
+uint32_t agg_get_rx_frame_count(void)
+{
+    return agg_rx_frame_count;
+}
+
+uint32_t agg_get_rx_malformed_count(void)
+{
+    return agg_rx_malformed_count;
+}
+
+void agg_reset_stats(void)
+{
+    agg_tx_frame_count = 0;
+    agg_tx_lost_count = 0;
+    agg_rx_frame_count = 0;
+    agg_rx_malformed_count = 0;
+}
@@ -0,0 +1,115 @@
+/* ==================================================
+ * Frame Aggregation Stage
+ * Packs several length-prefixed UART frames into one
+ * 802.11 frame (TX) and splits them back out (RX)
+ * ================================================== */
+
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Initialize aggregation state
+ */
+void agg_init(void);
+
+/**
+ * Submit one complete UART frame for transmission
+ * Appends to the pending 802.11 frame, flushing first if it
+ * would not fit or is for another link. With AGG_ENABLED=0 the
+ * frame is sent directly. A priority frame is sent without waiting
+ * for the hold time.
+ *
+ * @param tclass: TC_BULK or TC_PRIORITY
+ * @param link: Link ID (selects the BSSID)
+ * @param frame: Payload bytes (without length prefix)
+ * @param len: Payload length (1..MAX_BRIDGE_PACKET_SIZE)
+ * @return: true if accepted, false if TX busy (retry later)
+ */
+bool agg_submit(uint8_t tclass, uint8_t link, const uint8_t *frame, uint16_t len);
+
+/**
+ * Add a local record for the peer ESP (not forwarded to its UART)
+ * Rides along with pending user frames; if nothing else is pending
+ * it goes out on its own at the next agg_poll().
+ *
+ * @param link: Link ID of the peer the record is for
+ * @param msg: Local message ([type][data...])
+ * @param len: Message length
+ * @return: true if packed, false if no room, a frame for another
+ *          link is pending, or AGG_ENABLED=0
+ */
+bool agg_submit_local(uint8_t link, const uint8_t *msg, uint16_t len);
+
+/**
+ * Flush the pending frame once the hold time has expired
+ * (or at once if it holds a priority frame).
+ * Call periodically from the main timer.
+ */
+void agg_poll(void);
+
+/**
+ * Send the pending frame now (no-op if empty)
+ *
+ * @return: true if nothing is pending afterwards
+ */
+bool agg_flush(void);
+
+/**
+ * Split a received 802.11 payload into UART frames
+ * Writes each record as [LEN_HI][LEN_LO][payload] to the UART
+ * ring of its traffic class, with the link ID in LEN_HI.
+ * Local records go to ctrl_air_rx().
+ *
+ * @param payload: 802.11 payload (after MAC header)
+ * @param len: Payload length
+ * @param tclass: Class from the 802.11 header (used when AGG_ENABLED=0)
+ * @param link: Link the frame was received on
+ * @param meta: RX metadata appended to every UART frame (NULL = none)
+ * @param meta_len: Metadata length
+ * @return: Number of UART frames written, -1 if malformed
+ */
+int agg_deliver(const uint8_t *payload, uint16_t len, uint8_t tclass, uint8_t link,
+                const uint8_t *meta, uint8_t meta_len);
+
+/**
+ * Get number of UART frames sent on air
+ * Counted when their 802.11 frame is injected, not when packed.
+ *
+ * @return: Frames sent since init
+ */
+uint32_t agg_get_tx_frame_count(void);
+
+/**
+ * Get number of UART frames lost with a rejected injection
+ * (for example a link deleted while they were packed)
+ *
+ * @return: Frames lost since init
+ */
+uint32_t agg_get_tx_lost_count(void);
+
+/**
+ * Get number of UART frames delivered from RX
+ *
+ * @return: Frames split out since init
+ */
+uint32_t agg_get_rx_frame_count(void);
+
+/**
+ * Get malformed aggregate count (diagnostic)
+ *
+ * @return: Received payloads with an invalid record
+ */
+uint32_t agg_get_rx_malformed_count(void);
+
+/**
+ * Reset statistics counters
+ */
+void agg_reset_stats(void);
+
+#endif /* AGGREGATE_H */
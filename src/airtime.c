@@ -0,0 +1,219 @@
+/* ==================================================
+ * Airtime Estimation Implementation
+ * ================================================== */
+
+#include "airtime.h"
+#include "user_config.h"
+#include "user_interface.h"
+
+/* ==================================================
+ * RATE TABLE
+ * ================================================== */
+
+/* Received frames: data rate in units of 500 kbps, indexed by the
+ * RxControl.rate code (0-3 = 802.11b, 8-15 = 802.11g OFDM) */
+static const uint8_t rx_rate_500kbps[16] = {
+    2, 4, 11, 22, 0, 0, 0, 0,
+    96, 48, 24, 12, 108, 72, 36, 18
+};
+
+/* ==================================================
+ * CONFIGURATION CHECK
+ * ================================================== */
+
+/* LINK_PACKET_RATE_HZ full-size air frames against the capacity
+ * model. A note, not an error: the budget and TX queue still cope,
+ * by dropping. */
+#define AIRTIME_CFG_CYCLE_US    AIRTIME_TX_CYCLE_US(WIFI_TX_RATE, AIR_SYNC_SIZE + MAX_AIR_PAYLOAD_SIZE)
+#define AIRTIME_CFG_XSTR(x)     #x
+#define AIRTIME_CFG_STR(x)      AIRTIME_CFG_XSTR(x)
+
+#if LINK_PACKET_RATE_HZ > 0
+#if LINK_PACKET_RATE_HZ * AIRTIME_CFG_CYCLE_US > 1000000
+#pragma message("capacity: LINK_PACKET_RATE_HZ=" AIRTIME_CFG_STR(LINK_PACKET_RATE_HZ) \
+                " full-size frames" \
+                " do not fit the channel at WIFI_TX_RATE")
+#elif AIRTIME_BUDGET_ENABLED && LINK_PACKET_RATE_HZ * AIRTIME_CFG_CYCLE_US > AIRTIME_BUDGET_PERMILLE * 1000
+#pragma message("capacity: LINK_PACKET_RATE_HZ=" AIRTIME_CFG_STR(LINK_PACKET_RATE_HZ) \
+                " full-size frames" \
+                " exceed AIRTIME_BUDGET_PERMILLE=" AIRTIME_CFG_STR(AIRTIME_BUDGET_PERMILLE))
+#endif
+#endif
+
+/* ==================================================
+ * BUDGET STATE
+ * ================================================== */
+
+static int32_t budget_tokens = AIRTIME_BUDGET_BURST_US;
+static uint32_t budget_last_us = 0;
+
+/* Statistics */
+static uint32_t budget_used_us = 0;
+static uint32_t budget_drop_count[TC_COUNT];
+static uint32_t budget_defer_count[TC_COUNT];
+
+/* Capacity model check */
+static struct airtime_model_stats model_stats;
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+uint32_t airtime_frame_us_at(uint8_t rate, uint16_t payload_len)
+{
+    if (rate > PHY_RATE_11M_S) {
+        rate = PHY_RATE_1M_L;
+    }
+
+    return AIRTIME_FRAME_US(rate, (uint32_t)payload_len);
+}
+
+uint32_t airtime_frame_us(uint16_t payload_len)
+{
+    return airtime_frame_us_at(WIFI_TX_RATE, payload_len);
+}
+
+uint32_t airtime_tx_cycle_us_at(uint8_t rate, uint16_t payload_len)
+{
+    return AIRTIME_ACCESS_US + airtime_frame_us_at(rate, payload_len);
+}
+
+uint32_t airtime_max_fps_at(uint8_t rate, uint16_t payload_len)
+{
+    return 1000000 / airtime_tx_cycle_us_at(rate, payload_len);
+}
+
+uint32_t airtime_goodput_bps_at(uint8_t rate, uint16_t payload_len)
+{
+    return (uint32_t)((uint64_t)payload_len * 8 * 1000000 / airtime_tx_cycle_us_at(rate, payload_len));
+}
+
+void airtime_model_note(uint16_t payload_len, uint32_t measured_us)
+{
+    uint32_t model_us = airtime_tx_cycle_us_at(WIFI_TX_RATE, payload_len);
+
+    model_stats.frames++;
+    if (measured_us > model_us * AIRTIME_MODEL_LATE_FACTOR) {
+        model_stats.late++;
+        return;
+    }
+    model_stats.model_us += model_us;
+    model_stats.measured_us += measured_us;
+}
+
+const struct airtime_model_stats *airtime_model_get_stats(void)
+{
+    return &model_stats;
+}
+
+uint32_t airtime_rx_frame_us(uint8_t rx_rate, uint16_t mpdu_len)
+{
+    uint32_t rate = rx_rate_500kbps[rx_rate & 0x0F];
+    uint32_t bits = (uint32_t)mpdu_len * 8;
+
+    if (rate == 0) {
+        rate = 2;   /* Unknown code: assume 1 Mbps (worst case) */
+    }
+
+    if (rx_rate >= 8) {
+        /* OFDM: 20 us preamble, 4 us symbols of 2 bits per 500 kbps,
+         * 16 service + 6 tail bits */
+        return AIRTIME_OFDM_PREAMBLE_US + 4 * ((bits + 22 + rate * 2 - 1) / (rate * 2));
+    }
+
+    /* DSSS: assume the long preamble */
+    return AIRTIME_PLCP_LONG_US + (bits * 2 + rate - 1) / rate;
+}
+
+/* ==================================================
+ * AIRTIME BUDGET
+ * ================================================== */
+
+void airtime_budget_init(void)
+{
+    budget_tokens = AIRTIME_BUDGET_BURST_US;
+    budget_last_us = system_get_time();
+    airtime_budget_reset_stats();
+}
+
+bool airtime_budget_ok(void)
+{
+#if AIRTIME_BUDGET_ENABLED
+    uint32_t now = system_get_time();
+    uint32_t elapsed = now - budget_last_us;
+    uint32_t credit;
+
+    /* Long idle just means a full bucket - avoid overflow below */
+    if (elapsed > 1000000) {
+        budget_last_us = now - 1000000;
+        elapsed = 1000000;
+    }
+
+    /* Advance the clock only by the time actually credited, so frequent
+     * calls don't lose the fractional remainder */
+    credit = elapsed * AIRTIME_BUDGET_PERMILLE / 1000;
+    budget_last_us += credit * 1000 / AIRTIME_BUDGET_PERMILLE;
+    budget_tokens += (int32_t)credit;
+
+    if (budget_tokens >= AIRTIME_BUDGET_BURST_US) {
+        budget_tokens = AIRTIME_BUDGET_BURST_US;
+        budget_last_us = now;
+    }
+
+    return budget_tokens > 0;
+#else
+    return true;
+#endif
+}
+
+void airtime_budget_charge(uint32_t airtime_us)
+{
+    budget_used_us += airtime_us;
+#if AIRTIME_BUDGET_ENABLED
+    budget_tokens -= (int32_t)airtime_us;
+#endif
+}
+
+void airtime_budget_note_over(uint8_t tclass, bool dropped)
+{
+    if (tclass >= TC_COUNT) {
+        return;
+    }
+
+    if (dropped) {
+        budget_drop_count[tclass]++;
+    } else {
+        budget_defer_count[tclass]++;
+    }
+}
+
+int32_t airtime_budget_tokens(void)
+{
+    return budget_tokens;
+}
+
+uint32_t airtime_budget_get_used_us(void)
+{
+    return budget_used_us;
+}
+
+uint32_t airtime_budget_get_drop_count(uint8_t tclass)
+{
+    return (tclass < TC_COUNT) ? budget_drop_count[tclass] : 0;
+}
+
+uint32_t airtime_budget_get_defer_count(uint8_t tclass)
+{
+    return (tclass < TC_COUNT) ? budget_defer_count[tclass] : 0;
+}
+
+void airtime_budget_reset_stats(void)
+{
+    uint8_t tc;
+
+    budget_used_us = 0;
+    for (tc = 0; tc < TC_COUNT; tc++) {
+        budget_drop_count[tc] = 0;
+        budget_defer_count[tc] = 0;
+    }
+}
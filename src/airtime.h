@@ -0,0 +1,213 @@
+/* ==================================================
+ * Airtime Estimation
+ * On-air duration of injected 802.11b frames, and the
+ * channel capacity model built on it
+ * ================================================== */
+
+#ifndef AIRTIME_H
+#define AIRTIME_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * 802.11b PHY TIMING
+ * ================================================== */
+
+#define AIRTIME_PLCP_LONG_US    192         /* Long preamble + PLCP header */
+#define AIRTIME_PLCP_SHORT_US   96          /* Short preamble + PLCP header */
+#define AIRTIME_FCS_SIZE        4           /* Frame check sequence */
+#define AIRTIME_OFDM_PREAMBLE_US 20         /* 802.11g preamble + SIGNAL */
+
+/* Channel access before every frame (DCF). Injected frames are
+ * broadcast, so there is no ACK and the contention window stays
+ * at CWmin: an idle channel costs DIFS plus CWmin/2 slots on
+ * average before the preamble starts. */
+#define AIRTIME_SLOT_US         20
+#define AIRTIME_DIFS_US         50          /* SIFS + 2 slots */
+#define AIRTIME_CW_MIN          31
+#define AIRTIME_ACCESS_US       (AIRTIME_DIFS_US + AIRTIME_CW_MIN * AIRTIME_SLOT_US / 2)
+
+/* ==================================================
+ * CAPACITY MODEL (also usable in #if)
+ * ================================================== */
+
+/* Data rate in units of 100 kbps of a PHY_RATE_* identifier */
+#define AIRTIME_RATE_100KBPS(rate) \
+    ((rate) == PHY_RATE_1M_L ? 10 : (rate) == PHY_RATE_2M_L ? 20 : \
+     (rate) == PHY_RATE_5M_S ? 55 : 110)
+
+/* 1M/2M use the long preamble, 5.5M/11M the short one */
+#define AIRTIME_PLCP_US(rate) \
+    ((rate) <= PHY_RATE_2M_L ? AIRTIME_PLCP_LONG_US : AIRTIME_PLCP_SHORT_US)
+
+/* PLCP + MAC header + payload + FCS, rounded up to whole microseconds */
+#define AIRTIME_FRAME_US(rate, payload_len) \
+    (AIRTIME_PLCP_US(rate) + \
+     ((IEEE80211_HEADER_SIZE + (payload_len) + AIRTIME_FCS_SIZE) * 80 + \
+      AIRTIME_RATE_100KBPS(rate) - 1) / AIRTIME_RATE_100KBPS(rate))
+
+/* Send to TX-complete on an idle channel: channel access + frame.
+ * Back to back, this is also the interval between completions. */
+#define AIRTIME_TX_CYCLE_US(rate, payload_len) \
+    (AIRTIME_ACCESS_US + AIRTIME_FRAME_US(rate, payload_len))
+
+/* A measured TX cycle this many times the model is counted as late
+ * (channel busy, or the SDK held the frame) and kept out of the fit */
+#define AIRTIME_MODEL_LATE_FACTOR 2
+
+/**
+ * Capacity model check: measured TX cycles against the model
+ * Counters run freely and wrap; compare two readings.
+ */
+struct airtime_model_stats {
+    uint32_t frames;            /* TX completions compared */
+    uint32_t model_us;          /* Sum of modeled TX cycles */
+    uint32_t measured_us;       /* Sum of measured TX cycles */
+    uint32_t late;              /* Frames over AIRTIME_MODEL_LATE_FACTOR (not summed) */
+};
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * On-air time of one frame at a given rate
+ * Covers PLCP preamble/header, 802.11 MAC header, payload and FCS
+ *
+ * @param rate: PHY_RATE_* identifier from user_config.h
+ * @param payload_len: 802.11 payload length (bytes after MAC header)
+ * @return: Frame duration in microseconds
+ */
+uint32_t airtime_frame_us_at(uint8_t rate, uint16_t payload_len);
+
+/**
+ * On-air time of one frame at the configured WIFI_TX_RATE
+ *
+ * @param payload_len: 802.11 payload length
+ * @return: Frame duration in microseconds
+ */
+uint32_t airtime_frame_us(uint16_t payload_len);
+
+/**
+ * Send to TX-complete time of one frame on an idle channel
+ * (channel access + frame)
+ *
+ * @param rate: PHY_RATE_* identifier
+ * @param payload_len: 802.11 payload length
+ * @return: Microseconds
+ */
+uint32_t airtime_tx_cycle_us_at(uint8_t rate, uint16_t payload_len);
+
+/**
+ * Most frames per second one sender can put on an idle channel
+ *
+ * @param rate: PHY_RATE_* identifier
+ * @param payload_len: 802.11 payload length
+ * @return: Frames per second
+ */
+uint32_t airtime_max_fps_at(uint8_t rate, uint16_t payload_len);
+
+/**
+ * Payload throughput at airtime_max_fps_at()
+ *
+ * @param rate: PHY_RATE_* identifier
+ * @param payload_len: 802.11 payload length
+ * @return: Payload bits per second
+ */
+uint32_t airtime_goodput_bps_at(uint8_t rate, uint16_t payload_len);
+
+/**
+ * Compare one measured TX cycle with the model
+ * Called from the TX-complete callback.
+ *
+ * @param payload_len: 802.11 payload length of the frame
+ * @param measured_us: wifi_send_pkt_freedom() to TX-complete
+ */
+void airtime_model_note(uint16_t payload_len, uint32_t measured_us);
+
+/**
+ * Get capacity model check counters
+ *
+ * @return: Pointer to the counters
+ */
+const struct airtime_model_stats *airtime_model_get_stats(void);
+
+/**
+ * On-air time of a received frame (any sender, 802.11b or g)
+ *
+ * @param rx_rate: RxControl.rate code
+ * @param mpdu_len: RxControl.legacy_length (MAC header to FCS)
+ * @return: Frame duration in microseconds
+ */
+uint32_t airtime_rx_frame_us(uint8_t rx_rate, uint16_t mpdu_len);
+
+/* ==================================================
+ * AIRTIME BUDGET (TOKEN BUCKET)
+ * ================================================== */
+
+/**
+ * Initialize budget (bucket starts full)
+ */
+void airtime_budget_init(void);
+
+/**
+ * Check whether a frame may be injected now
+ * Refills the bucket from elapsed time first. Tokens may go
+ * negative after a large frame; further frames wait until
+ * the debt is paid back.
+ *
+ * @return: true if tokens are available (always true if disabled)
+ */
+bool airtime_budget_ok(void);
+
+/**
+ * Charge an injected bridge frame against the budget
+ *
+ * @param airtime_us: On-air duration of the frame
+ */
+void airtime_budget_charge(uint32_t airtime_us);
+
+/**
+ * Record a frame held back or dropped for lack of budget
+ *
+ * @param tclass: Traffic class of the frame
+ * @param dropped: true if dropped, false if left queued
+ */
+void airtime_budget_note_over(uint8_t tclass, bool dropped);
+
+/**
+ * Get current bucket level
+ *
+ * @return: Tokens in microseconds (negative = in debt)
+ */
+int32_t airtime_budget_tokens(void);
+
+/**
+ * Get total airtime charged
+ *
+ * @return: Microseconds charged since init
+ */
+uint32_t airtime_budget_get_used_us(void);
+
+/**
+ * Get over-budget drop count
+ *
+ * @param tclass: Traffic class
+ * @return: Frames dropped for lack of budget
+ */
+uint32_t airtime_budget_get_drop_count(uint8_t tclass);
+
+/**
+ * Get over-budget deferral count
+ *
+ * @param tclass: Traffic class
+ * @return: Times a frame was left queued for lack of budget
+ */
+uint32_t airtime_budget_get_defer_count(uint8_t tclass);
+
+/**
+ * Reset statistics counters (bucket level is kept)
+ */
+void airtime_budget_reset_stats(void);
+
+#endif /* AIRTIME_H */
@@ -0,0 +1,863 @@
+/* ==================================================
+ * Local Control Channel Implementation
+ * ================================================== */
+
+#include "ctrl.h"
+#include "user_config.h"
+#include "uart.h"
+#include "txpower.h"
+#include "wifi_raw.h"
+#include "links.h"
+#include "linkq.h"
+#include "survey.h"
+#include "fhss.h"
+#include "tdma.h"
+#include "latency.h"
+#include "trace.h"
+#include "ping.h"
+#include "trafgen.h"
+#include "sniffer.h"
+#include "airtime.h"
+#include "txq.h"
+#include "hwm.h"
+#include "rates.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+/* Response assembly buffer */
+static uint8_t ctrl_response[CTRL_MAX_RESPONSE];
+
+/* Trace records per GET_TRACE response (after the 9-byte page header) */
+#define CTRL_TRACE_PAGE         ((CTRL_MAX_RESPONSE - 2 - 9) / TRACE_RECORD_SIZE)
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+uint8_t *ctrl_put_u16(uint8_t *buf, uint16_t value)
+{
+    buf[0] = value & 0xFF;
+    buf[1] = (value >> 8) & 0xFF;
+    return buf + 2;
+}
+
+uint8_t *ctrl_put_u32(uint8_t *buf, uint32_t value)
+{
+    buf[0] = value & 0xFF;
+    buf[1] = (value >> 8) & 0xFF;
+    buf[2] = (value >> 16) & 0xFF;
+    buf[3] = (value >> 24) & 0xFF;
+    return buf + 4;
+}
+
+bool ctrl_send(const uint8_t *msg, uint16_t len)
+{
+    return uart_write_frame(UART_LEN_LOCAL_BIT | UART_LEN_CLASS_BIT, msg, len);
+}
+
+/**
+ * Fill TX power report: [qdbm][auto][peer_rssi][local_rssi][changes u32]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_txpower(uint8_t *p)
+{
+    *p++ = txpower_get();
+    *p++ = txpower_get_auto() ? 1 : 0;
+    *p++ = (uint8_t)txpower_get_peer_rssi();
+    *p++ = (uint8_t)txpower_get_local_rssi();
+    return ctrl_put_u32(p, txpower_get_change_count());
+}
+
+/**
+ * Fill RX filter report: [hw][fallbacks u32]
+ * then per mode (sw, hw): [calls u32][cycles u32][time_ms u32]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_rx_filter(uint8_t *p)
+{
+    uint32_t calls, cycles, time_us;
+    uint8_t hw;
+
+    *p++ = wifi_raw_get_hw_filter() ? 1 : 0;
+    p = ctrl_put_u32(p, wifi_raw_get_hw_filter_fallback_count());
+
+    for (hw = 0; hw < 2; hw++) {
+        wifi_raw_get_rx_cb_stats(hw, &calls, &cycles, &time_us);
+        p = ctrl_put_u32(p, calls);
+        p = ctrl_put_u32(p, cycles);
+        p = ctrl_put_u32(p, time_us / 1000);
+    }
+    return p;
+}
+
+/**
+ * Fill RX callback profile (last window):
+ * [period_ms u16][calls u32][cycles u32][max_cycles u32]
+ * then per outcome (enum rx_stage, then accept): [calls u32][cycles u32]
+ *
+ * @return: Pointer just past the profile
+ */
+static uint8_t *ctrl_put_rx_profile(uint8_t *p)
+{
+    const struct rx_profile *prof = wifi_raw_get_rx_profile();
+    uint8_t i;
+
+    p = ctrl_put_u16(p, prof->period_us / 1000);
+    p = ctrl_put_u32(p, prof->calls);
+    p = ctrl_put_u32(p, prof->cycles);
+    p = ctrl_put_u32(p, prof->max_cycles);
+    for (i = 0; i <= RX_STAGE_COUNT; i++) {
+        p = ctrl_put_u32(p, prof->outcome_calls[i]);
+        p = ctrl_put_u32(p, prof->outcome_cycles[i]);
+    }
+    return p;
+}
+
+/**
+ * Fill capacity model check:
+ * [rate][access_us u16][frames u32][late u32][model_us u32][measured_us u32]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_airtime(uint8_t *p)
+{
+    const struct airtime_model_stats *st = airtime_model_get_stats();
+
+    *p++ = WIFI_TX_RATE;
+    p = ctrl_put_u16(p, AIRTIME_ACCESS_US);
+    p = ctrl_put_u32(p, st->frames);
+    p = ctrl_put_u32(p, st->late);
+    p = ctrl_put_u32(p, st->model_us);
+    return ctrl_put_u32(p, st->measured_us);
+}
+
+/**
+ * Fill bridge loss counters, all u32 since boot:
+ * [uart_rx_overflow][uart_tx_overflow][uart_resync][tx][tx_busy][tx_errors]
+ * then per class (TC_BULK, TC_PRIORITY) [stale][full][budget_drop]
+ * then [oversize], then per class [superseded]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_bridge(uint8_t *p)
+{
+    uint8_t tc;
+
+    p = ctrl_put_u32(p, uart_get_rx_overflow_count());
+    p = ctrl_put_u32(p, uart_get_tx_overflow_count());
+    p = ctrl_put_u32(p, uart_get_rx_resync_count());
+    p = ctrl_put_u32(p, wifi_get_tx_count());
+    p = ctrl_put_u32(p, wifi_get_tx_busy_count());
+    p = ctrl_put_u32(p, wifi_get_tx_error_count());
+    for (tc = 0; tc < TC_COUNT; tc++) {
+        p = ctrl_put_u32(p, txq_get_stale_drop_count(tc));
+        p = ctrl_put_u32(p, txq_get_full_drop_count(tc));
+        p = ctrl_put_u32(p, airtime_budget_get_drop_count(tc));
+    }
+    p = ctrl_put_u32(p, txq_get_oversize_drop_count());
+    for (tc = 0; tc < TC_COUNT; tc++) {
+        p = ctrl_put_u32(p, txq_get_superseded_drop_count(tc));
+    }
+    return p;
+}
+
+/**
+ * Fill memory high-water marks:
+ * [heap u32][heap_min u32][stack_painted u16][stack_used u16]
+ * then per ring (enum uart_ring) [peak u16][size u16]
+ * then per class (TC_BULK, TC_PRIORITY) [peak][depth]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_memory(uint8_t *p)
+{
+    static const uint16_t ring_size[UART_RING_COUNT] = {
+        UART_RX_BUFFER_SIZE, UART_TX_BUFFER_SIZE, UART_TX_PRIO_BUFFER_SIZE
+    };
+    static const uint8_t txq_depth[TC_COUNT] = { TXQ_BULK_DEPTH, TXQ_PRIO_DEPTH };
+    uint8_t i;
+
+    p = ctrl_put_u32(p, system_get_free_heap_size());
+    p = ctrl_put_u32(p, hwm_get_heap_min());
+    p = ctrl_put_u16(p, hwm_get_stack_painted());
+    p = ctrl_put_u16(p, hwm_get_stack_used());
+    for (i = 0; i < UART_RING_COUNT; i++) {
+        p = ctrl_put_u16(p, uart_get_ring_peak(i));
+        p = ctrl_put_u16(p, ring_size[i]);
+    }
+    for (i = 0; i < TC_COUNT; i++) {
+        *p++ = txq_get_peak(i);
+        *p++ = txq_depth[i];
+    }
+    return p;
+}
+
+/**
+ * Fill rolling-window counters: [window_s]
+ * then per counter (enum rate_counter) [last_1s u32][last_window u32]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_rates(uint8_t *p)
+{
+    uint32_t last_1s;
+    uint32_t last_10s;
+    uint8_t i;
+
+    *p++ = rates_get_fill();
+    for (i = 0; i < RATE_COUNT; i++) {
+        rates_get(i, &last_1s, &last_10s);
+        p = ctrl_put_u32(p, last_1s);
+        p = ctrl_put_u32(p, last_10s);
+    }
+    return p;
+}
+
+/**
+ * Fill latency report: [units_per_us][stages]
+ * then per stage (enum lat_stage) [count u32][p50 u32][p90 u32][p99 u32][max u32]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_latency(uint8_t *p)
+{
+    const struct log_hist *h;
+    uint8_t stage;
+
+    *p++ = LAT_UNITS_PER_US;
+    *p++ = LAT_STAGE_COUNT;
+    for (stage = 0; stage < LAT_STAGE_COUNT; stage++) {
+        h = latency_get_hist(stage);
+        p = ctrl_put_u32(p, h->count);
+        p = ctrl_put_u32(p, hist_percentile(h, 50));
+        p = ctrl_put_u32(p, hist_percentile(h, 90));
+        p = ctrl_put_u32(p, hist_percentile(h, 99));
+        p = ctrl_put_u32(p, h->max);
+    }
+    return p;
+}
+
+/**
+ * Fill link table: [count] then per link [id][bssid 6][rx u32]
+ *
+ * @return: Pointer just past the table
+ */
+static uint8_t *ctrl_put_links(uint8_t *p)
+{
+    const uint8_t *bssid;
+    uint8_t link;
+
+    *p++ = links_count();
+    for (link = 0; link < LINK_ID_COUNT; link++) {
+        bssid = links_get_bssid(link);
+        if (bssid == NULL) {
+            continue;
+        }
+        *p++ = link;
+        os_memcpy(p, bssid, 6);
+        p = ctrl_put_u32(p + 6, links_get_rx_count(link));
+    }
+    return p;
+}
+
+/**
+ * Fill link quality: [id][score][rssi][loss_permille u16][jitter_us u16][age_ms u16]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_linkq(uint8_t *p, uint8_t link)
+{
+    struct linkq_report q;
+
+    linkq_get(link, &q);
+    *p++ = link;
+    *p++ = q.score;
+    *p++ = (uint8_t)q.rssi;
+    p = ctrl_put_u16(p, q.loss_permille);
+    p = ctrl_put_u16(p, q.jitter_us);
+    return ctrl_put_u16(p, q.age_ms);
+}
+
+bool ctrl_send_linkq(uint8_t link)
+{
+    uint8_t msg[2 + 9];
+    uint8_t *p;
+
+    msg[0] = CTRL_CMD_GET_LINKQ | CTRL_RESPONSE_BIT;
+    msg[1] = CTRL_STATUS_OK;
+    p = ctrl_put_linkq(msg + 2, link);
+    return ctrl_send(msg, p - msg);
+}
+
+/**
+ * Fill channel survey: [state][channel][first][count]
+ * then per channel [busy_permille u16][frames u16][rssi_max]
+ *
+ * @return: Pointer just past the survey
+ */
+static uint8_t *ctrl_put_survey(uint8_t *p)
+{
+    const struct survey_channel *r;
+    uint8_t ch;
+
+    *p++ = survey_get_state();
+    *p++ = survey_get_channel_choice();
+    *p++ = CHANNEL_SURVEY_FIRST;
+    *p++ = CHANNEL_SURVEY_LAST - CHANNEL_SURVEY_FIRST + 1;
+    for (ch = CHANNEL_SURVEY_FIRST; ch <= CHANNEL_SURVEY_LAST; ch++) {
+        r = survey_get_channel(ch);
+        p = ctrl_put_u16(p, r->busy_permille);
+        p = ctrl_put_u16(p, r->frames);
+        *p++ = (uint8_t)r->rssi_max;
+    }
+    return p;
+}
+
+bool ctrl_send_survey(void)
+{
+    uint8_t msg[2 + 4 + 14 * 5];
+    uint8_t *p;
+
+    msg[0] = CTRL_CMD_GET_SURVEY | CTRL_RESPONSE_BIT;
+    msg[1] = CTRL_STATUS_OK;
+    p = ctrl_put_survey(msg + 2);
+    return ctrl_send(msg, p - msg);
+}
+
+/**
+ * Fill hopping report: [state][hop][len][channels...]
+ * [hops u32][acquisitions u32][losses u32][reacq_ms u32][sync_err_us i32]
+ * [switch_avg_us u16][switch_max_us u16][late_avg_us u16][late_max_us u16]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_fhss(uint8_t *p)
+{
+    const struct fhss_stats *st = fhss_get_stats();
+    const uint8_t *seq;
+    uint8_t len;
+    uint32_t hops = st->hops ? st->hops : 1;
+
+    seq = fhss_get_sequence(&len);
+    *p++ = fhss_get_state();
+    *p++ = fhss_get_hop();
+    *p++ = len;
+    os_memcpy(p, seq, len);
+    p += len;
+    p = ctrl_put_u32(p, st->hops);
+    p = ctrl_put_u32(p, st->acquisitions);
+    p = ctrl_put_u32(p, st->losses);
+    p = ctrl_put_u32(p, st->reacq_ms);
+    p = ctrl_put_u32(p, (uint32_t)st->sync_err_us);
+    p = ctrl_put_u16(p, st->switch_us_total / hops);
+    p = ctrl_put_u16(p, st->switch_us_max);
+    p = ctrl_put_u16(p, st->late_us_total / hops);
+    return ctrl_put_u16(p, st->late_us_max);
+}
+
+/**
+ * Fill TDMA report: [state][acquisitions u32][sync_err_us i32][synced_ms u32]
+ * [tx_frames u32][tx_off_slot u32][tx_airtime_us u32]
+ * [rx_frames u32][rx_off_slot u32][rx_airtime_us u32]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_tdma(uint8_t *p)
+{
+    const struct tdma_stats *st = tdma_get_stats();
+
+    *p++ = tdma_get_state();
+    p = ctrl_put_u32(p, st->acquisitions);
+    p = ctrl_put_u32(p, (uint32_t)st->sync_err_us);
+    p = ctrl_put_u32(p, st->synced_us / 1000);
+    p = ctrl_put_u32(p, st->tx_frames);
+    p = ctrl_put_u32(p, st->tx_off_slot);
+    p = ctrl_put_u32(p, st->tx_airtime_us);
+    p = ctrl_put_u32(p, st->rx_frames);
+    p = ctrl_put_u32(p, st->rx_off_slot);
+    return ctrl_put_u32(p, st->rx_airtime_us);
+}
+
+/**
+ * Fill trace state: [running][depth u16][total u32]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_trace_state(uint8_t *p)
+{
+    *p++ = trace_get_running() ? 1 : 0;
+    p = ctrl_put_u16(p, TRACE_DEPTH);
+    return ctrl_put_u32(p, trace_get_total());
+}
+
+/**
+ * Fill one page of the trace ring: [total u32][first u32][n]
+ * then n records of [time_us u32][event][a8][a16 u16]. first is
+ * moved up to the oldest event still held; the host asks again
+ * from first + n until it reaches total.
+ *
+ * @param first: Sequence number of the first event wanted
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_trace(uint8_t *p, uint32_t first)
+{
+    struct trace_record rec[CTRL_TRACE_PAGE];
+    uint8_t n, i;
+
+    n = trace_read(&first, rec, CTRL_TRACE_PAGE);
+    p = ctrl_put_u32(p, trace_get_total());
+    p = ctrl_put_u32(p, first);
+    *p++ = n;
+
+    for (i = 0; i < n; i++) {
+        p = ctrl_put_u32(p, rec[i].time_us);
+        *p++ = rec[i].event;
+        *p++ = rec[i].a8;
+        p = ctrl_put_u16(p, rec[i].a16);
+    }
+    return p;
+}
+
+/**
+ * Fill ping report: [state][link][sent u32][received u32][lost u32]
+ * [deferred u32][rtt_min_us u32][rtt_avg_us u32][rtt_p50_us u32]
+ * [rtt_p99_us u32][rtt_max_us u32]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_ping(uint8_t *p)
+{
+    const struct ping_stats *st = ping_get_stats();
+
+    *p++ = ping_get_state();
+    *p++ = ping_get_link();
+    p = ctrl_put_u32(p, st->sent);
+    p = ctrl_put_u32(p, st->received);
+    p = ctrl_put_u32(p, st->lost);
+    p = ctrl_put_u32(p, st->deferred);
+    p = ctrl_put_u32(p, st->rtt_min_us);
+    p = ctrl_put_u32(p, st->received ? st->rtt_total_us / st->received : 0);
+    p = ctrl_put_u32(p, hist_percentile(&st->rtt_us, 50));
+    p = ctrl_put_u32(p, hist_percentile(&st->rtt_us, 99));
+    return ctrl_put_u32(p, st->rtt_us.max);
+}
+
+bool ctrl_send_ping(void)
+{
+    uint8_t msg[2 + 38];
+    uint8_t *p;
+
+    msg[0] = CTRL_CMD_GET_PING | CTRL_RESPONSE_BIT;
+    msg[1] = CTRL_STATUS_OK;
+    p = ctrl_put_ping(msg + 2);
+    return ctrl_send(msg, p - msg);
+}
+
+/**
+ * Fill echo responder state: [on][echoed u32][dropped u32]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_echo(uint8_t *p)
+{
+    uint32_t echoed, dropped;
+
+    ping_get_echo_counts(&echoed, &dropped);
+    *p++ = ping_get_echo() ? 1 : 0;
+    p = ctrl_put_u32(p, echoed);
+    return ctrl_put_u32(p, dropped);
+}
+
+/**
+ * Fill generator report: [state][link][pattern][size u16][rate_pps u16]
+ * [sent u32][busy u32][errors u32][elapsed_ms u32]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_trafgen(uint8_t *p)
+{
+    const struct trafgen_config *cfg = trafgen_get_config();
+    const struct trafgen_tx_stats *st = trafgen_get_tx_stats();
+
+    *p++ = trafgen_get_state();
+    *p++ = cfg->link;
+    *p++ = cfg->pattern;
+    p = ctrl_put_u16(p, cfg->size);
+    p = ctrl_put_u16(p, cfg->rate_pps);
+    p = ctrl_put_u32(p, st->sent);
+    p = ctrl_put_u32(p, st->busy);
+    p = ctrl_put_u32(p, st->errors);
+    return ctrl_put_u32(p, st->elapsed_us / 1000);
+}
+
+/**
+ * Fill traffic receiver report: [run][received u32][lost u32]
+ * [reordered u32][bytes u32][elapsed_ms u32][throughput_bps u32][jitter_us u32]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_trafrx(uint8_t *p)
+{
+    const struct trafgen_rx_stats *st = trafgen_get_rx_stats();
+    uint32_t bps = st->elapsed_us ? (uint32_t)((uint64_t)st->bytes * 8000000 / st->elapsed_us) : 0;
+
+    *p++ = st->run;
+    p = ctrl_put_u32(p, st->received);
+    p = ctrl_put_u32(p, st->lost);
+    p = ctrl_put_u32(p, st->reordered);
+    p = ctrl_put_u32(p, st->bytes);
+    p = ctrl_put_u32(p, st->elapsed_us / 1000);
+    p = ctrl_put_u32(p, bps);
+    return ctrl_put_u32(p, st->jitter_us);
+}
+
+bool ctrl_send_trafrx(void)
+{
+    uint8_t msg[2 + 29];
+    uint8_t *p;
+
+    msg[0] = CTRL_CMD_GET_TRAFRX | CTRL_RESPONSE_BIT;
+    msg[1] = CTRL_STATUS_OK;
+    p = ctrl_put_trafrx(msg + 2);
+    return ctrl_send(msg, p - msg);
+}
+
+/**
+ * Fill sniffer report: [on][channel][snaplen][frames u32][bytes u32]
+ * [cut u32][skipped u32][batches u32][batch_drops u32]
+ *
+ * @return: Pointer just past the report
+ */
+static uint8_t *ctrl_put_sniffer(uint8_t *p)
+{
+    const struct sniffer_stats *st = sniffer_get_stats();
+
+    *p++ = sniffer_active() ? 1 : 0;
+    *p++ = wifi_raw_get_channel();
+    *p++ = sniffer_get_snaplen();
+    p = ctrl_put_u32(p, st->frames);
+    p = ctrl_put_u32(p, st->bytes);
+    p = ctrl_put_u32(p, st->cut);
+    p = ctrl_put_u32(p, st->skipped);
+    p = ctrl_put_u32(p, st->batches);
+    return ctrl_put_u32(p, st->batch_drops);
+}
+
+/* ==================================================
+ * UART COMMANDS
+ * ================================================== */
+
+void ctrl_uart_rx(const uint8_t *frame, uint16_t len)
+{
+    uint8_t cmd;
+    uint8_t *p = ctrl_response + 2;
+
+    if (len == 0) {
+        return;
+    }
+
+    cmd = frame[0];
+    ctrl_response[0] = cmd | CTRL_RESPONSE_BIT;
+    ctrl_response[1] = CTRL_STATUS_OK;
+
+    switch (cmd) {
+        case CTRL_CMD_PING:
+            if (len - 1 > CTRL_MAX_RESPONSE - 2) {
+                len = CTRL_MAX_RESPONSE - 1;
+            }
+            os_memcpy(p, frame + 1, len - 1);
+            p += len - 1;
+            break;
+
+        case CTRL_CMD_SET_TXPOWER:
+            if (len < 3 || frame[1] > TXPOWER_MAX_QDBM) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            txpower_set(frame[1]);
+            txpower_set_auto(frame[2] != 0);
+            p = ctrl_put_txpower(p);
+            break;
+
+        case CTRL_CMD_GET_TXPOWER:
+            p = ctrl_put_txpower(p);
+            break;
+
+        case CTRL_CMD_SET_RX_FILTER:
+            if (len < 2) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            wifi_raw_set_hw_filter(frame[1] != 0);
+            p = ctrl_put_rx_filter(p);
+            break;
+
+        case CTRL_CMD_GET_RX_FILTER:
+            p = ctrl_put_rx_filter(p);
+            break;
+
+        case CTRL_CMD_SET_RX_META:
+            if (len < 2) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            wifi_raw_set_rx_meta(frame[1] != 0);
+            *p++ = wifi_raw_get_rx_meta() ? 1 : 0;
+            break;
+
+        case CTRL_CMD_GET_RX_META:
+            *p++ = wifi_raw_get_rx_meta() ? 1 : 0;
+            break;
+
+        case CTRL_CMD_GET_RX_PROFILE:
+            p = ctrl_put_rx_profile(p);
+            break;
+
+        case CTRL_CMD_GET_LATENCY:
+        case CTRL_CMD_RESET_LATENCY:
+            if (!LATENCY_HIST_ENABLED) {
+                ctrl_response[1] = CTRL_STATUS_REFUSED;
+                break;
+            }
+            p = ctrl_put_latency(p);
+            if (cmd == CTRL_CMD_RESET_LATENCY) {
+                latency_reset();
+            }
+            break;
+
+        case CTRL_CMD_GET_TRACE:
+            if (!TRACE_ENABLED) {
+                ctrl_response[1] = CTRL_STATUS_REFUSED;
+                break;
+            }
+            if (len < 5) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            p = ctrl_put_trace(p, frame[1] | (frame[2] << 8) |
+                                  ((uint32_t)frame[3] << 16) | ((uint32_t)frame[4] << 24));
+            break;
+
+        case CTRL_CMD_SET_TRACE:
+            if (!TRACE_ENABLED) {
+                ctrl_response[1] = CTRL_STATUS_REFUSED;
+                break;
+            }
+            if (len < 2) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            if (len >= 3 && frame[2] != 0) {
+                trace_clear();
+            }
+            trace_set_running(frame[1] != 0);
+            p = ctrl_put_trace_state(p);
+            break;
+
+        case CTRL_CMD_GET_AIRTIME:
+            p = ctrl_put_airtime(p);
+            break;
+
+        case CTRL_CMD_GET_BRIDGE:
+            p = ctrl_put_bridge(p);
+            break;
+
+        case CTRL_CMD_GET_MEMORY:
+            p = ctrl_put_memory(p);
+            if (len >= 2 && frame[1] != 0) {
+                hwm_reset();
+            }
+            break;
+
+        case CTRL_CMD_GET_RATES:
+            p = ctrl_put_rates(p);
+            break;
+
+        case CTRL_CMD_SET_LINK:
+            if (len < 8 || frame[1] >= LINK_ID_COUNT) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            if (!links_set(frame[1], frame + 2)) {
+                ctrl_response[1] = CTRL_STATUS_REFUSED;
+            }
+            p = ctrl_put_links(p);
+            break;
+
+        case CTRL_CMD_DEL_LINK:
+            if (len < 2 || frame[1] >= LINK_ID_COUNT) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            if (!links_remove(frame[1])) {
+                ctrl_response[1] = CTRL_STATUS_REFUSED;
+            }
+            p = ctrl_put_links(p);
+            break;
+
+        case CTRL_CMD_GET_LINKS:
+            p = ctrl_put_links(p);
+            break;
+
+        case CTRL_CMD_GET_LINKQ:
+            if (len < 2 || frame[1] >= LINK_ID_COUNT) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            p = ctrl_put_linkq(p, frame[1]);
+            break;
+
+        case CTRL_CMD_SET_LINKQ_REPORT:
+            if (len < 3) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            linkq_set_report_ms(frame[1] | (frame[2] << 8));
+            p = ctrl_put_u16(p, linkq_get_report_ms());
+            break;
+
+        case CTRL_CMD_START_SURVEY:
+            if (!survey_start()) {
+                ctrl_response[1] = CTRL_STATUS_REFUSED;
+            }
+            p = ctrl_put_survey(p);
+            break;
+
+        case CTRL_CMD_GET_SURVEY:
+            p = ctrl_put_survey(p);
+            break;
+
+        case CTRL_CMD_GET_FHSS:
+            p = ctrl_put_fhss(p);
+            break;
+
+        case CTRL_CMD_GET_TDMA:
+            p = ctrl_put_tdma(p);
+            break;
+
+        case CTRL_CMD_GET_PING:
+            p = ctrl_put_ping(p);
+            break;
+
+        case CTRL_CMD_START_PING:
+            if (len < 4 || frame[1] >= LINK_ID_COUNT) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            if (!ping_start(frame[1], frame[2] | (frame[3] << 8),
+                            (len >= 6) ? frame[4] | (frame[5] << 8) : 0)) {
+                ctrl_response[1] = CTRL_STATUS_REFUSED;
+            }
+            p = ctrl_put_ping(p);
+            break;
+
+        case CTRL_CMD_STOP_PING:
+            ping_stop();
+            p = ctrl_put_ping(p);
+            break;
+
+        case CTRL_CMD_SET_ECHO:
+            if (len < 2) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            ping_set_echo(frame[1] != 0);
+            p = ctrl_put_echo(p);
+            break;
+
+        case CTRL_CMD_START_TRAFGEN:
+        {
+            struct trafgen_config cfg;
+
+            if (len < 12) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            cfg.link = frame[1];
+            cfg.pattern = frame[2];
+            cfg.size = frame[3] | (frame[4] << 8);
+            cfg.rate_pps = frame[5] | (frame[6] << 8);
+            cfg.count = frame[7] | (frame[8] << 8) |
+                        ((uint32_t)frame[9] << 16) | ((uint32_t)frame[10] << 24);
+            cfg.burst = frame[11];
+            if (!trafgen_start(&cfg)) {
+                ctrl_response[1] = CTRL_STATUS_REFUSED;
+            }
+            p = ctrl_put_trafgen(p);
+            break;
+        }
+
+        case CTRL_CMD_STOP_TRAFGEN:
+            trafgen_stop();
+            p = ctrl_put_trafgen(p);
+            break;
+
+        case CTRL_CMD_GET_TRAFGEN:
+            p = ctrl_put_trafgen(p);
+            break;
+
+        case CTRL_CMD_GET_TRAFRX:
+            p = ctrl_put_trafrx(p);
+            break;
+
+        case CTRL_CMD_SET_SNIFFER:
+            if (len < 4) {
+                ctrl_response[1] = CTRL_STATUS_BAD_ARGS;
+                break;
+            }
+            if (frame[1] == 0) {
+                sniffer_stop();
+            } else if (!sniffer_start(frame[2], frame[3])) {
+                ctrl_response[1] = CTRL_STATUS_REFUSED;
+            }
+            p = ctrl_put_sniffer(p);
+            break;
+
+        case CTRL_CMD_GET_SNIFFER:
+            p = ctrl_put_sniffer(p);
+            break;
+
+        default:
+            ctrl_response[1] = CTRL_STATUS_UNKNOWN;
+            break;
+    }
+
+    ctrl_send(ctrl_response, p - ctrl_response);
+}
+
+/* ==================================================
+ * AIR MESSAGES
+ * ================================================== */
+
+void ctrl_air_rx(const uint8_t *msg, uint16_t len, uint8_t link)
+{
+    if (len == 0) {
+        return;
+    }
+
+    switch (msg[0]) {
+        case AIR_MSG_RSSI_REPORT:
+            if (len >= 2) {
+                txpower_peer_report(link, (int8_t)msg[1]);
+            }
+            break;
+
+        case AIR_MSG_PING:
+            ping_air_rx(msg, len);
+            break;
+
+        case AIR_MSG_TRAFGEN:
+            trafgen_air_rx(msg, len);
+            break;
+
+        default:
+            /* Unknown types are ignored (newer peer firmware) */
+            break;
+    }
+}
@@ -0,0 +1,150 @@
+/* ==================================================
+ * Local Control Channel
+ * In-band commands between the flight controller and
+ * this ESP, and local messages between the two ESPs
+ * ================================================== */
+
+#ifndef CTRL_H
+#define CTRL_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * UART COMMANDS (FLIGHT CONTROLLER ↔ ESP)
+ * ================================================== */
+
+/* Local UART frames have UART_LEN_LOCAL_BIT set in LEN_HI:
+ *   Request:  [cmd][args...]
+ *   Response: [cmd | CTRL_RESPONSE_BIT][status][data...]
+ * Multi-byte fields are little-endian (native on ESP8266 and RP2040).
+ */
+#define CTRL_RESPONSE_BIT       0x80
+
+#define CTRL_CMD_PING           0x01        /* -> echoes args */
+#define CTRL_CMD_GET_TXPOWER    0x10        /* -> txpower report */
+#define CTRL_CMD_SET_TXPOWER    0x11        /* [qdbm][auto] -> txpower report */
+#define CTRL_CMD_GET_RX_FILTER  0x20        /* -> rx filter report */
+#define CTRL_CMD_SET_RX_FILTER  0x21        /* [hw] -> rx filter report */
+#define CTRL_CMD_GET_RX_META    0x22        /* -> [on] */
+#define CTRL_CMD_SET_RX_META    0x23        /* [on] -> [on] */
+#define CTRL_CMD_GET_RX_PROFILE 0x24        /* -> rx callback profile */
+#define CTRL_CMD_GET_LATENCY    0x25        /* -> per-stage latency histograms */
+#define CTRL_CMD_RESET_LATENCY  0x26        /* -> latency report, then clear */
+#define CTRL_CMD_GET_TRACE      0x27        /* [first u32] -> trace records from first */
+#define CTRL_CMD_SET_TRACE      0x28        /* [run][clear] -> trace state */
+#define CTRL_CMD_GET_AIRTIME    0x29        /* -> capacity model check */
+#define CTRL_CMD_GET_BRIDGE     0x2A        /* -> UART and TX loss counters */
+#define CTRL_CMD_GET_MEMORY     0x2B        /* [reset] -> heap, stack and buffer high-water marks */
+#define CTRL_CMD_GET_RATES      0x2C        /* -> per-1 s and per-10 s throughput counters */
+#define CTRL_CMD_GET_LINKS      0x30        /* -> link table */
+#define CTRL_CMD_SET_LINK       0x31        /* [id][bssid 6] -> link table */
+#define CTRL_CMD_DEL_LINK       0x32        /* [id] -> link table */
+#define CTRL_CMD_GET_LINKQ      0x40        /* [id] -> link quality (also pushed) */
+#define CTRL_CMD_SET_LINKQ_REPORT 0x41      /* [interval_ms u16] -> [interval_ms u16] */
+#define CTRL_CMD_GET_SURVEY     0x50        /* -> channel survey (also pushed) */
+#define CTRL_CMD_START_SURVEY   0x51        /* -> channel survey (rescan) */
+#define CTRL_CMD_GET_FHSS       0x52        /* -> hopping state and timing */
+#define CTRL_CMD_GET_TDMA       0x53        /* -> slot schedule statistics */
+#define CTRL_CMD_GET_PING       0x60        /* -> round-trip statistics (also pushed) */
+#define CTRL_CMD_START_PING     0x61        /* [link][count u16][interval_ms u16] -> ping report */
+#define CTRL_CMD_STOP_PING      0x62        /* -> ping report */
+#define CTRL_CMD_SET_ECHO       0x63        /* [on] -> echo responder state */
+#define CTRL_CMD_START_TRAFGEN  0x64        /* [link][pattern][size u16][rate u16][count u32][burst] -> generator report */
+#define CTRL_CMD_STOP_TRAFGEN   0x65        /* -> generator report */
+#define CTRL_CMD_GET_TRAFGEN    0x66        /* -> generator report */
+#define CTRL_CMD_GET_TRAFRX     0x67        /* -> receiver report (also pushed) */
+#define CTRL_CMD_GET_SNIFFER    0x70        /* -> sniffer report */
+#define CTRL_CMD_SET_SNIFFER    0x71        /* [on][channel][snaplen] -> sniffer report */
+#define CTRL_CMD_SNIFF_BATCH    0x72        /* Push only: captured frames (see sniffer.h) */
+
+#define CTRL_STATUS_OK          0x00
+#define CTRL_STATUS_BAD_ARGS    0x01
+#define CTRL_STATUS_UNKNOWN     0x02
+#define CTRL_STATUS_REFUSED     0x03        /* Valid request, not possible now */
+
+/* Largest response payload (fits any local frame) */
+#define CTRL_MAX_RESPONSE       MAX_PACKET_SIZE
+
+/* ==================================================
+ * AIR MESSAGES (ESP ↔ PEER ESP)
+ * ================================================== */
+
+/* Carried as local records inside aggregated frames: [type][data...] */
+#define AIR_MSG_RSSI_REPORT     0x01        /* [rssi int8] - how we hear the peer */
+#define AIR_MSG_PING            0x02        /* [seq u16][padding] - RTT probe, echoed back */
+#define AIR_MSG_TRAFGEN         0x03        /* [run][seq u32][tx_us u32][fill] - test traffic */
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Handle a local frame received from the flight controller
+ *
+ * @param frame: Payload ([cmd][args...])
+ * @param len: Payload length
+ */
+void ctrl_uart_rx(const uint8_t *frame, uint16_t len);
+
+/**
+ * Handle a local record received from the peer ESP
+ *
+ * @param msg: Record payload ([type][data...])
+ * @param len: Record length
+ * @param link: Link the record arrived on
+ */
+void ctrl_air_rx(const uint8_t *msg, uint16_t len, uint8_t link);
+
+/**
+ * Send a local frame to the flight controller (priority ring)
+ *
+ * @param msg: Payload
+ * @param len: Payload length
+ * @return: true if queued
+ */
+bool ctrl_send(const uint8_t *msg, uint16_t len);
+
+/**
+ * Send a link quality report as a GET_LINKQ response
+ * (pushed unsolicited every SET_LINKQ_REPORT interval, if set)
+ *
+ * @param link: Link ID
+ * @return: true if queued
+ */
+bool ctrl_send_linkq(uint8_t link);
+
+/**
+ * Send the channel survey as a GET_SURVEY response
+ * (pushed when the survey completes and when the channel settles)
+ *
+ * @return: true if queued
+ */
+bool ctrl_send_survey(void);
+
+/**
+ * Send the round-trip statistics as a GET_PING response
+ * (pushed when a probe run finishes)
+ *
+ * @return: true if queued
+ */
+bool ctrl_send_ping(void);
+
+/**
+ * Send the traffic receiver statistics as a GET_TRAFRX response
+ * (pushed every TRAFGEN_REPORT_MS while test traffic arrives)
+ *
+ * @return: true if queued
+ */
+bool ctrl_send_trafrx(void);
+
+/**
+ * Store little-endian integers into a response buffer
+ *
+ * @param buf: Destination
+ * @param value: Value to store
+ * @return: Pointer just past the stored bytes
+ */
+uint8_t *ctrl_put_u16(uint8_t *buf, uint16_t value);
+uint8_t *ctrl_put_u32(uint8_t *buf, uint32_t value);
+
+#endif /* CTRL_H */
@@ -0,0 +1,31 @@
+/* ==================================================
+ * CPU Cycle Counter
+ * Xtensa CCOUNT register: increments every CPU clock
+ * (80 MHz default), wraps every ~53 s
+ * ================================================== */
+
+#ifndef CYCLES_H
+#define CYCLES_H
+
+#include "c_types.h"
+
+#define CPU_CYCLES_PER_US       80          /* 80 MHz core clock */
+
+#ifdef HOST_BUILD
+/* Simulator: host clock scaled to the core clock (host/sim_main.c) */
+uint32_t cycles_now(void);
+#else
+/**
+ * Read the cycle counter (one instruction, ISR-safe)
+ *
+ * @return: Current CCOUNT value
+ */
+static inline uint32_t cycles_now(void)
+{
+    uint32_t ccount;
+    __asm__ __volatile__("rsr %0, ccount" : "=a"(ccount));
+    return ccount;
+}
+#endif
+
+#endif /* CYCLES_H */
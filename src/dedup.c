@@ -0,0 +1,179 @@
+/* ==================================================
+ * RX Duplicate Suppression Implementation
+ *
+ * Per sender and link (each link has its own sequence
+ * counter at the sender): the highest number seen and a
+ * bitmap of the RX_DEDUP_WINDOW numbers below it (bit n
+ * = top - n). Newer numbers slide the window forward,
+ * older ones inside it are checked against their bit.
+ * ================================================== */
+
+#include "dedup.h"
+#include "user_config.h"
+#include "osapi.h"
+
+#if RX_DEDUP_WINDOW > 32
+#error "RX_DEDUP_WINDOW must fit the 32-bit bitmap"
+#endif
+
+/* 802.11 sequence numbers are 12 bits */
+#define SEQ_MODULO          4096
+#define SEQ_MASK            (SEQ_MODULO - 1)
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+#if RX_DEDUP_ENABLED
+struct dedup_sender {
+    uint8_t addr[6];
+    uint8_t link;
+    uint16_t top;               /* Highest sequence number seen */
+    uint32_t seen;              /* Bit n: top - n was received */
+    uint32_t last_us;           /* Last frame from this sender */
+    uint8_t used;
+};
+
+static struct dedup_sender dedup_senders[RX_DEDUP_SENDERS];
+
+/* Most recent sender - almost every frame comes from the same peer */
+static uint8_t dedup_last = 0;
+#endif
+
+/* Statistics */
+static uint32_t dedup_dup_count = 0;
+static uint32_t dedup_resync_count = 0;
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+#if RX_DEDUP_ENABLED
+
+/**
+ * Find the sender's window, or claim the least recently used one
+ *
+ * @param addr2: Transmitter address
+ * @param link: Link ID the frame was accepted on
+ * @param now: system_get_time()
+ * @return: Sender state (used == 0 if newly claimed)
+ */
+static struct dedup_sender *dedup_lookup(const uint8_t *addr2, uint8_t link, uint32_t now)
+{
+    struct dedup_sender *s = &dedup_senders[dedup_last];
+    uint8_t i;
+    uint8_t victim = 0;
+
+    if (s->used && s->link == link && os_memcmp(s->addr, addr2, 6) == 0) {
+        return s;
+    }
+
+    for (i = 0; i < RX_DEDUP_SENDERS; i++) {
+        s = &dedup_senders[i];
+        if (s->used && s->link == link && os_memcmp(s->addr, addr2, 6) == 0) {
+            dedup_last = i;
+            return s;
+        }
+        if (!s->used) {
+            victim = i;
+        } else if (dedup_senders[victim].used &&
+                   now - s->last_us > now - dedup_senders[victim].last_us) {
+            victim = i;
+        }
+    }
+
+    s = &dedup_senders[victim];
+    os_memcpy(s->addr, addr2, 6);
+    s->link = link;
+    s->used = 0;
+    dedup_last = victim;
+    return s;
+}
+#endif
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void dedup_init(void)
+{
+#if RX_DEDUP_ENABLED
+    os_memset(dedup_senders, 0, sizeof(dedup_senders));
+    dedup_last = 0;
+#endif
+    dedup_reset_stats();
+}
+
+bool dedup_check(const uint8_t *addr2, uint8_t link, uint16_t seq, uint32_t now)
+{
+#if RX_DEDUP_ENABLED
+    struct dedup_sender *s = dedup_lookup(addr2, link, now);
+    uint16_t ahead;
+    uint16_t behind;
+
+    seq &= SEQ_MASK;
+
+    /* New or quiet sender: start a fresh window at this frame */
+    if (!s->used || now - s->last_us > RX_DEDUP_RESYNC_MS * 1000) {
+        if (s->used) {
+            dedup_resync_count++;
+        }
+        s->used = 1;
+        s->top = seq;
+        s->seen = 1;
+        s->last_us = now;
+        return false;
+    }
+
+    s->last_us = now;
+    ahead = (seq - s->top) & SEQ_MASK;
+
+    /* Newer than anything seen: slide the window forward */
+    if (ahead != 0 && ahead < SEQ_MODULO / 2) {
+        s->seen = (ahead < RX_DEDUP_WINDOW) ? (s->seen << ahead) | 1 : 1;
+        s->top = seq;
+        return false;
+    }
+
+    behind = (s->top - seq) & SEQ_MASK;
+
+    /* Older than the window: the sender restarted its counter */
+    if (behind >= RX_DEDUP_WINDOW) {
+        dedup_resync_count++;
+        s->top = seq;
+        s->seen = 1;
+        return false;
+    }
+
+    /* Inside the window: a repeat if its bit is already set */
+    if (s->seen & (1UL << behind)) {
+        dedup_dup_count++;
+        return true;
+    }
+
+    s->seen |= 1UL << behind;
+    return false;
+#else
+    return false;
+#endif
+}
+
+/* ==================================================
+ * STATISTICS
+ * ================================================== */
+
+uint32_t dedup_get_dup_count(void)
+{
+    return dedup_dup_count;
+}
+
+uint32_t dedup_get_resync_count(void)
+{
+    return dedup_resync_count;
+}
+
+void dedup_reset_stats(void)
+{
+    dedup_dup_count = 0;
+    dedup_resync_count = 0;
+}
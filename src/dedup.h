@@ -0,0 +1,53 @@
+/* ==================================================
+ * RX Duplicate Suppression
+ * Sliding-window bitmap over the 802.11 sequence
+ * number, one window per sender address
+ * ================================================== */
+
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Forget all senders
+ */
+void dedup_init(void);
+
+/**
+ * Check a received frame and record its sequence number
+ * Runs in the RX callback - constant work per frame.
+ *
+ * @param addr2: Transmitter address (6 bytes)
+ * @param link: Link ID the frame was accepted on
+ * @param seq: 12-bit sequence number (seq_ctrl >> 4)
+ * @param now: system_get_time()
+ * @return: true if the frame is a duplicate (drop it)
+ */
+bool dedup_check(const uint8_t *addr2, uint8_t link, uint16_t seq, uint32_t now);
+
+/**
+ * Get duplicate count
+ *
+ * @return: Frames dropped as duplicates
+ */
+uint32_t dedup_get_dup_count(void);
+
+/**
+ * Get resync count
+ *
+ * @return: Times a sender's window was restarted (reboot, long gap,
+ *          or a jump back beyond the window)
+ */
+uint32_t dedup_get_resync_count(void);
+
+/**
+ * Reset statistics counters
+ */
+void dedup_reset_stats(void);
+
+#endif /* DEDUP_H */
@@ -0,0 +1,345 @@
+/* ==================================================
+ * Frequency Hopping Implementation
+ *
+ * Time is kept as an epoch: the local time at which hop 0
+ * of the current cycle started. The hop timer derives the
+ * hop index from it, so a correction of the epoch moves
+ * the whole schedule. The RX callback only records the
+ * leader's epoch as seen in a frame; the hop timer applies
+ * it, so the epoch has a single writer.
+ * ================================================== */
+
+#include "fhss.h"
+#include "user_config.h"
+#include "wifi_raw.h"
+#include "cycles.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+#if FHSS_ENABLED && CHANNEL_SURVEY_ENABLED
+#error "FHSS_ENABLED and CHANNEL_SURVEY_ENABLED are exclusive"
+#endif
+
+#if FHSS_DWELL_US > 0xFFFF || FHSS_GUARD_US * 2 > FHSS_DWELL_US
+#error "FHSS_DWELL_US must fit the 16-bit sync phase and exceed 2 * FHSS_GUARD_US"
+#endif
+
+#if (FHSS_CHANNELS & ~0x7FFE) || (FHSS_CHANNELS & (FHSS_CHANNELS - 1)) == 0
+#error "FHSS_CHANNELS must name at least two channels within 1..14"
+#endif
+
+/* Timer firing this close before a boundary counts as on time */
+#define FHSS_EARLY_US           200
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+static uint8_t fhss_seq[14];
+static uint8_t fhss_len = 0;
+static uint32_t fhss_cycle_us = 0;
+
+static os_timer_t fhss_timer;
+static void (*fhss_hop_hook)(void) = NULL;
+
+static uint8_t fhss_state = FHSS_STATE_OFF;
+static uint32_t fhss_epoch_us = 0;          /* Start of hop 0, this cycle */
+static uint8_t fhss_hop = 0;                /* Hop the radio is tuned to */
+static uint32_t fhss_heard_us = 0;          /* Last sync applied */
+static uint32_t fhss_lost_us = 0;           /* Entered ACQUIRE */
+static uint8_t fhss_park_hops = 0;          /* ACQUIRE: dwells on the parked channel */
+
+/* Leader epoch measured by the RX callback */
+static volatile uint32_t sync_epoch_us = 0;
+static volatile uint8_t sync_pending = 0;
+
+static struct fhss_stats fhss_stats;
+
+/* ==================================================
+ * HOP SEQUENCE
+ * ================================================== */
+
+/**
+ * Shuffle FHSS_CHANNELS with a PRNG seeded from CUSTOM_BSSID
+ * Permutations are redrawn until consecutive hops (including
+ * the wrap to hop 0) are FHSS_MIN_SPACING apart, so one hop
+ * does not land next to a channel just left. Both ends draw
+ * the same numbers, so they agree on the result.
+ */
+static void fhss_build_sequence(void)
+{
+    static const uint8_t bssid[6] = CUSTOM_BSSID;
+    uint32_t x = 2166136261u;
+    uint8_t attempt, i, j, t;
+    int8_t gap;
+    bool spaced;
+
+    /* FNV-1a of the BSSID seeds xorshift32 */
+    for (i = 0; i < 6; i++) {
+        x = (x ^ bssid[i]) * 16777619u;
+    }
+    if (x == 0) {
+        x = 1;
+    }
+
+    for (attempt = 0; attempt < 255; attempt++) {
+        fhss_len = 0;
+        for (i = 1; i <= 14; i++) {
+            if (FHSS_CHANNELS & (1 << i)) {
+                fhss_seq[fhss_len++] = i;
+            }
+        }
+
+        for (i = fhss_len - 1; i > 0; i--) {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            j = x % (i + 1);
+            t = fhss_seq[i];
+            fhss_seq[i] = fhss_seq[j];
+            fhss_seq[j] = t;
+        }
+
+        spaced = true;
+        for (i = 0; i < fhss_len; i++) {
+            gap = fhss_seq[i] - fhss_seq[(i + 1) % fhss_len];
+            if (gap < FHSS_MIN_SPACING && -gap < FHSS_MIN_SPACING) {
+                spaced = false;
+                break;
+            }
+        }
+        if (spaced) {
+            break;
+        }
+    }
+
+    fhss_cycle_us = (uint32_t)fhss_len * FHSS_DWELL_US;
+}
+
+/* ==================================================
+ * HOP TIMER
+ * ================================================== */
+
+/**
+ * Wrap a time difference into (-cycle/2, cycle/2]
+ */
+static int32_t fhss_wrap(int32_t d)
+{
+    d %= (int32_t)fhss_cycle_us;
+    if (d > (int32_t)fhss_cycle_us / 2) {
+        d -= fhss_cycle_us;
+    } else if (d <= -(int32_t)fhss_cycle_us / 2) {
+        d += fhss_cycle_us;
+    }
+    return d;
+}
+
+/**
+ * Retune to a hop index, timing the channel switch
+ */
+static void fhss_tune(uint8_t hop)
+{
+    uint32_t start = cycles_now();
+    uint32_t us;
+
+    wifi_raw_set_channel(fhss_seq[hop]);
+    us = (cycles_now() - start) / CPU_CYCLES_PER_US;
+
+    fhss_hop = hop;
+    fhss_stats.hops++;
+    fhss_stats.switch_us_total += us;
+    if (us > fhss_stats.switch_us_max) {
+        fhss_stats.switch_us_max = us;
+    }
+}
+
+/**
+ * Apply the latest leader epoch from the RX callback
+ * A follower without sync takes it as is; once synced, small
+ * errors are corrected a fraction per hop to filter jitter.
+ */
+static void fhss_apply_sync(uint32_t now)
+{
+    int32_t err = fhss_wrap((int32_t)(sync_epoch_us - fhss_epoch_us));
+
+    sync_pending = 0;
+    fhss_heard_us = now;
+    fhss_stats.sync_err_us = err;
+
+    if (fhss_state != FHSS_STATE_SYNCED) {
+        fhss_epoch_us = sync_epoch_us;
+        fhss_state = FHSS_STATE_SYNCED;
+        fhss_stats.acquisitions++;
+        fhss_stats.reacq_ms = (now - fhss_lost_us) / 1000;
+    } else if (err > FHSS_DWELL_US / 4 || err < -FHSS_DWELL_US / 4) {
+        fhss_epoch_us = sync_epoch_us;
+    } else {
+        fhss_epoch_us += err / (1 << FHSS_SYNC_GAIN_SHIFT);
+    }
+}
+
+/**
+ * Park on one channel until the leader comes by. The leader
+ * visits every channel once a cycle; if nothing is heard for
+ * a cycle the parked channel may be jammed, so move on.
+ */
+static void fhss_acquire(void)
+{
+    if (++fhss_park_hops > fhss_len) {
+        fhss_park_hops = 0;
+        fhss_tune((fhss_hop + 1) % fhss_len);
+    }
+    os_timer_arm_us(&fhss_timer, FHSS_DWELL_US, 0);
+}
+
+/**
+ * Hop timer: apply sync, pick the hop for the current time,
+ * retune and arm for the next boundary
+ */
+static void fhss_timer_cb(void *arg)
+{
+    uint32_t now = system_get_time();
+    uint32_t offset;
+    int32_t d;
+    uint8_t k;
+
+    if (sync_pending) {
+        fhss_apply_sync(now);
+    }
+
+    /* Follower: silent link - coast, then reacquire */
+    if (!FHSS_LEADER && fhss_state == FHSS_STATE_SYNCED &&
+        now - fhss_heard_us > (uint32_t)FHSS_COAST_HOPS * FHSS_DWELL_US) {
+        fhss_state = FHSS_STATE_ACQUIRE;
+        fhss_stats.losses++;
+        fhss_lost_us = now;
+        fhss_park_hops = 0;
+    }
+
+    if (fhss_state == FHSS_STATE_ACQUIRE) {
+        fhss_acquire();
+        return;
+    }
+
+    /* Keep the epoch within the last cycle */
+    d = (int32_t)(now - fhss_epoch_us);
+    while (d < 0) {
+        fhss_epoch_us -= fhss_cycle_us;
+        d += fhss_cycle_us;
+    }
+    while (d >= (int32_t)fhss_cycle_us) {
+        fhss_epoch_us += fhss_cycle_us;
+        d -= fhss_cycle_us;
+    }
+
+    /* k may be fhss_len when the timer fires just before the cycle ends */
+    k = d / FHSS_DWELL_US;
+    offset = d % FHSS_DWELL_US;
+    if (FHSS_DWELL_US - offset < FHSS_EARLY_US) {
+        k++;
+        offset = 0;
+    }
+
+    if (k % fhss_len != fhss_hop) {
+        fhss_stats.late_us_total += offset;
+        if (offset > fhss_stats.late_us_max) {
+            fhss_stats.late_us_max = offset;
+        }
+        fhss_tune(k % fhss_len);
+        if (fhss_hop_hook != NULL) {
+            fhss_hop_hook();
+        }
+    }
+
+    /* Next boundary, from the epoch rather than from now */
+    now = system_get_time();
+    d = (int32_t)(fhss_epoch_us + (uint32_t)(k + 1) * FHSS_DWELL_US - now);
+    os_timer_arm_us(&fhss_timer, d > FHSS_EARLY_US ? d : FHSS_EARLY_US, 0);
+}
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void fhss_init(void (*hop_cb)(void))
+{
+    if (!FHSS_ENABLED) {
+        return;
+    }
+
+    fhss_build_sequence();
+    os_memset(&fhss_stats, 0, sizeof(fhss_stats));
+    fhss_hop_hook = hop_cb;
+
+    fhss_epoch_us = system_get_time();
+    fhss_lost_us = fhss_epoch_us;
+    fhss_state = FHSS_LEADER ? FHSS_STATE_SYNCED : FHSS_STATE_ACQUIRE;
+    fhss_tune(0);
+
+    os_timer_disarm(&fhss_timer);
+    os_timer_setfn(&fhss_timer, (os_timer_func_t *)fhss_timer_cb, NULL);
+    os_timer_arm_us(&fhss_timer, FHSS_DWELL_US, 0);
+
+    os_printf("FHSS: %s, %u channels, %u us dwell\n",
+              FHSS_LEADER ? "leader" : "follower", fhss_len, FHSS_DWELL_US);
+}
+
+bool fhss_tx_open(void)
+{
+    int32_t d;
+
+    if (fhss_state != FHSS_STATE_SYNCED) {
+        return true;
+    }
+
+    /* Frame must end on this hop's channel */
+    d = fhss_wrap((int32_t)(system_get_time() - fhss_epoch_us - (uint32_t)fhss_hop * FHSS_DWELL_US));
+    return d >= 0 && d < FHSS_DWELL_US - FHSS_GUARD_US;
+}
+
+void fhss_fill_sync(uint8_t *sync)
+{
+    int32_t d = fhss_wrap((int32_t)(system_get_time() - fhss_epoch_us - (uint32_t)fhss_hop * FHSS_DWELL_US));
+
+    if (d < 0) {
+        d = 0;
+    }
+    sync[0] = fhss_hop;
+    sync[1] = d & 0xFF;
+    sync[2] = (d >> 8) & 0xFF;
+}
+
+void fhss_rx_sync(const uint8_t *sync, uint32_t rx_us, uint32_t airtime_us)
+{
+    uint16_t phase = sync[1] | (sync[2] << 8);
+
+    if (FHSS_LEADER || sync[0] >= fhss_len) {
+        return;
+    }
+
+    /* The sender was `phase` into hop sync[0] when it built the
+     * frame; the frame then took `airtime_us` on air */
+    sync_epoch_us = rx_us - airtime_us - phase - (uint32_t)sync[0] * FHSS_DWELL_US;
+    sync_pending = 1;
+}
+
+uint8_t fhss_get_state(void)
+{
+    return fhss_state;
+}
+
+uint8_t fhss_get_hop(void)
+{
+    return fhss_hop;
+}
+
+const uint8_t *fhss_get_sequence(uint8_t *len)
+{
+    *len = fhss_len;
+    return fhss_seq;
+}
+
+const struct fhss_stats *fhss_get_stats(void)
+{
+    return &fhss_stats;
+}
@@ -0,0 +1,102 @@
+/* ==================================================
+ * Frequency Hopping
+ * Both ends hop over a BSSID-derived channel sequence
+ * on the leader's timebase, recovered by the follower
+ * from the sync field of every received frame
+ * ================================================== */
+
+#ifndef FHSS_H
+#define FHSS_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * TYPES
+ * ================================================== */
+
+/* Hopping states (reported in GET_FHSS) */
+#define FHSS_STATE_OFF          0
+#define FHSS_STATE_ACQUIRE      1           /* Follower: parked, listening for the leader */
+#define FHSS_STATE_SYNCED       2           /* Hopping on the shared timebase */
+
+/* Hop timing and sync statistics (since boot) */
+struct fhss_stats {
+    uint32_t hops;              /* Channel changes */
+    uint32_t acquisitions;      /* Follower: times sync was (re)gained */
+    uint32_t losses;            /* Follower: times sync was lost */
+    uint32_t switch_us_total;   /* Time spent in wifi_raw_set_channel() */
+    uint32_t switch_us_max;
+    uint32_t late_us_total;     /* Hop timer lateness past the boundary */
+    uint32_t late_us_max;
+    int32_t sync_err_us;        /* Last phase error seen by the follower */
+    uint32_t reacq_ms;          /* Last loss-to-sync time */
+};
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Build the hop sequence and start hopping (no-op unless
+ * FHSS_ENABLED). Call after wifi_raw_init().
+ *
+ * @param hop_cb: Called after each hop so queued frames can
+ *                go out at once (e.g. post the bridge task), or NULL
+ */
+void fhss_init(void (*hop_cb)(void));
+
+/**
+ * Check whether a frame may start now: the radio is on the
+ * scheduled channel and the next hop is more than
+ * FHSS_GUARD_US away
+ *
+ * @return: true if TX is allowed (always when FHSS is off)
+ */
+bool fhss_tx_open(void);
+
+/**
+ * Write the sync field of an outgoing frame
+ *
+ * @param sync: FHSS_SYNC_SIZE bytes after the 802.11 header
+ */
+void fhss_fill_sync(uint8_t *sync);
+
+/**
+ * Feed the sync field of an accepted frame (RX callback)
+ *
+ * @param sync: FHSS_SYNC_SIZE bytes after the 802.11 header
+ * @param rx_us: system_get_time() at the RX callback
+ * @param airtime_us: Frame duration on air
+ */
+void fhss_rx_sync(const uint8_t *sync, uint32_t rx_us, uint32_t airtime_us);
+
+/**
+ * Get hopping state
+ *
+ * @return: FHSS_STATE_*
+ */
+uint8_t fhss_get_state(void);
+
+/**
+ * Get the current hop index in the sequence
+ *
+ * @return: Hop index
+ */
+uint8_t fhss_get_hop(void);
+
+/**
+ * Get the hop sequence
+ *
+ * @param len: Receives the number of channels
+ * @return: Channel per hop index
+ */
+const uint8_t *fhss_get_sequence(uint8_t *len);
+
+/**
+ * Get hop timing and sync statistics
+ *
+ * @return: Statistics
+ */
+const struct fhss_stats *fhss_get_stats(void);
+
+#endif /* FHSS_H */
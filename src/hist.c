@@ -0,0 +1,94 @@
+/* ==================================================
+ * Log-Scale Histogram Implementation
+ *
+ * Bin layout (HIST_SUB_BITS = 2):
+ *   values 0-3      -> bins 0-3 (exact)
+ *   values 2^k..    -> 4 bins per octave, split on the
+ *                      two bits below the leading one
+ * ================================================== */
+
+#include "hist.h"
+
+#define HIST_SUB_COUNT  (1 << HIST_SUB_BITS)
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void hist_reset(struct log_hist *h)
+{
+    uint8_t i;
+
+    h->count = 0;
+    h->max = 0;
+    for (i = 0; i < HIST_BINS; i++) {
+        h->bins[i] = 0;
+    }
+}
+
+uint8_t hist_bin(uint32_t value)
+{
+    uint32_t bin;
+    uint8_t msb;
+
+    if (value < HIST_SUB_COUNT) {
+        return value;
+    }
+
+    msb = 31 - __builtin_clz(value);
+    bin = ((uint32_t)(msb - HIST_SUB_BITS + 1) << HIST_SUB_BITS) +
+          ((value >> (msb - HIST_SUB_BITS)) & (HIST_SUB_COUNT - 1));
+
+    return (bin < HIST_BINS) ? bin : HIST_BINS - 1;
+}
+
+uint32_t hist_bin_floor(uint8_t bin)
+{
+    uint8_t octave;
+    uint8_t sub;
+
+    if (bin < HIST_SUB_COUNT) {
+        return bin;
+    }
+
+    octave = (bin >> HIST_SUB_BITS) - 1;
+    sub = bin & (HIST_SUB_COUNT - 1);
+    return (uint32_t)(HIST_SUB_COUNT + sub) << octave;
+}
+
+void hist_add(struct log_hist *h, uint32_t value)
+{
+    h->bins[hist_bin(value)]++;
+    h->count++;
+    if (value > h->max) {
+        h->max = value;
+    }
+}
+
+uint32_t hist_percentile(const struct log_hist *h, uint8_t percent)
+{
+    uint32_t target;
+    uint32_t seen = 0;
+    uint8_t i;
+
+    if (h->count == 0) {
+        return 0;
+    }
+
+    /* Rank of the sample we want (1-based, rounded up) */
+    target = (uint32_t)(((uint64_t)h->count * percent + 99) / 100);
+    if (target == 0) {
+        target = 1;
+    }
+
+    for (i = 0; i < HIST_BINS; i++) {
+        seen += h->bins[i];
+        if (seen >= target) {
+            /* Upper bound of this bin, never above the observed max */
+            uint32_t upper = (i + 1 < HIST_BINS) ? hist_bin_floor(i + 1) - 1 : h->max;
+            return (upper < h->max) ? upper : h->max;
+        }
+    }
+
+    return h->max;
+}
@@ -0,0 +1,73 @@
+/* ==================================================
+ * Log-Scale Histogram
+ * Cheap fixed-size latency histograms with percentile
+ * readout (4 sub-buckets per power of two)
+ * ================================================== */
+
+#ifndef HIST_H
+#define HIST_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * CONFIGURATION
+ * ================================================== */
+
+#define HIST_SUB_BITS           2           /* 4 sub-buckets per octave (~19% error) */
+#define HIST_BINS               80          /* Covers values up to 2^21 */
+
+/* ==================================================
+ * DATA STRUCTURES
+ * ================================================== */
+
+struct log_hist {
+    uint32_t count;                 /* Total samples */
+    uint32_t max;                   /* Largest sample seen */
+    uint32_t bins[HIST_BINS];
+};
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Clear all bins
+ *
+ * @param h: Histogram
+ */
+void hist_reset(struct log_hist *h);
+
+/**
+ * Add one sample (values past the last bin land in it)
+ *
+ * @param h: Histogram
+ * @param value: Sample value (any unit)
+ */
+void hist_add(struct log_hist *h, uint32_t value);
+
+/**
+ * Estimate a percentile
+ *
+ * @param h: Histogram
+ * @param percent: 0-100
+ * @return: Upper bound of the bin holding the percentile (0 if empty)
+ */
+uint32_t hist_percentile(const struct log_hist *h, uint8_t percent);
+
+/**
+ * Map a value to its bin index
+ *
+ * @param value: Sample value
+ * @return: Bin index 0..HIST_BINS-1
+ */
+uint8_t hist_bin(uint32_t value);
+
+/**
+ * Smallest value that maps to a bin
+ *
+ * @param bin: Bin index
+ * @return: Lower bound of the bin
+ */
+uint32_t hist_bin_floor(uint8_t bin);
+
+#endif /* HIST_H */
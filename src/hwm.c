@@ -0,0 +1,111 @@
+/* ==================================================
+ * Memory High-Water Marks Implementation
+ *
+ * Stack: hwm_init() fills STACK_PAINT_BYTES below its
+ * own frame with a pattern. Anything that later runs
+ * deeper overwrites it, so the lowest word that no
+ * longer holds the pattern marks the deepest use. The
+ * scan runs on request only (heartbeat, GET_MEMORY).
+ * ================================================== */
+
+#include "hwm.h"
+#include "user_config.h"
+#include "uart.h"
+#include "txq.h"
+#include "ets_sys.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+#define HWM_PAINT_WORD          0xA5A5A5A5
+
+/* Left unpainted just below hwm_init()'s frame, for its own calls */
+#define HWM_PAINT_GUARD         256
+
+#ifndef HOST_BUILD
+/* End of dram0 (linker script): the stack lies above it */
+#define HWM_STACK_FLOOR         0x3FFFC000
+#endif
+
+#if STACK_PAINT_BYTES % 4 != 0 || STACK_PAINT_BYTES > 16384
+#error "STACK_PAINT_BYTES must be a multiple of 4, at most 16384"
+#endif
+
+/* ==================================================
+ * STATE
+ * ================================================== */
+
+/* Painted words [stack_lo, stack_hi) */
+static volatile uint32_t *stack_lo = NULL;
+static volatile uint32_t *stack_hi = NULL;
+
+static uint32_t heap_min = 0xFFFFFFFF;
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void ICACHE_FLASH_ATTR hwm_init(void)
+{
+#if STACK_PAINT_BYTES > 0
+    uint32_t marker;
+    uintptr_t hi = ((uintptr_t)&marker - HWM_PAINT_GUARD) & ~(uintptr_t)3;
+    uintptr_t lo = hi - STACK_PAINT_BYTES;
+    volatile uint32_t *p;
+
+#ifdef HWM_STACK_FLOOR
+    if (lo < HWM_STACK_FLOOR) {
+        lo = HWM_STACK_FLOOR;
+    }
+#endif
+
+    /* Interrupt handlers run on this stack: none may push a frame
+     * into the region while it is being painted */
+    ETS_INTR_LOCK();
+    for (p = (volatile uint32_t *)lo; p < (volatile uint32_t *)hi; p++) {
+        *p = HWM_PAINT_WORD;
+    }
+    ETS_INTR_UNLOCK();
+
+    stack_lo = (volatile uint32_t *)lo;
+    stack_hi = (volatile uint32_t *)hi;
+#endif
+
+    heap_min = system_get_free_heap_size();
+}
+
+void ICACHE_FLASH_ATTR hwm_poll(void)
+{
+    uint32_t heap = system_get_free_heap_size();
+
+    if (heap < heap_min) {
+        heap_min = heap;
+    }
+}
+
+uint32_t ICACHE_FLASH_ATTR hwm_get_heap_min(void)
+{
+    return heap_min;
+}
+
+uint16_t ICACHE_FLASH_ATTR hwm_get_stack_painted(void)
+{
+    return (stack_hi - stack_lo) * 4;
+}
+
+uint16_t ICACHE_FLASH_ATTR hwm_get_stack_used(void)
+{
+    volatile uint32_t *p = stack_lo;
+
+    /* The stack grows down: untouched words are at the bottom */
+    while (p < stack_hi && *p == HWM_PAINT_WORD) {
+        p++;
+    }
+    return (stack_hi - p) * 4;
+}
+
+void ICACHE_FLASH_ATTR hwm_reset(void)
+{
+    heap_min = system_get_free_heap_size();
+    uart_reset_ring_peaks();
+    txq_reset_peaks();
+}
@@ -0,0 +1,58 @@
+/* ==================================================
+ * Memory High-Water Marks
+ * Minimum free heap, deepest stack use (painted
+ * region) and, through uart.c and txq.c, the peak
+ * occupancy of the UART rings and TX queues
+ * ================================================== */
+
+#ifndef HWM_H
+#define HWM_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Paint the stack region and take the first heap sample
+ * Call first thing in user_init(), while the stack is shallow.
+ */
+void hwm_init(void);
+
+/**
+ * Sample the free heap (main timer tick)
+ */
+void hwm_poll(void);
+
+/**
+ * Get the lowest free heap seen
+ *
+ * @return: Bytes, since boot or the last hwm_reset()
+ */
+uint32_t hwm_get_heap_min(void);
+
+/**
+ * Get the size of the painted stack region
+ *
+ * @return: Bytes (0 = stack check off)
+ */
+uint16_t hwm_get_stack_painted(void);
+
+/**
+ * Get the deepest stack use below user_init()'s frame
+ * Scans the painted region for the lowest overwritten word.
+ * Equal to the painted size means the region was exhausted:
+ * the real depth is unknown and may be larger.
+ *
+ * @return: Bytes of the painted region used since boot
+ */
+uint16_t hwm_get_stack_used(void);
+
+/**
+ * Restart the heap minimum and the ring and queue peaks
+ * (the stack mark cannot be repainted safely and stays)
+ */
+void hwm_reset(void);
+
+#endif /* HWM_H */
@@ -0,0 +1,53 @@
+/* ==================================================
+ * Pipeline Latency Histograms Implementation
+ * ================================================== */
+
+#include "latency.h"
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+#if LATENCY_HIST_ENABLED
+/* Each stage is fed from one context only (ISR or task) */
+static struct log_hist lat_hist[LAT_STAGE_COUNT];
+#endif
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void latency_add(uint8_t stage, uint32_t cycles)
+{
+#if LATENCY_HIST_ENABLED
+    hist_add(&lat_hist[stage], cycles >> LAT_CYCLE_SHIFT);
+#endif
+}
+
+void latency_add_us(uint8_t stage, uint32_t us)
+{
+#if LATENCY_HIST_ENABLED
+    hist_add(&lat_hist[stage], us * LAT_UNITS_PER_US);
+#endif
+}
+
+const struct log_hist *latency_get_hist(uint8_t stage)
+{
+#if LATENCY_HIST_ENABLED
+    if (stage < LAT_STAGE_COUNT) {
+        return &lat_hist[stage];
+    }
+#endif
+    return NULL;
+}
+
+void latency_reset(void)
+{
+#if LATENCY_HIST_ENABLED
+    uint8_t i;
+
+    for (i = 0; i < LAT_STAGE_COUNT; i++) {
+        hist_reset(&lat_hist[i]);
+    }
+#endif
+}
@@ -0,0 +1,81 @@
+/* ==================================================
+ * Pipeline Latency Histograms
+ * One log-scale histogram per stage of the UART <-> air
+ * path, fed from CCOUNT (or the existing microsecond
+ * timestamps). Sample points compile out entirely with
+ * LATENCY_HIST_ENABLED = 0.
+ * ================================================== */
+
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include "c_types.h"
+#include "user_config.h"
+#include "hist.h"
+#include "cycles.h"
+
+/* ==================================================
+ * STAGES
+ * ================================================== */
+
+enum lat_stage {
+    LAT_UART_RX,        /* UART first byte -> frame complete (RX ISR) */
+    LAT_TX_QUEUE,       /* Frame complete -> leaves the deadline queue */
+    LAT_AGG_HOLD,       /* First record packed -> wifi_send_pkt_freedom() */
+    LAT_TX_AIR,         /* wifi_send_pkt_freedom() -> TX done callback */
+    LAT_RX_PROCESS,     /* Promiscuous RX callback -> UART ring enqueue */
+    LAT_UART_TX,        /* UART ring enqueue -> last byte out of the FIFO */
+    LAT_STAGE_COUNT
+};
+
+/* Histogram unit: 8 cycles = 0.1 us at 80 MHz */
+#define LAT_CYCLE_SHIFT         3
+#define LAT_UNITS_PER_US        10
+
+#if CPU_CYCLES_PER_US != (LAT_UNITS_PER_US << LAT_CYCLE_SHIFT)
+#error "LAT_CYCLE_SHIFT assumes an 80 MHz CPU clock"
+#endif
+
+/* Sample points: no code at all when disabled */
+#if LATENCY_HIST_ENABLED
+#define LAT_CYCLES(stage, cycles)   latency_add((stage), (cycles))
+#define LAT_US(stage, us)           latency_add_us((stage), (us))
+#else
+#define LAT_CYCLES(stage, cycles)   do {} while (0)
+#define LAT_US(stage, us)           do {} while (0)
+#endif
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Add a sample measured in CPU cycles (ISR-safe)
+ *
+ * @param stage: enum lat_stage
+ * @param cycles: Elapsed CCOUNT cycles
+ */
+void latency_add(uint8_t stage, uint32_t cycles);
+
+/**
+ * Add a sample measured in microseconds (ISR-safe)
+ *
+ * @param stage: enum lat_stage
+ * @param us: Elapsed microseconds
+ */
+void latency_add_us(uint8_t stage, uint32_t us);
+
+/**
+ * Get a stage histogram (values in 0.1 us units)
+ *
+ * @param stage: enum lat_stage
+ * @return: Histogram, or NULL for an unknown stage
+ */
+const struct log_hist *latency_get_hist(uint8_t stage);
+
+/**
+ * Clear all stage histograms
+ */
+void latency_reset(void);
+
+#endif /* LATENCY_H */
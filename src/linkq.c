@@ -0,0 +1,210 @@
+/* ==================================================
+ * Link Quality Estimator Implementation
+ *
+ * Loss: sequence gaps counted over fixed windows (the
+ * previous full window is reported). RSSI: EWMA, alpha
+ * 1/8. Jitter: EWMA (1/16) of the change between
+ * consecutive inter-arrival times, as in RFC 3550.
+ * ================================================== */
+
+#include "linkq.h"
+#include "user_config.h"
+#include "links.h"
+#include "ctrl.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+/* 802.11 sequence numbers are 12 bits */
+#define SEQ_MASK                0x0FFF
+
+/* ==================================================
+ * STATE
+ * ================================================== */
+
+struct linkq_state {
+    uint8_t active;             /* At least one frame received */
+    uint16_t last_seq;
+    uint32_t last_us;           /* Arrival of the last frame */
+    uint32_t last_gap_us;       /* Previous inter-arrival time */
+    int16_t rssi_x16;           /* RSSI EWMA, 1/16 dBm */
+    uint32_t jitter_x16;        /* Jitter EWMA, 1/16 us */
+
+    /* Current loss window */
+    uint32_t win_start_us;
+    uint16_t win_rx;
+    uint16_t win_lost;
+    uint16_t loss_permille;     /* Last full window */
+};
+
+static struct linkq_state linkq_links[LINK_ID_COUNT];
+
+static uint32_t linkq_report_us = 0;
+static uint16_t linkq_report_ms = LINKQ_REPORT_MS;
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+/**
+ * Close the loss window if it has run its length
+ */
+static void linkq_roll_window(struct linkq_state *q, uint32_t now)
+{
+    uint32_t total;
+
+    if (now - q->win_start_us < LINKQ_WINDOW_MS * 1000) {
+        return;
+    }
+
+    total = q->win_rx + q->win_lost;
+    if (total > 0) {
+        q->loss_permille = q->win_lost * 1000 / total;
+    }
+
+    q->win_start_us = now;
+    q->win_rx = 0;
+    q->win_lost = 0;
+}
+
+/**
+ * Combine RSSI, loss and silence into 0-100 (weakest factor wins)
+ */
+static uint8_t linkq_score(const struct linkq_report *r)
+{
+    int32_t rssi_score;
+    int32_t loss_score;
+
+    if (r->age_ms > LINKQ_TIMEOUT_MS) {
+        return 0;
+    }
+
+    rssi_score = (r->rssi - LINKQ_RSSI_FLOOR) * 100 / (LINKQ_RSSI_GOOD - LINKQ_RSSI_FLOOR);
+    if (rssi_score < 0) {
+        rssi_score = 0;
+    } else if (rssi_score > 100) {
+        rssi_score = 100;
+    }
+
+    /* 50% loss or worse scores 0 */
+    loss_score = 100 - r->loss_permille / 5;
+    if (loss_score < 0) {
+        loss_score = 0;
+    }
+
+    return (rssi_score < loss_score) ? rssi_score : loss_score;
+}
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void linkq_init(void)
+{
+    os_memset(linkq_links, 0, sizeof(linkq_links));
+    linkq_report_us = system_get_time();
+}
+
+void linkq_rx(uint8_t link, uint16_t seq, int8_t rssi, uint32_t now)
+{
+    struct linkq_state *q;
+    uint16_t gap;
+    uint32_t arrival_gap;
+    uint32_t delta;
+
+    if (link >= LINK_ID_COUNT) {
+        return;
+    }
+
+    q = &linkq_links[link];
+    seq &= SEQ_MASK;
+
+    /* First frame seeds the averages */
+    if (!q->active) {
+        q->active = 1;
+        q->last_seq = seq;
+        q->last_us = now;
+        q->last_gap_us = 0;
+        q->rssi_x16 = rssi * 16;
+        q->jitter_x16 = 0;
+        q->win_start_us = now;
+        q->win_rx = 1;
+        q->win_lost = 0;
+        q->loss_permille = 0;
+        return;
+    }
+
+    linkq_roll_window(q, now);
+
+    /* Frames missing between the last sequence number and this one
+     * (a jump back or a huge jump means the sender restarted) */
+    gap = (seq - q->last_seq) & SEQ_MASK;
+    if (gap > 1 && gap <= LINKQ_MAX_GAP) {
+        q->win_lost += gap - 1;
+    }
+    q->win_rx++;
+    q->last_seq = seq;
+
+    q->rssi_x16 += (rssi * 16 - q->rssi_x16) / 8;
+
+    /* Jitter: change in inter-arrival time */
+    arrival_gap = now - q->last_us;
+    delta = (arrival_gap > q->last_gap_us) ? arrival_gap - q->last_gap_us
+                                           : q->last_gap_us - arrival_gap;
+    q->jitter_x16 += delta - (q->jitter_x16 >> 4);
+    q->last_gap_us = arrival_gap;
+    q->last_us = now;
+}
+
+bool linkq_get(uint8_t link, struct linkq_report *report)
+{
+    struct linkq_state *q;
+    uint32_t now = system_get_time();
+    uint32_t age_ms;
+
+    os_memset(report, 0, sizeof(*report));
+
+    if (link >= LINK_ID_COUNT || !linkq_links[link].active) {
+        report->age_ms = 0xFFFF;
+        return false;
+    }
+
+    q = &linkq_links[link];
+    linkq_roll_window(q, now);
+
+    age_ms = (now - q->last_us) / 1000;
+    report->age_ms = (age_ms > 0xFFFF) ? 0xFFFF : age_ms;
+    report->rssi = q->rssi_x16 / 16;
+    report->loss_permille = q->loss_permille;
+    report->jitter_us = ((q->jitter_x16 >> 4) > 0xFFFF) ? 0xFFFF : (q->jitter_x16 >> 4);
+    report->score = linkq_score(report);
+    return true;
+}
+
+void linkq_poll(void)
+{
+    uint32_t now = system_get_time();
+    uint8_t link;
+
+    if (linkq_report_ms == 0 || now - linkq_report_us < linkq_report_ms * 1000UL) {
+        return;
+    }
+    linkq_report_us = now;
+
+    /* One report per configured link that has ever been heard */
+    for (link = 0; link < LINK_ID_COUNT; link++) {
+        if (linkq_links[link].active && links_get_bssid(link) != NULL) {
+            ctrl_send_linkq(link);
+        }
+    }
+}
+
+void linkq_set_report_ms(uint16_t interval_ms)
+{
+    linkq_report_ms = interval_ms;
+    linkq_report_us = system_get_time();
+}
+
+uint16_t linkq_get_report_ms(void)
+{
+    return linkq_report_ms;
+}
@@ -0,0 +1,72 @@
+/* ==================================================
+ * Link Quality Estimator
+ * Per-link loss rate, RSSI and jitter from accepted
+ * frames, condensed into a 0-100 score for failsafe
+ * ================================================== */
+
+#ifndef LINKQ_H
+#define LINKQ_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * TYPES
+ * ================================================== */
+
+/* Snapshot of one link */
+struct linkq_report {
+    uint8_t score;              /* 0 (no link) .. 100 */
+    int8_t rssi;                /* RSSI EWMA (dBm) */
+    uint16_t loss_permille;     /* Sequence-gap loss, last full window */
+    uint16_t jitter_us;         /* Inter-arrival jitter EWMA */
+    uint16_t age_ms;            /* Since last frame (saturates) */
+};
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Reset all links
+ */
+void linkq_init(void);
+
+/**
+ * Account one accepted frame (RX callback - constant work)
+ *
+ * @param link: Link ID
+ * @param seq: 12-bit sequence number
+ * @param rssi: RxControl.rssi
+ * @param now: system_get_time()
+ */
+void linkq_rx(uint8_t link, uint16_t seq, int8_t rssi, uint32_t now);
+
+/**
+ * Get a snapshot of one link
+ *
+ * @param link: Link ID
+ * @param report: Receives the snapshot
+ * @return: false if nothing was ever received on the link
+ */
+bool linkq_get(uint8_t link, struct linkq_report *report);
+
+/**
+ * Push reports to the flight controller (call from the main timer)
+ */
+void linkq_poll(void);
+
+/**
+ * Set the push interval
+ *
+ * @param interval_ms: Milliseconds between pushes (0 = on request only)
+ */
+void linkq_set_report_ms(uint16_t interval_ms);
+
+/**
+ * Get the push interval
+ *
+ * @return: Milliseconds between pushes (0 = on request only)
+ */
+uint16_t linkq_get_report_ms(void);
+
+#endif /* LINKQ_H */
@@ -0,0 +1,164 @@
+/* ==================================================
+ * Link Table Implementation
+ *
+ * The RX callback reads a prebuilt hash pattern. Changes
+ * rebuild the inactive copy and then swap one pointer, so
+ * the callback never sees a half-built table.
+ * ================================================== */
+
+#include "links.h"
+#include "user_config.h"
+#include "wifi_raw.h"
+#include "osapi.h"
+
+#if (RX_LINK_SLOTS & (RX_LINK_SLOTS - 1)) || RX_LINK_SLOTS < 2 * LINK_MAX_COUNT
+#error "RX_LINK_SLOTS must be a power of 2 and at least 2 * LINK_MAX_COUNT"
+#endif
+
+#if LINK_ID_COUNT > (UART_LEN_LINK_MASK >> UART_LEN_LINK_SHIFT) + 1
+#error "LINK_ID_COUNT does not fit the UART link tag"
+#endif
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+struct link_entry {
+    uint8_t bssid[6];
+    uint8_t used;
+    uint32_t rx_count;
+};
+
+static struct link_entry link_table[LINK_ID_COUNT];
+static uint8_t link_count = 0;
+
+/* Double-buffered RX pattern */
+static struct rx_match link_match[2];
+static const struct rx_match * volatile link_match_active = &link_match[0];
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+/**
+ * Rebuild the inactive pattern from the table and make it active
+ */
+static void links_rebuild(void)
+{
+    struct rx_match *next = (link_match_active == &link_match[0]) ? &link_match[1] : &link_match[0];
+    uint8_t i;
+
+    rx_match_init(next, IEEE80211_FCTL_FTYPE | IEEE80211_FCTL_STYPE, IEEE80211_FC_PROBE_REQ);
+    for (i = 0; i < LINK_ID_COUNT; i++) {
+        if (link_table[i].used) {
+            rx_match_add(next, link_table[i].bssid, i);
+        }
+    }
+
+    link_match_active = next;
+
+    /* The SDK hardware filter holds one address only: lift it for
+     * several links, otherwise re-install it on the (new) address.
+     * Re-installing also restarts the check that it passes frames. */
+    wifi_raw_refresh_hw_filter();
+}
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void links_init(void)
+{
+    static const uint8_t default_bssid[6] = CUSTOM_BSSID;
+
+    os_memset(link_table, 0, sizeof(link_table));
+    link_count = 0;
+    links_set(0, default_bssid);
+}
+
+bool links_set(uint8_t link, const uint8_t *bssid)
+{
+    uint8_t i;
+
+    if (link >= LINK_ID_COUNT) {
+        return false;
+    }
+
+    /* One BSSID maps to one link */
+    for (i = 0; i < LINK_ID_COUNT; i++) {
+        if (i != link && link_table[i].used && os_memcmp(link_table[i].bssid, bssid, 6) == 0) {
+            return false;
+        }
+    }
+
+    if (!link_table[link].used) {
+        if (link_count >= LINK_MAX_COUNT) {
+            return false;
+        }
+        link_count++;
+        link_table[link].used = 1;
+        link_table[link].rx_count = 0;
+    }
+
+    os_memcpy(link_table[link].bssid, bssid, 6);
+    links_rebuild();
+    return true;
+}
+
+bool links_remove(uint8_t link)
+{
+    if (link >= LINK_ID_COUNT || !link_table[link].used) {
+        return false;
+    }
+
+    link_table[link].used = 0;
+    link_count--;
+    links_rebuild();
+    return true;
+}
+
+const uint8_t *links_get_bssid(uint8_t link)
+{
+    if (link >= LINK_ID_COUNT || !link_table[link].used) {
+        return NULL;
+    }
+    return link_table[link].bssid;
+}
+
+const uint8_t *links_get_sole_bssid(void)
+{
+    uint8_t i;
+
+    if (link_count != 1) {
+        return NULL;
+    }
+
+    for (i = 0; i < LINK_ID_COUNT; i++) {
+        if (link_table[i].used) {
+            return link_table[i].bssid;
+        }
+    }
+    return NULL;
+}
+
+uint8_t links_count(void)
+{
+    return link_count;
+}
+
+const struct rx_match *links_get_match(void)
+{
+    return link_match_active;
+}
+
+void links_note_rx(uint8_t link)
+{
+    if (link < LINK_ID_COUNT) {
+        link_table[link].rx_count++;
+    }
+}
+
+uint32_t links_get_rx_count(uint8_t link)
+{
+    return (link < LINK_ID_COUNT) ? link_table[link].rx_count : 0;
+}
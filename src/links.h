@@ -0,0 +1,86 @@
+/* ==================================================
+ * Link Table
+ * Accepted BSSIDs by link ID. A single aircraft uses
+ * link 0 only; a ground station adds one link per
+ * aircraft and demultiplexes by the UART link tag.
+ * ================================================== */
+
+#ifndef LINKS_H
+#define LINKS_H
+
+#include "c_types.h"
+#include "rx_filter.h"
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Initialize the table with link 0 = CUSTOM_BSSID
+ */
+void links_init(void);
+
+/**
+ * Add a link or change its BSSID
+ *
+ * @param link: Link ID (0..LINK_ID_COUNT-1)
+ * @param bssid: 6-byte BSSID
+ * @return: true on success, false if the ID is invalid, the BSSID
+ *          belongs to another link, or the table is full
+ */
+bool links_set(uint8_t link, const uint8_t *bssid);
+
+/**
+ * Remove a link
+ *
+ * @param link: Link ID
+ * @return: true if the link existed
+ */
+bool links_remove(uint8_t link);
+
+/**
+ * Get the BSSID of a link (TX header)
+ *
+ * @param link: Link ID
+ * @return: 6-byte BSSID, or NULL if the link is not configured
+ */
+const uint8_t *links_get_bssid(uint8_t link);
+
+/**
+ * Get the BSSID when exactly one link is configured
+ * (the SDK hardware filter can only match one address)
+ *
+ * @return: 6-byte BSSID, or NULL for zero or several links
+ */
+const uint8_t *links_get_sole_bssid(void);
+
+/**
+ * Get number of configured links
+ *
+ * @return: Link count
+ */
+uint8_t links_count(void);
+
+/**
+ * Get the active RX match pattern (read from the RX callback)
+ *
+ * @return: Pattern with every configured BSSID
+ */
+const struct rx_match *links_get_match(void);
+
+/**
+ * Count a frame accepted on a link
+ *
+ * @param link: Link ID from rx_match_header()
+ */
+void links_note_rx(uint8_t link);
+
+/**
+ * Get frames received on a link
+ *
+ * @param link: Link ID
+ * @return: Accepted frames
+ */
+uint32_t links_get_rx_count(uint8_t link);
+
+#endif /* LINKS_H */
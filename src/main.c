@@ -5,8 +5,8 @@
  *          between UART (RP2040) and 802.11 (WiFi)
  *
  * Architecture:
- *   UART RX → Length-prefixed packets → WiFi TX
- *   WiFi RX → BSSID filter → UART TX
+ *   UART RX → Length-prefixed packets → Deadline queue → Aggregator → WiFi TX
+ *   WiFi RX → BSSID filter → Split records → UART TX
  *
  * The ESP does NOT:
  *   - Interpret encrypted data
@@ -22,6 +22,26 @@
 #include "user_config.h"
 #include "uart.h"
 #include "wifi_raw.h"
+#include "aggregate.h"
+#include "txq.h"
+#include "airtime.h"
+#include "ctrl.h"
+#include "txpower.h"
+#include "links.h"
+#include "dedup.h"
+#include "linkq.h"
+#include "survey.h"
+#include "fhss.h"
+#include "tdma.h"
+#include "latency.h"
+#include "trace.h"
+#include "ping.h"
+#include "trafgen.h"
+#include "sniffer.h"
+#include "hwm.h"
+#include "rates.h"
+#include "cycles.h"
+#include "rx_filter.h"
 #include "gpio.h"
 
 /* ==================================================
@@ -45,6 +65,503 @@ static const partition_item_t partition_table[] = {
 /* Packet assembly buffer for length-prefixed reads */
 static uint8_t packet_buffer[MAX_PACKET_SIZE];
 
+/* ==================================================
+ * UART → WIFI BRIDGE
+ * ================================================== */
+
+/* Task queue for running the bridge right after a TX completes */
+#define BRIDGE_TASK_PRIO        USER_TASK_PRIO_1
+#define BRIDGE_TASK_QUEUE_LEN   2
+
+static os_event_t bridge_task_queue[BRIDGE_TASK_QUEUE_LEN];
+static volatile uint8_t bridge_task_pending = 0;
+
+/**
+ * Parse UART frames into the TX queue, then feed the radio
+ *
+ * Protocol: [LEN_HI][LEN_LO][payload...], class in LEN_HI bit 7,
+ * local (command for this ESP) in bit 6, link ID in bits 5..1
+ * State machine persists across calls via static vars.
+ * Every complete frame is queued with the time its last byte
+ * arrived, so txq can drop it if it goes stale before TX.
+ */
+static void ICACHE_FLASH_ATTR bridge_service(void)
+{
+    static uint16_t pkt_expected = 0;  /* Payload length from prefix (0 = waiting for header) */
+    static uint16_t pkt_received = 0;  /* Bytes accumulated so far */
+    static uint8_t pkt_class = TC_BULK; /* Traffic class from LEN_HI */
+    static bool pkt_local = false;      /* Command for this ESP, not for air */
+    static uint8_t pkt_link = 0;        /* Link ID (BSSID to send on) */
+
+    for (;;) {
+        if (pkt_expected == 0) {
+            /* Waiting for 2-byte length prefix */
+            if (uart_rx_available() < 2) {
+                break;
+            }
+
+            uint8_t len_bytes[2];
+            uart_read_bytes(len_bytes, 2);
+            pkt_expected = UART_FRAME_LEN(len_bytes[0], len_bytes[1]);
+            pkt_class = UART_FRAME_CLASS(len_bytes[0]);
+            pkt_local = UART_FRAME_IS_LOCAL(len_bytes[0]);
+            pkt_link = UART_FRAME_LINK(len_bytes[0]);
+            pkt_received = 0;
+
+            if (pkt_expected == 0 || pkt_expected > MAX_PACKET_SIZE) {
+                if (pkt_expected > MAX_PACKET_SIZE) {
+                    DEBUG_PRINTF("UART: bad length %u\n", pkt_expected);
+                    TRACE(TRACE_EV_UART_RESYNC, len_bytes[0], pkt_expected);
+                }
+                pkt_expected = 0;
+                continue;
+            }
+        }
+
+        /* Accumulate payload bytes */
+        uint16_t remaining = pkt_expected - pkt_received;
+        uint16_t avail = uart_rx_available();
+        uint16_t to_read = (avail < remaining) ? avail : remaining;
+
+        if (to_read > 0) {
+            pkt_received += uart_read_bytes(packet_buffer + pkt_received, to_read);
+        }
+
+        if (pkt_received < pkt_expected) {
+            break;  /* Rest of payload not here yet */
+        }
+
+        /* Complete packet — timestamp from the RX ISR, else now */
+        uint32_t arrival = system_get_time();
+        uart_rx_frame_time(&arrival);
+
+        if (pkt_local) {
+            ctrl_uart_rx(packet_buffer, pkt_expected);
+        } else {
+            txq_push(pkt_class, pkt_link, packet_buffer, pkt_expected, arrival);
+            DEBUG_PRINTF("UART->WiFi: %u bytes class %u link %u\n", pkt_expected, pkt_class, pkt_link);
+        }
+        pkt_expected = 0;
+        pkt_received = 0;
+    }
+
+    /* Held echo first, then test traffic and fresh frames, while the radio is free */
+    ping_pump();
+    trafgen_pump();
+    txq_pump();
+}
+
+/**
+ * Bridge task - runs bridge_service() outside the TX callback
+ */
+static void ICACHE_FLASH_ATTR bridge_task(os_event_t *event)
+{
+    bridge_task_pending = 0;
+    bridge_service();
+}
+
+/**
+ * TX-complete hook: schedule the next frame without waiting
+ * for the next timer tick
+ */
+static void bridge_tx_done(void)
+{
+    if (!bridge_task_pending) {
+        bridge_task_pending = 1;
+        system_os_post(BRIDGE_TASK_PRIO, 0, 0);
+    }
+}
+
+/* ==================================================
+ * STATISTICS REPORTING
+ * ================================================== */
+
+/**
+ * Print promiscuous callback cost per filter mode over the last window
+ * (only modes that were active during the window are printed)
+ */
+static void ICACHE_FLASH_ATTR rx_filter_report(void)
+{
+    static uint32_t last_calls[2];
+    static uint32_t last_cycles[2];
+    static uint32_t last_time_us[2];
+
+    uint32_t calls, cycles, time_us;
+    uint32_t d_calls, d_cycles, d_ms, cpu_permille;
+    uint8_t hw;
+
+    for (hw = 0; hw < 2; hw++) {
+        wifi_raw_get_rx_cb_stats(hw, &calls, &cycles, &time_us);
+
+        d_calls = calls - last_calls[hw];
+        d_cycles = cycles - last_cycles[hw];
+        d_ms = (time_us - last_time_us[hw]) / 1000;
+
+        last_calls[hw] = calls;
+        last_cycles[hw] = cycles;
+        last_time_us[hw] = time_us;
+
+        if (d_ms == 0) {
+            continue;
+        }
+
+        cpu_permille = (d_cycles / CPU_CYCLES_PER_US) / d_ms;
+        os_printf("[RX] filter=%s active=%u fallbacks=%u cb_per_s=%u avg_cyc=%u cpu=%u.%u%%\n",
+                 hw ? "hw" : "sw",
+                 wifi_raw_get_hw_filter() == (hw != 0) ? 1 : 0,
+                 wifi_raw_get_hw_filter_fallback_count(),
+                 d_calls * 1000 / d_ms,
+                 d_calls ? d_cycles / d_calls : 0,
+                 cpu_permille / 10, cpu_permille % 10);
+    }
+}
+
+/**
+ * Print the last RX callback profile window: load on the 80 MHz
+ * core, worst call, and average cycles per filter outcome
+ */
+static void ICACHE_FLASH_ATTR rx_profile_report(void)
+{
+    static const char *const names[RX_STAGE_COUNT + 1] = {
+        "phy", "type", "bssid", "dup", "len", "deliver", "accept"
+    };
+    const struct rx_profile *prof = wifi_raw_get_rx_profile();
+    uint32_t period_ms = prof->period_us / 1000;
+    uint32_t cpu_permille;
+    uint8_t i;
+
+    if (period_ms == 0) {
+        return;
+    }
+
+    cpu_permille = (prof->cycles / CPU_CYCLES_PER_US) / period_ms;
+    os_printf("[RXPROF] cb_per_s=%u cpu=%u.%u%% avg_cyc=%u max_cyc=%u\n",
+             prof->calls * 1000 / period_ms,
+             cpu_permille / 10, cpu_permille % 10,
+             prof->calls ? prof->cycles / prof->calls : 0,
+             prof->max_cycles);
+
+    os_printf("[RXPROF] calls/avg_cyc");
+    for (i = 0; i <= RX_STAGE_COUNT; i++) {
+        os_printf(" %s=%u/%u", names[i], prof->outcome_calls[i],
+                 prof->outcome_calls[i] ? prof->outcome_cycles[i] / prof->outcome_calls[i] : 0);
+    }
+    os_printf("\n");
+}
+
+/**
+ * Print per-stage pipeline latency (since boot or the last
+ * RESET_LATENCY), microseconds with one decimal
+ */
+static void ICACHE_FLASH_ATTR latency_report(void)
+{
+#if LATENCY_HIST_ENABLED
+    static const char *const names[LAT_STAGE_COUNT] = {
+        "uart_rx", "tx_queue", "agg_hold", "tx_air", "rx_cb", "uart_tx"
+    };
+    const struct log_hist *h;
+    uint32_t p50, p99;
+    uint8_t stage;
+
+    for (stage = 0; stage < LAT_STAGE_COUNT; stage++) {
+        h = latency_get_hist(stage);
+        p50 = hist_percentile(h, 50);
+        p99 = hist_percentile(h, 99);
+        os_printf("[LAT] %s n=%u p50=%u.%u p99=%u.%u max=%u.%u us\n",
+                 names[stage], h->count,
+                 p50 / LAT_UNITS_PER_US, p50 % LAT_UNITS_PER_US,
+                 p99 / LAT_UNITS_PER_US, p99 % LAT_UNITS_PER_US,
+                 h->max / LAT_UNITS_PER_US, h->max % LAT_UNITS_PER_US);
+    }
+#endif
+}
+
+/**
+ * Print hop timing: channel switch cost, timer lateness and the
+ * share of each dwell lost to them plus the TX guard
+ */
+static void ICACHE_FLASH_ATTR fhss_report(void)
+{
+    const struct fhss_stats *st = fhss_get_stats();
+    uint32_t switch_avg, late_avg, dead_permille;
+
+    if (fhss_get_state() == FHSS_STATE_OFF || st->hops == 0) {
+        return;
+    }
+
+    switch_avg = st->switch_us_total / st->hops;
+    late_avg = st->late_us_total / st->hops;
+    dead_permille = (FHSS_GUARD_US + switch_avg + late_avg) * 1000 / FHSS_DWELL_US;
+
+    os_printf("[FHSS] state=%u hop=%u ch=%u hops=%u acq=%u lost=%u reacq=%ums err=%dus\n",
+             fhss_get_state(), fhss_get_hop(), wifi_raw_get_channel(), st->hops,
+             st->acquisitions, st->losses, st->reacq_ms, st->sync_err_us);
+    os_printf("[FHSS] switch=%u/%uus late=%u/%uus dead=%u.%u%% (avg/max)\n",
+             switch_avg, st->switch_us_max, late_avg, st->late_us_max,
+             dead_permille / 10, dead_permille % 10);
+}
+
+/**
+ * Print TDMA schedule use over the last heartbeat window: how much
+ * of each slot carried frames, and how many frames overlapped the
+ * other end's slot (a collision if both were sending)
+ */
+static void ICACHE_FLASH_ATTR tdma_report(void)
+{
+    static struct tdma_stats last;
+    const struct tdma_stats *st = tdma_get_stats();
+    uint32_t own_permille = TDMA_LEADER ? TDMA_UPLINK_PERMILLE : 1000 - TDMA_UPLINK_PERMILLE;
+    uint32_t synced_ms = (st->synced_us - last.synced_us) / 1000;
+    uint32_t frames = (st->tx_frames - last.tx_frames) + (st->rx_frames - last.rx_frames);
+    uint32_t overlaps = (st->tx_off_slot - last.tx_off_slot) + (st->rx_off_slot - last.rx_off_slot);
+    uint32_t own_util = 0, peer_util = 0, overlap_permille = 0;
+
+    if (tdma_get_state() == TDMA_STATE_OFF) {
+        return;
+    }
+
+    /* Airtime (us) / slot time (ms * share / 1000 * 1000) = permille */
+    if (synced_ms > 0) {
+        own_util = (st->tx_airtime_us - last.tx_airtime_us) / synced_ms * 1000 / own_permille;
+        peer_util = (st->rx_airtime_us - last.rx_airtime_us) / synced_ms * 1000 / (1000 - own_permille);
+    }
+    if (frames > 0) {
+        overlap_permille = overlaps * 1000 / frames;
+    }
+
+    os_printf("[TDMA] state=%u acq=%u err=%dus own_util=%u.%u%% peer_util=%u.%u%% "
+             "overlap=%u.%u%% (tx %u rx %u)\n",
+             tdma_get_state(), st->acquisitions, st->sync_err_us,
+             own_util / 10, own_util % 10, peer_util / 10, peer_util % 10,
+             overlap_permille / 10, overlap_permille % 10,
+             st->tx_off_slot - last.tx_off_slot, st->rx_off_slot - last.rx_off_slot);
+
+    last = *st;
+}
+
+/**
+ * Print round-trip statistics of the current or last probe run,
+ * and the echo responder counters while it is on
+ */
+static void ICACHE_FLASH_ATTR ping_report(void)
+{
+    const struct ping_stats *st = ping_get_stats();
+    uint32_t echoed, dropped;
+    uint32_t done = st->received + st->lost;
+    uint32_t loss_permille = done ? st->lost * 1000 / done : 0;
+
+    if (ping_get_state() != PING_STATE_IDLE) {
+        os_printf("[PING] state=%u link=%u sent=%u recv=%u loss=%u.%u%% "
+                 "rtt min=%u avg=%u p99=%u max=%u us\n",
+                 ping_get_state(), ping_get_link(), st->sent, st->received,
+                 loss_permille / 10, loss_permille % 10,
+                 st->rtt_min_us, st->received ? st->rtt_total_us / st->received : 0,
+                 hist_percentile(&st->rtt_us, 99), st->rtt_us.max);
+    }
+
+    if (ping_get_echo()) {
+        ping_get_echo_counts(&echoed, &dropped);
+        os_printf("[ECHO] echoed=%u dropped=%u\n", echoed, dropped);
+    }
+}
+
+/**
+ * Print test traffic: generator progress while it has run, and
+ * the receiver measurement once test frames have arrived
+ */
+static void ICACHE_FLASH_ATTR trafgen_report(void)
+{
+    const struct trafgen_tx_stats *tx = trafgen_get_tx_stats();
+    const struct trafgen_rx_stats *rx = trafgen_get_rx_stats();
+    uint32_t pps, kbps, loss_permille;
+
+    if (trafgen_get_state() != TRAFGEN_STATE_IDLE) {
+        pps = tx->elapsed_us ? (uint32_t)((uint64_t)tx->sent * 1000000 / tx->elapsed_us) : 0;
+        os_printf("[TGEN] state=%u pattern=%u size=%u rate=%u sent=%u pps=%u busy=%u err=%u\n",
+                 trafgen_get_state(), trafgen_get_config()->pattern, trafgen_get_config()->size,
+                 trafgen_get_config()->rate_pps, tx->sent, pps, tx->busy, tx->errors);
+    }
+
+    if (rx->received > 0) {
+        kbps = rx->elapsed_us ? (uint32_t)((uint64_t)rx->bytes * 8000 / rx->elapsed_us) : 0;
+        loss_permille = rx->lost * 1000 / (rx->received + rx->lost);
+        os_printf("[TRX] run=%u recv=%u lost=%u loss=%u.%u%% reorder=%u kbps=%u jitter=%uus\n",
+                 rx->run, rx->received, rx->lost, loss_permille / 10, loss_permille % 10,
+                 rx->reordered, kbps, rx->jitter_us);
+    }
+}
+
+/**
+ * Print sniffer capture counters while it runs
+ */
+static void ICACHE_FLASH_ATTR sniffer_report(void)
+{
+    const struct sniffer_stats *st = sniffer_get_stats();
+
+    if (!sniffer_active()) {
+        return;
+    }
+
+    os_printf("[SNIFF] ch=%u frames=%u bytes=%u cut=%u skipped=%u batches=%u drops=%u\n",
+             wifi_raw_get_channel(), st->frames, st->bytes, st->cut, st->skipped,
+             st->batches, st->batch_drops);
+}
+
+/**
+ * Print the capacity model check for the last window: mean
+ * modeled and measured send-to-TX-complete time per frame
+ */
+static void ICACHE_FLASH_ATTR airtime_model_report(void)
+{
+    static struct airtime_model_stats last;
+    const struct airtime_model_stats *st = airtime_model_get_stats();
+    uint32_t frames = st->frames - last.frames;
+    uint32_t late = st->late - last.late;
+    uint32_t model_us = st->model_us - last.model_us;
+    uint32_t measured_us = st->measured_us - last.measured_us;
+    int32_t err_permille;
+
+    last = *st;
+    if (frames == late) {
+        return;
+    }
+
+    err_permille = (int32_t)(((int64_t)measured_us - model_us) * 1000 / model_us);
+    os_printf("[AIRMODEL] frames=%u late=%u model=%uus measured=%uus err=%s%d.%u%%\n",
+             frames, late, model_us / (frames - late), measured_us / (frames - late),
+             err_permille < 0 ? "-" : "+",
+             (err_permille < 0 ? -err_permille : err_permille) / 10,
+             (err_permille < 0 ? -err_permille : err_permille) % 10);
+}
+
+/**
+ * Print throughput averaged over the long rate window, drops summed
+ */
+static void ICACHE_FLASH_ATTR rates_report(void)
+{
+    uint32_t avg[RATE_COUNT];
+    uint32_t last_1s;
+    uint32_t sum;
+    uint8_t fill = rates_get_fill();
+    uint8_t i;
+
+    if (fill == 0) {
+        return;
+    }
+
+    for (i = 0; i < RATE_COUNT; i++) {
+        rates_get(i, &last_1s, &sum);
+        avg[i] = (i == RATE_DROPS) ? sum : sum / fill;
+    }
+
+    os_printf("[RATE] window=%us tx=%ufps/%uBps rx=%ufps/%uBps uart_in=%uBps uart_out=%uBps drops=%u\n",
+             fill, avg[RATE_TX_FRAMES], avg[RATE_TX_BYTES],
+             avg[RATE_RX_FRAMES], avg[RATE_RX_BYTES],
+             avg[RATE_UART_IN], avg[RATE_UART_OUT], avg[RATE_DROPS]);
+}
+
+/**
+ * Print heartbeat statistics (called every 5 seconds)
+ */
+static void ICACHE_FLASH_ATTR heartbeat_report(void)
+{
+    static uint32_t last_uart_frames = 0;
+    static uint32_t last_air_frames = 0;
+    static uint32_t last_airtime_us = 0;
+
+    uint32_t uart_frames = agg_get_tx_frame_count();
+    uint32_t air_frames = wifi_get_tx_count();
+    uint32_t airtime_us = wifi_get_tx_airtime_us();
+    uint8_t tc;
+    uint8_t link;
+
+    /* Airtime share of the 5 s window, in tenths of a percent */
+    uint32_t airtime_permille = (airtime_us - last_airtime_us) / 5000;
+
+    os_printf("[HEARTBEAT] heap=%u tx=%u txerr=%u rx=%u\n",
+             system_get_free_heap_size(),
+             wifi_get_tx_count(), wifi_get_tx_error_count(),
+             wifi_get_rx_count());
+
+    /* Where ambient traffic is rejected, cheapest stage first */
+    os_printf("[RXREJ] phy=%u type=%u bssid=%u dup=%u len=%u deliver=%u resync=%u\n",
+             wifi_get_rx_reject_count(RX_STAGE_PHY),
+             wifi_get_rx_reject_count(RX_STAGE_TYPE),
+             wifi_get_rx_reject_count(RX_STAGE_BSSID),
+             wifi_get_rx_reject_count(RX_STAGE_DUPLICATE),
+             wifi_get_rx_reject_count(RX_STAGE_LENGTH),
+             wifi_get_rx_reject_count(RX_STAGE_DELIVER),
+             dedup_get_resync_count());
+    os_printf("[LINK] uart_fps=%u air_fps=%u airtime=%u.%u%% tx_lost=%u rx_frames=%u rx_bad_agg=%u\n",
+             (uart_frames - last_uart_frames) / 5,
+             (air_frames - last_air_frames) / 5,
+             airtime_permille / 10, airtime_permille % 10,
+             agg_get_tx_lost_count(),
+             agg_get_rx_frame_count(), agg_get_rx_malformed_count());
+    rates_report();
+
+    /* High-water marks: what the buffers actually needed so far */
+    os_printf("[MEM] heap_min=%u stack=%u/%u rx=%u/%u tx=%u/%u txp=%u/%u txq=%u/%u,%u/%u\n",
+             hwm_get_heap_min(), hwm_get_stack_used(), hwm_get_stack_painted(),
+             uart_get_ring_peak(UART_RING_RX), UART_RX_BUFFER_SIZE,
+             uart_get_ring_peak(UART_RING_TX), UART_TX_BUFFER_SIZE,
+             uart_get_ring_peak(UART_RING_TX_PRIO), UART_TX_PRIO_BUFFER_SIZE,
+             txq_get_peak(TC_PRIORITY), TXQ_PRIO_DEPTH, txq_get_peak(TC_BULK), TXQ_BULK_DEPTH);
+
+    /* Bytes the UART lost and framing it had to recover */
+    os_printf("[UART] rx_ovf=%u tx_ovf=%u resync=%u tx_busy=%u oversize=%u\n",
+             uart_get_rx_overflow_count(), uart_get_tx_overflow_count(),
+             uart_get_rx_resync_count(), wifi_get_tx_busy_count(),
+             txq_get_oversize_drop_count());
+
+    last_uart_frames = uart_frames;
+    last_air_frames = air_frames;
+    last_airtime_us = airtime_us;
+
+    /* Per-class uplink latency (UART arrival → radio), microseconds */
+    for (tc = 0; tc < TC_COUNT; tc++) {
+        const struct log_hist *age = txq_get_age_hist(tc);
+        os_printf("[TXQ] class=%u sent=%u stale=%u full=%u superseded=%u p50=%u p90=%u p99=%u max=%u\n",
+                 tc, age->count,
+                 txq_get_stale_drop_count(tc), txq_get_full_drop_count(tc),
+                 txq_get_superseded_drop_count(tc),
+                 hist_percentile(age, 50), hist_percentile(age, 90),
+                 hist_percentile(age, 99), age->max);
+    }
+
+    /* Airtime budget: share of the allowance used this window */
+    os_printf("[AIRTIME] budget=%u%% used=%u%% tokens=%d drop=%u/%u defer=%u/%u\n",
+             AIRTIME_BUDGET_PERMILLE / 10,
+             airtime_permille * 100 / AIRTIME_BUDGET_PERMILLE,
+             airtime_budget_tokens(),
+             airtime_budget_get_drop_count(TC_PRIORITY), airtime_budget_get_drop_count(TC_BULK),
+             airtime_budget_get_defer_count(TC_PRIORITY), airtime_budget_get_defer_count(TC_BULK));
+    airtime_model_report();
+
+    os_printf("[TXPOWER] qdbm=%u auto=%u changes=%u peer_rssi=%d local_rssi=%d\n",
+             txpower_get(), txpower_get_auto() ? 1 : 0, txpower_get_change_count(),
+             txpower_get_peer_rssi(), txpower_get_local_rssi());
+
+    rx_filter_report();
+    rx_profile_report();
+    fhss_report();
+    tdma_report();
+    latency_report();
+    ping_report();
+    trafgen_report();
+    sniffer_report();
+
+    for (link = 0; link < LINK_ID_COUNT; link++) {
+        struct linkq_report q;
+
+        if (linkq_get(link, &q)) {
+            os_printf("[LINKQ] link=%u score=%u rssi=%d loss=%u.%u%% jitter=%uus age=%ums\n",
+                     link, q.score, q.rssi, q.loss_permille / 10, q.loss_permille % 10,
+                     q.jitter_us, q.age_ms);
+        }
+    }
+}
+
 /* ==================================================
  * TIMER FOR PERIODIC PROCESSING
  * ================================================== */
@@ -55,8 +572,8 @@ static os_timer_t main_timer;
  * Main processing callback (runs at MAIN_TIMER_PERIOD_MS rate)
  *
  * Tasks:
- * 1. Check for UART data (length-prefixed packets)
- * 2. Read complete packets and transmit over WiFi
+ * 1. LED blink and heartbeat statistics
+ * 2. Run the UART → WiFi bridge
  * 3. Feed watchdog if needed
  */
 static void ICACHE_FLASH_ATTR main_timer_callback(void *arg)
@@ -76,57 +593,36 @@ static void ICACHE_FLASH_ATTR main_timer_callback(void *arg)
     /* Heartbeat message every 5 seconds */
     heartbeat_counter++;
     if (heartbeat_counter >= 500) {  /* 500 * 10ms = 5 seconds */
-        os_printf("[HEARTBEAT] heap=%u tx=%u txerr=%u rx=%u rxdrop=%u\n",
-                 system_get_free_heap_size(),
-                 wifi_get_tx_count(), wifi_get_tx_error_count(),
-                 wifi_get_rx_count(), wifi_get_rx_drop_count());
+        heartbeat_report();
         heartbeat_counter = 0;
     }
 
-    /* UART → WiFi bridge: read length-prefixed packets, send over 802.11
-     * Protocol: [LEN_HI][LEN_LO][payload...]
-     * State machine persists across timer ticks via static vars
-     */
-    {
-        static uint16_t pkt_expected = 0;  /* Payload length from prefix (0 = waiting for header) */
-        static uint16_t pkt_received = 0;  /* Bytes accumulated so far */
+    /* RSSI reports to the peer and TX power loop timeout */
+    txpower_poll();
 
-        if (pkt_expected == 0) {
-            /* Waiting for 2-byte length prefix */
-            if (uart_rx_available() >= 2) {
-                uint8_t len_bytes[2];
-                uart_read_bytes(len_bytes, 2);
-                pkt_expected = (len_bytes[0] << 8) | len_bytes[1];
-                pkt_received = 0;
-
-                if (pkt_expected == 0 || pkt_expected > MAX_PACKET_SIZE) {
-                    if (pkt_expected > MAX_PACKET_SIZE) {
-                        DEBUG_PRINTF("UART: bad length %u\n", pkt_expected);
-                    }
-                    pkt_expected = 0;
-                }
-            }
-        }
+    /* Hardware RX filter probe */
+    wifi_raw_poll();
 
-        if (pkt_expected > 0) {
-            /* Accumulate payload bytes */
-            uint16_t remaining = pkt_expected - pkt_received;
-            uint16_t avail = uart_rx_available();
-            uint16_t to_read = (avail < remaining) ? avail : remaining;
+    /* Link quality reports to the flight controller */
+    linkq_poll();
 
-            if (to_read > 0) {
-                pkt_received += uart_read_bytes(packet_buffer + pkt_received, to_read);
-            }
+    /* Boot channel survey / follower channel hunt */
+    survey_poll();
 
-            /* Complete packet — send over WiFi */
-            if (pkt_received >= pkt_expected) {
-                wifi_raw_send(packet_buffer, pkt_expected);
-                DEBUG_PRINTF("UART->WiFi: %u bytes\n", pkt_expected);
-                pkt_expected = 0;
-                pkt_received = 0;
-            }
-        }
-    }
+    /* Round-trip probes, test traffic reports */
+    ping_poll();
+    trafgen_poll();
+
+    /* Partial sniffer batches */
+    sniffer_poll();
+
+    /* Minimum free heap */
+    hwm_poll();
+
+    /* Per-second throughput slots */
+    rates_poll();
+
+    bridge_service();
 }
 
 /* ==================================================
@@ -140,10 +636,55 @@ static void ICACHE_FLASH_ATTR main_timer_callback(void *arg)
  */
 static void ICACHE_FLASH_ATTR system_init_done(void)
 {
+    /* Accepted BSSIDs (link 0 = CUSTOM_BSSID), before the RX filter runs */
+    links_init();
+
     /* Initialize WiFi in raw mode (must be after system init) */
     wifi_raw_init(WIFI_DEFAULT_CHANNEL);
     os_printf("WiFi: Channel %u (raw mode active)\n", WIFI_DEFAULT_CHANNEL);
 
+    /* Measure channel load and move to the least busy one */
+    if (survey_start()) {
+        os_printf("Channel survey: %s\n", CHANNEL_SURVEY_LEADER ? "leader" : "follower");
+    }
+
+    /* UART frame aggregation (must match on both ends) */
+    agg_init();
+    os_printf("Aggregation: %s (max %u bytes, hold %u us)\n",
+              AGG_ENABLED ? "on" : "off", AGG_MAX_PAYLOAD, AGG_HOLD_TIME_US);
+
+    /* TX power (SDK default is never set otherwise) */
+    txpower_init();
+    os_printf("TX power: %u qdBm, auto %s\n", txpower_get(), txpower_get_auto() ? "on" : "off");
+
+    /* Per-node airtime budget enforced before injection */
+    airtime_budget_init();
+    os_printf("Airtime budget: %s (%u/1000 of channel, burst %u us)\n",
+              AIRTIME_BUDGET_ENABLED ? "on" : "off",
+              AIRTIME_BUDGET_PERMILLE, AIRTIME_BUDGET_BURST_US);
+
+    /* Uplink deadline queue, serviced on every TX completion */
+    txq_init();
+    system_os_task(bridge_task, BRIDGE_TASK_PRIO, bridge_task_queue, BRIDGE_TASK_QUEUE_LEN);
+    wifi_raw_set_tx_done_cb(bridge_tx_done);
+    os_printf("TX queues: prio %u slots/%u us, bulk %u slots/%u us\n",
+              TXQ_PRIO_DEPTH, TXQ_PRIO_MAX_AGE_US, TXQ_BULK_DEPTH, TXQ_BULK_MAX_AGE_US);
+
+    /* Frequency hopping; each hop releases frames held by the guard */
+    fhss_init(bridge_tx_done);
+
+    /* TDMA slots; each own slot releases frames held by the gate */
+    tdma_init(bridge_tx_done);
+
+    /* Over-the-air ping (echo responder off unless PING_ECHO_ENABLED) */
+    ping_init();
+
+    /* Traffic generator and receiver (idle until START_TRAFGEN) */
+    trafgen_init();
+
+    /* Raw sniffer (off until SET_SNIFFER) */
+    sniffer_init();
+
     /* Get and print MAC address */
     uint8_t mac[6];
     wifi_get_macaddr(STATION_IF, mac);
@@ -171,6 +712,12 @@ static void ICACHE_FLASH_ATTR system_init_done(void)
  */
 void ICACHE_FLASH_ATTR user_init(void)
 {
+    /* Microsecond os_timer resolution (FHSS hop timer), must come first */
+    system_timer_reinit();
+
+    /* Paint the stack for the high-water check while it is shallow */
+    hwm_init();
+
     /* Configure SDK's UART for os_printf() at 460800 baud */
     uart_div_modify(0, UART_CLK_FREQ / UART_BAUD_RATE);
 
@@ -0,0 +1,278 @@
+/* ==================================================
+ * Over-the-Air Ping Implementation
+ *
+ * A probe is one local aggregate record, [AIR_MSG_PING]
+ * [seq u16] padded to PING_PROBE_SIZE, sent straight to
+ * wifi_raw_send() on the probed link, uncharged to the
+ * airtime budget like the echo. The responder echoes
+ * the whole 802.11 payload, so the record comes
+ * back to our ctrl_air_rx(). Send times stay here, in a
+ * window indexed by sequence number; the CCOUNT delta
+ * at the echo is the round trip.
+ * ================================================== */
+
+#include "ping.h"
+#include "user_config.h"
+#include "wifi_raw.h"
+#include "links.h"
+#include "ctrl.h"
+#include "cycles.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+#if PING_PROBE_SIZE < 3 || PING_PROBE_SIZE > MAX_AIR_PAYLOAD_SIZE - AGG_RECORD_HEADER_SIZE
+#error "PING_PROBE_SIZE must be 3..MAX_AIR_PAYLOAD_SIZE - AGG_RECORD_HEADER_SIZE"
+#endif
+
+#if PING_TIMEOUT_MS > 50000
+#error "PING_TIMEOUT_MS must stay below the CCOUNT wrap (~53 s)"
+#endif
+
+/* Probes in flight tracked at once (bits of ping_pending) */
+#define PING_WINDOW             32
+#define PING_WINDOW_MASK        (PING_WINDOW - 1)
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+/* Echo responder: one frame held while the radio is busy */
+static bool ping_echo_on = false;
+static uint8_t echo_buffer[MAX_AIR_PAYLOAD_SIZE];
+static uint16_t echo_len = 0;
+static uint8_t echo_class = TC_BULK;
+static uint8_t echo_link = 0;
+static uint32_t echo_count = 0;
+static uint32_t echo_drop_count = 0;
+
+/* Probe run */
+static uint8_t ping_state = PING_STATE_IDLE;
+static uint8_t ping_link = 0;
+static uint16_t ping_count = 0;             /* 0 = until stopped */
+static uint32_t ping_interval_us = 0;
+static uint32_t ping_due_us = 0;
+static uint16_t ping_seq = 0;
+
+/* Probes in flight: send time and sequence per window slot */
+static uint32_t ping_pending = 0;
+static uint32_t ping_sent_cycles[PING_WINDOW];
+static uint16_t ping_sent_seq[PING_WINDOW];
+
+static struct ping_stats ping_stats;
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+/**
+ * Send one probe, stamping it just before injection
+ */
+static void ping_send_probe(void)
+{
+    uint8_t probe[AGG_RECORD_HEADER_SIZE + PING_PROBE_SIZE];
+    uint8_t slot = ping_seq & PING_WINDOW_MASK;
+
+    os_memset(probe, 0, sizeof(probe));
+    probe[0] = ((PING_PROBE_SIZE >> 8) & 0xFF) | UART_LEN_LOCAL_BIT;
+    probe[1] = PING_PROBE_SIZE & 0xFF;
+    probe[2] = AIR_MSG_PING;
+    probe[3] = ping_seq & 0xFF;
+    probe[4] = (ping_seq >> 8) & 0xFF;
+
+    /* Slot reused before its echo or timeout (interval too short) */
+    if (ping_pending & (1u << slot)) {
+        ping_stats.lost++;
+    }
+
+    ping_sent_seq[slot] = ping_seq;
+    ping_sent_cycles[slot] = cycles_now();
+    if (wifi_raw_send(probe, sizeof(probe), TC_PRIORITY, ping_link, false) != 0) {
+        ping_pending &= ~(1u << slot);
+        ping_stats.deferred++;
+        return;
+    }
+
+    ping_pending |= 1u << slot;
+    ping_stats.sent++;
+    ping_seq++;
+}
+
+/**
+ * Count probes whose echo is overdue as lost
+ */
+static void ping_expire(void)
+{
+    uint32_t now = cycles_now();
+    uint8_t i;
+
+    for (i = 0; i < PING_WINDOW; i++) {
+        if ((ping_pending & (1u << i)) &&
+            now - ping_sent_cycles[i] > (uint32_t)PING_TIMEOUT_MS * 1000 * CPU_CYCLES_PER_US) {
+            ping_pending &= ~(1u << i);
+            ping_stats.lost++;
+        }
+    }
+}
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void ping_init(void)
+{
+    ping_echo_on = PING_ECHO_ENABLED;
+    echo_len = 0;
+    ping_state = PING_STATE_IDLE;
+    ping_pending = 0;
+    os_memset(&ping_stats, 0, sizeof(ping_stats));
+}
+
+void ping_set_echo(bool on)
+{
+    ping_echo_on = on;
+}
+
+bool ping_get_echo(void)
+{
+    return ping_echo_on;
+}
+
+void ping_echo(const uint8_t *payload, uint16_t len, uint8_t tclass, uint8_t link)
+{
+    if (!ping_echo_on) {
+        return;
+    }
+
+    if (echo_len != 0 || len == 0 || len > sizeof(echo_buffer)) {
+        echo_drop_count++;
+        return;
+    }
+
+    os_memcpy(echo_buffer, payload, len);
+    echo_len = len;
+    echo_class = tclass;
+    echo_link = link;
+
+    /* Straight back if the radio is free */
+    ping_pump();
+}
+
+void ping_pump(void)
+{
+    if (echo_len == 0 || !wifi_raw_tx_ready()) {
+        return;
+    }
+
+    if (wifi_raw_send(echo_buffer, echo_len, echo_class, echo_link, false) == 0) {
+        echo_count++;
+    } else {
+        echo_drop_count++;
+    }
+    echo_len = 0;
+}
+
+bool ping_start(uint8_t link, uint16_t count, uint16_t interval_ms)
+{
+    if (!AGG_ENABLED || links_get_bssid(link) == NULL) {
+        return false;
+    }
+
+    os_memset(&ping_stats, 0, sizeof(ping_stats));
+    ping_link = link;
+    ping_count = count;
+    ping_interval_us = (uint32_t)(interval_ms ? interval_ms : PING_INTERVAL_MS) * 1000;
+    ping_due_us = system_get_time();
+    ping_pending = 0;
+    ping_state = PING_STATE_RUNNING;
+    return true;
+}
+
+void ping_stop(void)
+{
+    if (ping_state == PING_STATE_RUNNING) {
+        ping_state = PING_STATE_DRAINING;
+    }
+}
+
+void ping_poll(void)
+{
+    uint32_t now = system_get_time();
+
+    if (ping_state == PING_STATE_IDLE || ping_state == PING_STATE_DONE) {
+        return;
+    }
+
+    ping_expire();
+
+    if (ping_state == PING_STATE_RUNNING && (int32_t)(now - ping_due_us) >= 0) {
+        /* Busy radio: try again next tick rather than skip the probe */
+        if (!wifi_raw_tx_ready()) {
+            ping_stats.deferred++;
+        } else {
+            ping_send_probe();
+            ping_due_us += ping_interval_us;
+            if ((int32_t)(now - ping_due_us) > 0) {
+                ping_due_us = now + ping_interval_us;
+            }
+        }
+
+        if (ping_count != 0 && ping_stats.sent >= ping_count) {
+            ping_state = PING_STATE_DRAINING;
+        }
+    }
+
+    if (ping_state == PING_STATE_DRAINING && ping_pending == 0) {
+        ping_state = PING_STATE_DONE;
+        ctrl_send_ping();
+    }
+}
+
+void ping_air_rx(const uint8_t *msg, uint16_t len)
+{
+    uint32_t rtt_us;
+    uint16_t seq;
+    uint8_t slot;
+
+    if (len < 3) {
+        return;
+    }
+
+    seq = msg[1] | (msg[2] << 8);
+    slot = seq & PING_WINDOW_MASK;
+
+    /* Not ours, already answered or timed out */
+    if (!(ping_pending & (1u << slot)) || ping_sent_seq[slot] != seq) {
+        return;
+    }
+
+    rtt_us = (cycles_now() - ping_sent_cycles[slot]) / CPU_CYCLES_PER_US;
+    ping_pending &= ~(1u << slot);
+
+    if (ping_stats.received == 0 || rtt_us < ping_stats.rtt_min_us) {
+        ping_stats.rtt_min_us = rtt_us;
+    }
+    ping_stats.received++;
+    ping_stats.rtt_total_us += rtt_us;
+    hist_add(&ping_stats.rtt_us, rtt_us);
+}
+
+uint8_t ping_get_state(void)
+{
+    return ping_state;
+}
+
+uint8_t ping_get_link(void)
+{
+    return ping_link;
+}
+
+const struct ping_stats *ping_get_stats(void)
+{
+    return &ping_stats;
+}
+
+void ping_get_echo_counts(uint32_t *echoed, uint32_t *dropped)
+{
+    *echoed = echo_count;
+    *dropped = echo_drop_count;
+}
@@ -0,0 +1,134 @@
+/* ==================================================
+ * Over-the-Air Ping
+ * Echo responder (sends every accepted frame straight
+ * back on its link) and a built-in probe generator that
+ * times the round trip with CCOUNT - a field check of
+ * the real link without two flight controllers
+ * ================================================== */
+
+#ifndef PING_H
+#define PING_H
+
+#include "c_types.h"
+#include "hist.h"
+
+/* ==================================================
+ * TYPES
+ * ================================================== */
+
+/* Probe run states (reported in GET_PING) */
+#define PING_STATE_IDLE         0
+#define PING_STATE_RUNNING      1           /* Sending probes */
+#define PING_STATE_DRAINING     2           /* All sent, waiting for the last echoes */
+#define PING_STATE_DONE         3
+
+/* Round-trip statistics of the current or last run */
+struct ping_stats {
+    uint32_t sent;              /* Probes sent */
+    uint32_t received;          /* Echoes back within PING_TIMEOUT_MS */
+    uint32_t lost;              /* Probes timed out */
+    uint32_t deferred;          /* Probe slots skipped, radio busy */
+    uint32_t rtt_min_us;
+    uint32_t rtt_total_us;      /* Average = total / received */
+    struct log_hist rtt_us;     /* Percentiles and max */
+};
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Reset state (echo from PING_ECHO_ENABLED, no probe run)
+ */
+void ping_init(void);
+
+/**
+ * Turn the echo responder on or off
+ * Only one end of a link may echo, or frames bounce forever.
+ *
+ * @param on: true to echo every accepted frame
+ */
+void ping_set_echo(bool on);
+
+/**
+ * Check whether the echo responder is on
+ *
+ * @return: true if echoing
+ */
+bool ping_get_echo(void);
+
+/**
+ * Echo an accepted frame back on its link (RX callback)
+ * Sent at once if the radio is free, otherwise held for
+ * ping_pump(); a newer frame never replaces a held one.
+ *
+ * @param payload: 802.11 payload (after the sync fields)
+ * @param len: Payload length
+ * @param tclass: Traffic class from the 802.11 header
+ * @param link: Link the frame arrived on
+ */
+void ping_echo(const uint8_t *payload, uint16_t len, uint8_t tclass, uint8_t link);
+
+/**
+ * Send a held echo if the radio is free (call before the TX queue)
+ */
+void ping_pump(void);
+
+/**
+ * Start a probe run, clearing the statistics
+ *
+ * @param link: Link ID to probe
+ * @param count: Probes to send (0 = until ping_stop)
+ * @param interval_ms: Time between probes (0 = PING_INTERVAL_MS)
+ * @return: false if AGG_ENABLED is off or the link is unknown
+ */
+bool ping_start(uint8_t link, uint16_t count, uint16_t interval_ms);
+
+/**
+ * Stop sending probes (echoes still in flight are waited for)
+ */
+void ping_stop(void);
+
+/**
+ * Send probes, expire lost ones and finish runs (main timer)
+ */
+void ping_poll(void);
+
+/**
+ * Handle an AIR_MSG_PING record (an echo of our probe)
+ *
+ * @param msg: Record ([type][seq u16])
+ * @param len: Record length
+ */
+void ping_air_rx(const uint8_t *msg, uint16_t len);
+
+/**
+ * Get run state
+ *
+ * @return: PING_STATE_*
+ */
+uint8_t ping_get_state(void);
+
+/**
+ * Get the probed link
+ *
+ * @return: Link ID
+ */
+uint8_t ping_get_link(void);
+
+/**
+ * Get round-trip statistics
+ *
+ * @return: Statistics
+ */
+const struct ping_stats *ping_get_stats(void);
+
+/**
+ * Get echo responder counters
+ *
+ * @param echoed: Receives frames sent back
+ * @param dropped: Receives frames not echoed (one already held)
+ */
+void ping_get_echo_counts(uint32_t *echoed, uint32_t *dropped);
+
+#endif /* PING_H */
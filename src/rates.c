@@ -0,0 +1,105 @@
+/* ==================================================
+ * Rolling-Window Rate Counters Implementation
+ *
+ * Writers only add to a 32-bit total. Once a second
+ * rates_poll() takes the difference since the last
+ * sample into a ring of per-second slots; unsigned
+ * subtraction copes with the totals wrapping. Stats
+ * resets elsewhere do not touch these totals.
+ * ================================================== */
+
+#include "rates.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+/* ==================================================
+ * STATE
+ * ================================================== */
+
+volatile uint32_t rate_total[RATE_TOTALS];
+
+/* Totals at the start of the current slot */
+static uint32_t rate_base[RATE_TOTALS];
+
+/* Per-second counts, rate_slot_last is the newest complete one */
+static uint32_t rate_slots[RATE_WINDOW_SLOTS][RATE_COUNT];
+static uint8_t rate_slot_last = RATE_WINDOW_SLOTS - 1;
+static uint8_t rate_fill = 0;
+
+static uint32_t rate_slot_start_us = 0;
+static uint8_t rate_started = 0;
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void ICACHE_FLASH_ATTR rates_poll(void)
+{
+    uint32_t now = system_get_time();
+    uint32_t sample[RATE_TOTALS];
+    uint32_t *slot;
+    uint8_t i;
+
+    if (!rate_started) {
+        for (i = 0; i < RATE_TOTALS; i++) {
+            rate_base[i] = rate_total[i];
+        }
+        rate_slot_start_us = now;
+        rate_started = 1;
+        return;
+    }
+
+    if (now - rate_slot_start_us < RATE_SLOT_US) {
+        return;
+    }
+
+    /* Each word is read once; 32-bit loads are atomic */
+    for (i = 0; i < RATE_TOTALS; i++) {
+        sample[i] = rate_total[i];
+    }
+
+    rate_slot_last = (rate_slot_last + 1) % RATE_WINDOW_SLOTS;
+    slot = rate_slots[rate_slot_last];
+    for (i = 0; i < RATE_COUNT; i++) {
+        slot[i] = sample[i] - rate_base[i];
+    }
+    slot[RATE_DROPS] += sample[RATE_DROPS_ISR] - rate_base[RATE_DROPS_ISR];
+
+    for (i = 0; i < RATE_TOTALS; i++) {
+        rate_base[i] = sample[i];
+    }
+    if (rate_fill < RATE_WINDOW_SLOTS) {
+        rate_fill++;
+    }
+
+    /* Keep slots on a 1 s grid despite timer jitter; after a long
+     * stall, restart the grid instead of closing empty slots */
+    rate_slot_start_us += RATE_SLOT_US;
+    if (now - rate_slot_start_us >= RATE_SLOT_US) {
+        rate_slot_start_us = now;
+    }
+}
+
+void ICACHE_FLASH_ATTR rates_get(uint8_t counter, uint32_t *last_1s, uint32_t *last_10s)
+{
+    uint32_t sum = 0;
+    uint8_t i;
+
+    if (counter >= RATE_COUNT || rate_fill == 0) {
+        *last_1s = 0;
+        *last_10s = 0;
+        return;
+    }
+
+    for (i = 0; i < rate_fill; i++) {
+        sum += rate_slots[(rate_slot_last + RATE_WINDOW_SLOTS - i) % RATE_WINDOW_SLOTS][counter];
+    }
+
+    *last_1s = rate_slots[rate_slot_last][counter];
+    *last_10s = sum;
+}
+
+uint8_t ICACHE_FLASH_ATTR rates_get_fill(void)
+{
+    return rate_fill;
+}
@@ -0,0 +1,72 @@
+/* ==================================================
+ * Rolling-Window Rate Counters
+ * Free-running totals bumped where traffic passes,
+ * sampled once a second into per-1 s and per-10 s
+ * windows for live link throughput
+ * ================================================== */
+
+#ifndef RATES_H
+#define RATES_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * CONFIGURATION
+ * ================================================== */
+
+#define RATE_SLOT_US            1000000     /* One window slot per second */
+#define RATE_WINDOW_SLOTS       10          /* Long window: 10 s */
+
+/* ==================================================
+ * COUNTERS
+ * ================================================== */
+
+enum rate_counter {
+    RATE_TX_FRAMES,                 /* Air frames injected */
+    RATE_TX_BYTES,                  /* Their payload bytes */
+    RATE_RX_FRAMES,                 /* Air frames accepted */
+    RATE_RX_BYTES,                  /* Their payload bytes */
+    RATE_UART_IN,                   /* Bytes into the UART RX ring */
+    RATE_UART_OUT,                  /* Bytes into the UART TX FIFO */
+    RATE_DROPS,                     /* Frames lost on either path */
+    RATE_COUNT,
+
+    /* UART RX overflow bursts, folded into RATE_DROPS when sampled:
+     * every total has a single writer, so an ISR never interrupts
+     * a read-modify-write of the same word */
+    RATE_DROPS_ISR = RATE_COUNT,
+    RATE_TOTALS
+};
+
+extern volatile uint32_t rate_total[RATE_TOTALS];
+
+/* One add, safe from the UART ISR (no call, no lock) */
+#define RATE_ADD(counter, n)    (rate_total[(counter)] += (n))
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Close the current slot once a second has passed (main timer tick)
+ */
+void rates_poll(void);
+
+/**
+ * Get a counter over both windows
+ *
+ * @param counter: enum rate_counter (not RATE_DROPS_ISR)
+ * @param last_1s: Count in the last complete second
+ * @param last_10s: Sum over the last rates_get_fill() seconds
+ */
+void rates_get(uint8_t counter, uint32_t *last_1s, uint32_t *last_10s);
+
+/**
+ * Get how many seconds the long window holds
+ * Less than RATE_WINDOW_SLOTS only during the first seconds after boot.
+ *
+ * @return: Complete slots, 0..RATE_WINDOW_SLOTS
+ */
+uint8_t rates_get_fill(void);
+
+#endif /* RATES_H */
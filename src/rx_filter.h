@@ -0,0 +1,175 @@
+/* ==================================================
+ * RX Header Matching
+ * Early-reject filter for promiscuous frames, shared
+ * by the firmware and the host benchmark
+ * ================================================== */
+
+#ifndef RX_FILTER_H
+#define RX_FILTER_H
+
+#ifdef HOST_BUILD
+#include <stdint.h>
+#include <string.h>
+#define RX_FILTER_MEMSET(d, c, n)   memset(d, c, n)
+#else
+#include "c_types.h"
+#include "osapi.h"
+#define RX_FILTER_MEMSET(d, c, n)   os_memset(d, c, n)
+#endif
+
+#include "user_config.h"
+
+/* ==================================================
+ * FILTER STAGES
+ * ================================================== */
+
+/* Filter stages in the order they run, used as reject counter index */
+enum rx_stage {
+    RX_STAGE_PHY,       /* 802.11n or runt frame (RxControl) */
+    RX_STAGE_TYPE,      /* Not our frame type/subtype */
+    RX_STAGE_BSSID,     /* Foreign BSSID */
+    RX_STAGE_DUPLICATE, /* Sequence number already seen from this sender */
+    RX_STAGE_LENGTH,    /* Payload larger than any frame we send */
+    RX_STAGE_DELIVER,   /* Malformed aggregate or UART ring full */
+    RX_STAGE_COUNT
+};
+
+/* rx_match_header() result for a frame that passed */
+#define RX_STAGE_ACCEPT         RX_STAGE_COUNT
+
+/* Byte offsets inside the 802.11 header */
+#define RX_HDR_FC_OFFSET        0
+#define RX_HDR_ADDR3_OFFSET     16          /* Word aligned if the header is */
+
+/* ==================================================
+ * MATCH PATTERN
+ * ================================================== */
+
+/**
+ * One accepted BSSID, stored as native words so matching
+ * is a few aligned loads and compares. The BSSID is split
+ * at its aligned boundary: addr3[0..3] is one word,
+ * addr3[4..5] one halfword. The tail is compared first -
+ * the vendor prefix is often shared between aircraft,
+ * the last bytes are not.
+ */
+struct rx_link_slot {
+    uint32_t bssid_head;    /* addr3[0..3] */
+    uint16_t bssid_tail;    /* addr3[4..5] */
+    uint8_t link;           /* Link ID reported for this BSSID */
+    uint8_t used;
+};
+
+/**
+ * Accepted header pattern: frame control plus an open-addressed
+ * hash table of BSSIDs. At most half the slots are used, so a
+ * lookup ends after one or two probes whatever the link count.
+ */
+struct rx_match {
+    uint16_t fc_mask;       /* Frame control bits that must match */
+    uint16_t fc;            /* Expected frame control (masked) */
+    struct rx_link_slot slots[RX_LINK_SLOTS];
+};
+
+/* Assemble header words byte-wise (little-endian, like the LX106) */
+#define RX_LOAD16(p)        ((uint16_t)((p)[0] | ((p)[1] << 8)))
+#define RX_LOAD32(p)        ((uint32_t)(p)[0] | ((uint32_t)(p)[1] << 8) | \
+                             ((uint32_t)(p)[2] << 16) | ((uint32_t)(p)[3] << 24))
+
+/**
+ * Hash slot for a BSSID (mixes the per-aircraft tail bytes
+ * with the head so sequential and random BSSIDs both spread)
+ */
+static inline uint8_t rx_link_hash(uint32_t head, uint16_t tail)
+{
+    uint32_t h = head ^ ((uint32_t)tail * 0x9E3779B1u);
+    return (h ^ (h >> 16) ^ (h >> 8)) & (RX_LINK_SLOTS - 1);
+}
+
+/**
+ * Clear the pattern and set the frame control match
+ *
+ * @param m: Pattern to fill
+ * @param fc_mask: Frame control bits to compare
+ * @param fc: Expected frame control value
+ */
+static inline void rx_match_init(struct rx_match *m, uint16_t fc_mask, uint16_t fc)
+{
+    m->fc_mask = fc_mask;
+    m->fc = fc & fc_mask;
+    RX_FILTER_MEMSET(m->slots, 0, sizeof(m->slots));
+}
+
+/**
+ * Add an accepted BSSID
+ * The caller keeps the table at most half full.
+ *
+ * @param m: Pattern
+ * @param bssid: 6-byte BSSID
+ * @param link: Link ID to report for it
+ */
+static inline void rx_match_add(struct rx_match *m, const uint8_t *bssid, uint8_t link)
+{
+    uint32_t head = RX_LOAD32(bssid);
+    uint16_t tail = RX_LOAD16(bssid + 4);
+    uint8_t i = rx_link_hash(head, tail);
+
+    while (m->slots[i].used) {
+        i = (i + 1) & (RX_LINK_SLOTS - 1);
+    }
+
+    m->slots[i].bssid_head = head;
+    m->slots[i].bssid_tail = tail;
+    m->slots[i].link = link;
+    m->slots[i].used = 1;
+}
+
+/**
+ * Match frame control and BSSID of an 802.11 header
+ * Cheapest discriminator first: the frame control halfword
+ * rejects beacons, data and control traffic, then one hash
+ * probe (tail halfword, then head word) rejects other networks
+ * and unknown aircraft. Word loads are used only when the
+ * header is word aligned (unaligned loads fault on the ESP8266).
+ *
+ * @param m: Precomputed pattern
+ * @param hdr: Start of the 802.11 header
+ * @param link: Receives the link ID on accept
+ * @return: RX_STAGE_ACCEPT, or the stage that rejected the frame
+ */
+static inline uint8_t rx_match_header(const struct rx_match *m, const uint8_t *hdr,
+                                      uint8_t *link)
+{
+    const uint8_t *a3 = hdr + RX_HDR_ADDR3_OFFSET;
+    const struct rx_link_slot *s;
+    uint32_t head;
+    uint16_t tail;
+    uint8_t i;
+
+    if (((uintptr_t)hdr & 3) == 0) {
+        if ((*(const uint16_t *)(hdr + RX_HDR_FC_OFFSET) & m->fc_mask) != m->fc) {
+            return RX_STAGE_TYPE;
+        }
+        tail = *(const uint16_t *)(a3 + 4);
+        head = *(const uint32_t *)a3;
+    } else {
+        if ((RX_LOAD16(hdr + RX_HDR_FC_OFFSET) & m->fc_mask) != m->fc) {
+            return RX_STAGE_TYPE;
+        }
+        tail = RX_LOAD16(a3 + 4);
+        head = RX_LOAD32(a3);
+    }
+
+    for (i = rx_link_hash(head, tail); ; i = (i + 1) & (RX_LINK_SLOTS - 1)) {
+        s = &m->slots[i];
+        if (!s->used) {
+            return RX_STAGE_BSSID;
+        }
+        if (s->bssid_tail == tail && s->bssid_head == head) {
+            *link = s->link;
+            return RX_STAGE_ACCEPT;
+        }
+    }
+}
+
+#endif /* RX_FILTER_H */
@@ -0,0 +1,307 @@
+/* ==================================================
+ * Raw Sniffer Implementation
+ *
+ * The promiscuous callback hands over RxControl plus the
+ * start of the frame: 112 bytes for management frames,
+ * 36 for data frames, none for control frames. Each one
+ * becomes a record in an open batch, sent as one bulk
+ * local UART frame when the next record would not fit or
+ * the batch is SNIFFER_BATCH_MS old.
+ *
+ * A busy channel easily outruns the UART, so records are
+ * paid for from a byte budget refilled at
+ * SNIFFER_UART_PERCENT of the line rate. With too little
+ * budget left a frame keeps only its MAC header, and with
+ * none it is skipped - the stream thins out instead of
+ * overrunning the ring and losing whole batches.
+ * ================================================== */
+
+#include "sniffer.h"
+#include "user_config.h"
+#include "wifi_raw.h"
+#include "uart.h"
+#include "ctrl.h"
+#include "osapi.h"
+#include "ets_sys.h"
+#include "user_interface.h"
+
+#if SNIFFER_BATCH_SIZE < 128 || SNIFFER_BATCH_SIZE > 511
+#error "SNIFFER_BATCH_SIZE must be 128..511 (one UART frame)"
+#endif
+
+#if SNIFFER_UART_PERCENT < 10 || SNIFFER_UART_PERCENT > 100
+#error "SNIFFER_UART_PERCENT must be 10..100"
+#endif
+
+/* SDK promiscuous buffer lengths and the frame bytes they hold */
+#define SNIFF_MGMT_BUF_LEN      128         /* sniffer_buf2 */
+#define SNIFF_MGMT_CAPTURE      112
+#define SNIFF_DATA_BUF_LEN      60          /* sniffer_buf */
+#define SNIFF_DATA_CAPTURE      36
+
+/* What a frame keeps when the budget is short */
+#define SNIFF_CUT_LEN           IEEE80211_HEADER_SIZE
+
+/* UART time per streamed byte (8N1 = 10 bits) at our share of the line */
+#define SNIFF_NS_PER_BYTE       (1000000000 / (UART_BAUD_RATE / 10) * 100 / SNIFFER_UART_PERCENT)
+
+/* Budget ceiling: two full batches */
+#define SNIFF_CREDIT_MAX_NS     ((int32_t)(2 * SNIFFER_BATCH_SIZE) * SNIFF_NS_PER_BYTE)
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+static bool sniff_on = false;
+static uint8_t sniff_snaplen = 0;
+static bool sniff_hw_restore = false;       /* SDK MAC filter was on at start */
+static uint8_t sniff_channel_restore = 0;   /* Link channel to return to (0 = not moved) */
+
+/* Open batch */
+static uint8_t sniff_batch[SNIFFER_BATCH_SIZE];
+static uint16_t sniff_batch_len = 0;
+static uint8_t sniff_batch_count = 0;
+static uint32_t sniff_batch_start_us = 0;
+static uint16_t sniff_batch_seq = 0;
+static uint32_t sniff_lost = 0;             /* Frames in dropped batches */
+
+/* UART byte budget */
+static int32_t sniff_credit_ns = 0;
+static uint32_t sniff_credit_us = 0;
+
+static struct sniffer_stats sniff_stats;
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+/**
+ * Queue the open batch to the UART
+ */
+static void sniffer_flush(void)
+{
+    uint8_t *p;
+
+    if (sniff_batch_count == 0) {
+        return;
+    }
+
+    p = ctrl_put_u16(sniff_batch + 2, sniff_batch_seq++);
+    p = ctrl_put_u32(p, sniff_stats.skipped + sniff_lost);
+    *p = sniff_batch_count;
+
+    /* Bulk class: flight controller traffic keeps precedence */
+    if (uart_write_frame(UART_LEN_LOCAL_BIT, sniff_batch, sniff_batch_len)) {
+        sniff_stats.batches++;
+    } else {
+        sniff_stats.batch_drops++;
+        sniff_lost += sniff_batch_count;
+    }
+
+    sniff_batch_len = SNIFF_BATCH_HEADER_SIZE;
+    sniff_batch_count = 0;
+}
+
+/**
+ * Refill the UART budget for the time since the last frame
+ */
+static void sniffer_refill(uint32_t now)
+{
+    uint32_t elapsed = now - sniff_credit_us;
+
+    sniff_credit_us = now;
+    if (elapsed >= (uint32_t)SNIFF_CREDIT_MAX_NS / 1000) {
+        sniff_credit_ns = SNIFF_CREDIT_MAX_NS;
+        return;
+    }
+
+    sniff_credit_ns += elapsed * 1000;
+    if (sniff_credit_ns > SNIFF_CREDIT_MAX_NS) {
+        sniff_credit_ns = SNIFF_CREDIT_MAX_NS;
+    }
+}
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void sniffer_init(void)
+{
+    sniff_on = false;
+    sniff_batch_len = SNIFF_BATCH_HEADER_SIZE;
+    sniff_batch_count = 0;
+    os_memset(&sniff_stats, 0, sizeof(sniff_stats));
+}
+
+bool sniffer_start(uint8_t channel, uint8_t snaplen)
+{
+    if (channel > 14 || (FHSS_ENABLED && channel != 0)) {
+        return false;
+    }
+
+    if (sniff_on) {
+        sniffer_stop();
+    }
+
+    sniff_channel_restore = 0;
+    if (channel != 0) {
+        sniff_channel_restore = wifi_raw_get_channel();
+        wifi_raw_set_channel(channel);
+    }
+
+    /* Every frame on the channel, not just our BSSID */
+    sniff_hw_restore = wifi_raw_get_hw_filter_request();
+    if (sniff_hw_restore) {
+        wifi_raw_set_hw_filter(false);
+    }
+
+    os_memset(&sniff_stats, 0, sizeof(sniff_stats));
+    sniff_snaplen = snaplen;
+    sniff_lost = 0;
+    sniff_batch[0] = CTRL_CMD_SNIFF_BATCH | CTRL_RESPONSE_BIT;
+    sniff_batch[1] = CTRL_STATUS_OK;
+    sniff_batch_len = SNIFF_BATCH_HEADER_SIZE;
+    sniff_batch_count = 0;
+    sniff_credit_us = system_get_time();
+    sniff_credit_ns = SNIFF_CREDIT_MAX_NS;
+    sniff_on = true;
+    return true;
+}
+
+void sniffer_stop(void)
+{
+    if (!sniff_on) {
+        return;
+    }
+
+    ETS_INTR_LOCK();
+    sniff_on = false;
+    sniffer_flush();
+    ETS_INTR_UNLOCK();
+
+    if (sniff_hw_restore) {
+        wifi_raw_set_hw_filter(true);
+    }
+
+    /* Back to the link's channel if sniffing moved us */
+    if (sniff_channel_restore != 0) {
+        wifi_raw_set_channel(sniff_channel_restore);
+        sniff_channel_restore = 0;
+    }
+}
+
+bool sniffer_active(void)
+{
+    return sniff_on;
+}
+
+void sniffer_rx(const uint8_t *buf, uint16_t len)
+{
+    const struct RxControl *rx_ctrl = (const struct RxControl *)buf;
+    uint32_t now = system_get_time();
+    uint16_t orig_len, cap_len;
+    uint16_t record_len;
+    uint8_t flags = 0;
+    uint8_t *p;
+
+    if (!sniff_on) {
+        return;
+    }
+
+    /* Frame length without the FCS, and what the SDK kept of it */
+    if (rx_ctrl->sig_mode != 0) {
+        orig_len = rx_ctrl->HT_length;
+        flags |= SNIFF_FLAG_HT;
+        if (rx_ctrl->CWB) {
+            flags |= SNIFF_FLAG_40MHZ;
+        }
+        if (rx_ctrl->SGI) {
+            flags |= SNIFF_FLAG_SGI;
+        }
+    } else {
+        orig_len = rx_ctrl->legacy_length;
+    }
+    orig_len = (orig_len > 4) ? orig_len - 4 : 0;
+    if (rx_ctrl->is_group) {
+        flags |= SNIFF_FLAG_GROUP;
+    }
+
+    if (len == SNIFF_MGMT_BUF_LEN) {
+        cap_len = SNIFF_MGMT_CAPTURE;
+    } else if (len == SNIFF_DATA_BUF_LEN) {
+        cap_len = SNIFF_DATA_CAPTURE;
+    } else {
+        cap_len = 0;
+    }
+    if (cap_len > orig_len) {
+        cap_len = orig_len;
+    }
+    if (sniff_snaplen != 0 && cap_len > sniff_snaplen) {
+        cap_len = sniff_snaplen;
+    }
+
+    /* Pay for the record: whole, cut to the MAC header, or not at all */
+    sniffer_refill(now);
+    if (sniff_credit_ns < (int32_t)(SNIFF_RECORD_HEADER_SIZE + cap_len) * SNIFF_NS_PER_BYTE) {
+        if (cap_len <= SNIFF_CUT_LEN ||
+            sniff_credit_ns < (int32_t)(SNIFF_RECORD_HEADER_SIZE + SNIFF_CUT_LEN) * SNIFF_NS_PER_BYTE) {
+            sniff_stats.skipped++;
+            return;
+        }
+        cap_len = SNIFF_CUT_LEN;
+        flags |= SNIFF_FLAG_CUT;
+        sniff_stats.cut++;
+    }
+
+    record_len = SNIFF_RECORD_HEADER_SIZE + cap_len;
+    if (sniff_batch_len + record_len > SNIFFER_BATCH_SIZE || sniff_batch_count == 0xFF) {
+        sniffer_flush();
+    }
+    if (sniff_batch_count == 0) {
+        sniff_batch_start_us = now;
+        sniff_credit_ns -= SNIFF_BATCH_HEADER_SIZE * SNIFF_NS_PER_BYTE;
+    }
+
+    p = ctrl_put_u32(sniff_batch + sniff_batch_len, now);
+    *p++ = (uint8_t)rx_ctrl->rssi;
+    *p++ = (flags & SNIFF_FLAG_HT) ? rx_ctrl->MCS : rx_ctrl->rate;
+    *p++ = rx_ctrl->channel;
+    *p++ = flags;
+    p = ctrl_put_u16(p, orig_len);
+    *p++ = cap_len;
+    os_memcpy(p, buf + sizeof(struct RxControl), cap_len);
+
+    sniff_batch_len += record_len;
+    sniff_batch_count++;
+    sniff_credit_ns -= record_len * SNIFF_NS_PER_BYTE;
+    sniff_stats.frames++;
+    sniff_stats.bytes += record_len;
+
+    if (now - sniff_batch_start_us >= SNIFFER_BATCH_MS * 1000) {
+        sniffer_flush();
+    }
+}
+
+void sniffer_poll(void)
+{
+    if (!sniff_on) {
+        return;
+    }
+
+    /* Quiet channel: don't sit on a partial batch */
+    ETS_INTR_LOCK();
+    if (sniff_batch_count > 0 && system_get_time() - sniff_batch_start_us >= SNIFFER_BATCH_MS * 1000) {
+        sniffer_flush();
+    }
+    ETS_INTR_UNLOCK();
+}
+
+uint8_t sniffer_get_snaplen(void)
+{
+    return sniff_snaplen;
+}
+
+const struct sniffer_stats *sniffer_get_stats(void)
+{
+    return &sniff_stats;
+}
@@ -0,0 +1,107 @@
+/* ==================================================
+ * Raw Sniffer
+ * Streams every frame the radio hears on the channel
+ * to the UART in batches, with per-frame RxControl
+ * metadata, for interference debugging without a
+ * monitor-mode adapter (tools/sniff_pcap.py writes pcap)
+ * ================================================== */
+
+#ifndef SNIFFER_H
+#define SNIFFER_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * TYPES
+ * ================================================== */
+
+/* Batch (SNIFF_BATCH push, bulk-class local frame):
+ *   [CTRL_CMD_SNIFF_BATCH|0x80][status][seq u16][dropped u32][count]
+ *   then count records
+ * seq counts batches, so a gap is a batch the UART ring had no room
+ * for; dropped is the running total of frames not streamed. */
+#define SNIFF_BATCH_HEADER_SIZE 9           /* Including the command and status bytes */
+
+/* Record: [time_us u32][rssi][rate][channel][flags][orig_len u16][cap_len]
+ * then cap_len bytes of the 802.11 frame (no FCS). rate is the
+ * RxControl rate code, or the MCS index with SNIFF_FLAG_HT. */
+#define SNIFF_RECORD_HEADER_SIZE 11
+
+#define SNIFF_FLAG_HT           0x01        /* 802.11n frame */
+#define SNIFF_FLAG_40MHZ        0x02        /* HT 40 MHz */
+#define SNIFF_FLAG_SGI          0x04        /* HT short guard interval */
+#define SNIFF_FLAG_GROUP        0x08        /* Group-addressed */
+#define SNIFF_FLAG_CUT          0x10        /* Shortened to fit the UART bandwidth */
+
+/* Capture statistics since the last start */
+struct sniffer_stats {
+    uint32_t frames;            /* Records streamed */
+    uint32_t bytes;             /* Record bytes streamed (headers included) */
+    uint32_t cut;               /* Records shortened to the MAC header */
+    uint32_t skipped;           /* Frames not captured, UART bandwidth exhausted */
+    uint32_t batches;           /* Batches queued to the UART */
+    uint32_t batch_drops;       /* Batches the UART ring had no room for */
+};
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Reset state (sniffer off)
+ */
+void sniffer_init(void);
+
+/**
+ * Start streaming, clearing the statistics
+ * The SDK MAC filter is lifted while sniffing and restored
+ * by sniffer_stop(), which also returns to the link's channel
+ * if a channel was given. Link frames are still bridged as usual.
+ *
+ * @param channel: Channel to sniff (0 = stay on the current one)
+ * @param snaplen: Bytes kept per frame (0 = all the SDK captures)
+ * @return: false if the channel is invalid, or set while hopping
+ */
+bool sniffer_start(uint8_t channel, uint8_t snaplen);
+
+/**
+ * Stop streaming (the open batch is sent), restore the SDK MAC
+ * filter and the channel sniffer_start() moved away from
+ */
+void sniffer_stop(void);
+
+/**
+ * Check whether the sniffer is streaming
+ *
+ * @return: true if on
+ */
+bool sniffer_active(void);
+
+/**
+ * Capture one promiscuous frame (RX callback, before any filter)
+ *
+ * @param buf: SDK buffer (RxControl, then the captured frame)
+ * @param len: SDK buffer length
+ */
+void sniffer_rx(const uint8_t *buf, uint16_t len);
+
+/**
+ * Send a batch older than SNIFFER_BATCH_MS (main timer)
+ */
+void sniffer_poll(void);
+
+/**
+ * Get the per-frame byte limit
+ *
+ * @return: Snap length (0 = all captured)
+ */
+uint8_t sniffer_get_snaplen(void);
+
+/**
+ * Get capture statistics
+ *
+ * @return: Statistics
+ */
+const struct sniffer_stats *sniffer_get_stats(void);
+
+#endif /* SNIFFER_H */
@@ -0,0 +1,276 @@
+/* ==================================================
+ * Channel Survey Implementation
+ *
+ * The RX callback adds every frame it hears (any network,
+ * 11b/g/n - the SDK MAC filter is lifted until the survey
+ * settles) to the current channel's accumulators; the main
+ * timer steps the channel once per dwell. Busy time is the
+ * sum of frame airtimes, so it counts only what we can
+ * decode - a lower bound on the real channel load.
+ * ================================================== */
+
+#include "survey.h"
+#include "user_config.h"
+#include "wifi_raw.h"
+#include "ctrl.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+#if CHANNEL_SURVEY_FIRST < 1 || CHANNEL_SURVEY_LAST > 14 || CHANNEL_SURVEY_FIRST > CHANNEL_SURVEY_LAST
+#error "CHANNEL_SURVEY_FIRST..LAST must be within 1..14"
+#endif
+
+#if (CHANNEL_SURVEY_ALLOWED & ~(((2 << CHANNEL_SURVEY_LAST) - 1) & ~((1 << CHANNEL_SURVEY_FIRST) - 1))) || \
+    CHANNEL_SURVEY_ALLOWED == 0
+#error "CHANNEL_SURVEY_ALLOWED must name surveyed channels only"
+#endif
+
+#define SURVEY_CHANNELS     (CHANNEL_SURVEY_LAST - CHANNEL_SURVEY_FIRST + 1)
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+static struct survey_channel survey_result[SURVEY_CHANNELS];
+
+static volatile uint8_t survey_state = SURVEY_STATE_IDLE;
+static uint8_t survey_channel = 0;      /* Channel being measured / chosen */
+static uint32_t survey_since_us = 0;    /* Dwell start */
+
+/* Current dwell, written by the RX callback */
+static volatile uint32_t live_frames = 0;
+static volatile uint32_t live_busy_us = 0;
+static volatile int8_t live_rssi_max = -128;
+
+/* SDK MAC filter to re-install when the survey settles */
+static bool survey_hw_restore = false;
+
+/* Follower: accepted frame count at the last check */
+static uint32_t hunt_rx_count = 0;
+static uint32_t hunt_heard_us = 0;
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+/**
+ * Tune to a channel and restart the dwell
+ */
+static void survey_tune(uint8_t channel)
+{
+    survey_channel = channel;
+    live_frames = 0;
+    live_busy_us = 0;
+    live_rssi_max = -128;
+    survey_since_us = system_get_time();
+    wifi_raw_set_channel(channel);
+}
+
+/**
+ * Store the finished dwell for the current channel
+ *
+ * @param dwell_us: Measured dwell time
+ */
+static void survey_store(uint32_t dwell_us)
+{
+    struct survey_channel *r = &survey_result[survey_channel - CHANNEL_SURVEY_FIRST];
+    uint32_t busy = live_busy_us;
+
+    r->frames = (live_frames > 0xFFFF) ? 0xFFFF : live_frames;
+    r->busy_permille = (busy >= dwell_us) ? 1000 : busy * 1000 / dwell_us;
+    r->rssi_max = live_rssi_max;
+}
+
+/**
+ * Least busy allowed channel; busy levels within one bucket
+ * tie and the lowest channel wins, so a little noise between
+ * runs does not move the pick
+ *
+ * @return: Channel number
+ */
+static uint8_t survey_pick(void)
+{
+    uint8_t best = 0;
+    uint16_t best_bucket = 0xFFFF;
+    uint16_t bucket;
+    uint8_t ch;
+
+    for (ch = CHANNEL_SURVEY_FIRST; ch <= CHANNEL_SURVEY_LAST; ch++) {
+        if (!(CHANNEL_SURVEY_ALLOWED & (1 << ch))) {
+            continue;
+        }
+        bucket = survey_result[ch - CHANNEL_SURVEY_FIRST].busy_permille / CHANNEL_SURVEY_BUCKET_PERMILLE;
+        if (bucket < best_bucket) {
+            best_bucket = bucket;
+            best = ch;
+        }
+    }
+    return best;
+}
+
+/**
+ * Next allowed channel after the given one (wraps)
+ */
+static uint8_t survey_next_allowed(uint8_t channel)
+{
+    uint8_t i;
+
+    for (i = 0; i < SURVEY_CHANNELS; i++) {
+        channel = (channel >= CHANNEL_SURVEY_LAST) ? CHANNEL_SURVEY_FIRST : channel + 1;
+        if (CHANNEL_SURVEY_ALLOWED & (1 << channel)) {
+            break;
+        }
+    }
+    return channel;
+}
+
+/**
+ * Settle on the current channel and report it
+ */
+static void survey_finish(void)
+{
+    survey_state = SURVEY_STATE_DONE;
+    hunt_rx_count = wifi_get_rx_count();
+    hunt_heard_us = system_get_time();
+
+    if (survey_hw_restore) {
+        survey_hw_restore = false;
+        wifi_raw_set_hw_filter(true);
+    }
+
+    os_printf("[SURVEY] channel=%u (%s)\n", survey_channel,
+              CHANNEL_SURVEY_LEADER ? "least busy" : "link heard");
+    ctrl_send_survey();
+}
+
+/**
+ * Survey complete: the leader takes its pick, a follower
+ * hunts for the leader starting from its own pick
+ */
+static void survey_scan_done(void)
+{
+    uint8_t ch;
+
+    for (ch = CHANNEL_SURVEY_FIRST; ch <= CHANNEL_SURVEY_LAST; ch++) {
+        const struct survey_channel *r = &survey_result[ch - CHANNEL_SURVEY_FIRST];
+        os_printf("[SURVEY] ch=%u busy=%u.%u%% frames=%u rssi_max=%d%s\n",
+                  ch, r->busy_permille / 10, r->busy_permille % 10, r->frames, r->rssi_max,
+                  (CHANNEL_SURVEY_ALLOWED & (1 << ch)) ? "" : " (not allowed)");
+    }
+
+    survey_tune(survey_pick());
+
+    if (CHANNEL_SURVEY_LEADER) {
+        survey_finish();
+    } else {
+        survey_state = SURVEY_STATE_HUNTING;
+        hunt_rx_count = wifi_get_rx_count();
+        ctrl_send_survey();
+    }
+}
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+bool survey_start(void)
+{
+    if (!CHANNEL_SURVEY_ENABLED) {
+        return false;
+    }
+
+    /* Every frame on the channel, not just our BSSID (a restart
+     * mid-survey keeps the setting saved by the first start) */
+    if (survey_state != SURVEY_STATE_SCANNING && survey_state != SURVEY_STATE_HUNTING) {
+        survey_hw_restore = wifi_raw_get_hw_filter_request();
+        if (survey_hw_restore) {
+            wifi_raw_set_hw_filter(false);
+        }
+    }
+
+    os_memset(survey_result, 0, sizeof(survey_result));
+    survey_tune(CHANNEL_SURVEY_FIRST);
+    survey_state = SURVEY_STATE_SCANNING;
+    os_printf("[SURVEY] scanning channels %u-%u, %u ms each\n",
+              CHANNEL_SURVEY_FIRST, CHANNEL_SURVEY_LAST, CHANNEL_SURVEY_DWELL_MS);
+    return true;
+}
+
+void survey_poll(void)
+{
+    uint32_t now = system_get_time();
+    uint32_t rx_count;
+
+    switch (survey_state) {
+        case SURVEY_STATE_SCANNING:
+            if (now - survey_since_us < CHANNEL_SURVEY_DWELL_MS * 1000) {
+                return;
+            }
+            survey_store(now - survey_since_us);
+            if (survey_channel < CHANNEL_SURVEY_LAST) {
+                survey_tune(survey_channel + 1);
+            } else {
+                survey_scan_done();
+            }
+            break;
+
+        case SURVEY_STATE_HUNTING:
+            /* Any accepted frame means the leader is on this channel */
+            if (wifi_get_rx_count() != hunt_rx_count) {
+                survey_finish();
+            } else if (now - survey_since_us >= CHANNEL_HUNT_DWELL_MS * 1000) {
+                survey_tune(survey_next_allowed(survey_channel));
+            }
+            break;
+
+        case SURVEY_STATE_DONE:
+            if (CHANNEL_SURVEY_LEADER) {
+                return;
+            }
+            /* Follower: hunt again once the link goes quiet */
+            rx_count = wifi_get_rx_count();
+            if (rx_count != hunt_rx_count) {
+                hunt_rx_count = rx_count;
+                hunt_heard_us = now;
+            } else if (now - hunt_heard_us >= CHANNEL_HUNT_LOST_MS * 1000) {
+                os_printf("[SURVEY] link lost on channel %u, hunting\n", survey_channel);
+                survey_state = SURVEY_STATE_HUNTING;
+                survey_tune(survey_next_allowed(survey_channel));
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+void survey_rx(int8_t rssi, uint32_t airtime_us)
+{
+    if (survey_state != SURVEY_STATE_SCANNING) {
+        return;
+    }
+
+    live_frames++;
+    live_busy_us += airtime_us;
+    if (rssi > live_rssi_max) {
+        live_rssi_max = rssi;
+    }
+}
+
+uint8_t survey_get_state(void)
+{
+    return survey_state;
+}
+
+uint8_t survey_get_channel_choice(void)
+{
+    return survey_channel;
+}
+
+const struct survey_channel *survey_get_channel(uint8_t channel)
+{
+    if (channel < CHANNEL_SURVEY_FIRST || channel > CHANNEL_SURVEY_LAST) {
+        return NULL;
+    }
+    return &survey_result[channel - CHANNEL_SURVEY_FIRST];
+}
@@ -0,0 +1,78 @@
+/* ==================================================
+ * Channel Survey
+ * Boot-time busy measurement of every channel and
+ * least-busy channel selection (leader) or link
+ * hunting (follower)
+ * ================================================== */
+
+#ifndef SURVEY_H
+#define SURVEY_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * TYPES
+ * ================================================== */
+
+/* Survey states (reported in GET_SURVEY) */
+#define SURVEY_STATE_IDLE       0           /* Not run / disabled */
+#define SURVEY_STATE_SCANNING   1
+#define SURVEY_STATE_HUNTING    2           /* Follower: looking for the link */
+#define SURVEY_STATE_DONE       3
+
+/* Measurements for one channel */
+struct survey_channel {
+    uint16_t frames;            /* Frames heard (saturates) */
+    uint16_t busy_permille;     /* Airtime share of the dwell */
+    int8_t rssi_max;            /* Strongest frame (dBm) */
+};
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Start (or restart) the survey
+ * Call after wifi_raw_init(). While scanning, traffic on
+ * the link is interrupted.
+ *
+ * @return: false if CHANNEL_SURVEY_ENABLED is off
+ */
+bool survey_start(void);
+
+/**
+ * Advance the survey / hunt (call from the main timer)
+ */
+void survey_poll(void);
+
+/**
+ * Account one received frame (RX callback, before any filter)
+ *
+ * @param rssi: RxControl.rssi
+ * @param airtime_us: Frame duration on air
+ */
+void survey_rx(int8_t rssi, uint32_t airtime_us);
+
+/**
+ * Get survey state
+ *
+ * @return: SURVEY_STATE_*
+ */
+uint8_t survey_get_state(void);
+
+/**
+ * Get the channel being measured, hunted or chosen
+ *
+ * @return: Channel number, 0 before the first survey
+ */
+uint8_t survey_get_channel_choice(void);
+
+/**
+ * Get measurements for one channel
+ *
+ * @param channel: 1..14
+ * @return: Measurements, or NULL if outside the surveyed range
+ */
+const struct survey_channel *survey_get_channel(uint8_t channel);
+
+#endif /* SURVEY_H */
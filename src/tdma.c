@@ -0,0 +1,223 @@
+/* ==================================================
+ * TDMA Slot Scheduler Implementation
+ *
+ * Like the hop timer, the schedule is an epoch (local time
+ * at which the current frame's uplink slot started) and
+ * the slot is derived from the time since. A microsecond
+ * timer fires at the start of each own slot to apply the
+ * follower's sync and release frames held by the gate.
+ * ================================================== */
+
+#include "tdma.h"
+#include "user_config.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+#define TDMA_UPLINK_US      ((uint32_t)TDMA_FRAME_US * TDMA_UPLINK_PERMILLE / 1000)
+#define TDMA_DOWNLINK_US    (TDMA_FRAME_US - TDMA_UPLINK_US)
+
+/* Own slot: uplink for the leader, downlink for the follower */
+#define TDMA_OWN_START_US   (TDMA_LEADER ? 0 : TDMA_UPLINK_US)
+#define TDMA_OWN_LEN_US     (TDMA_LEADER ? TDMA_UPLINK_US : TDMA_DOWNLINK_US)
+
+#if TDMA_FRAME_US > 0xFFFF
+#error "TDMA_FRAME_US must fit the 16-bit sync phase"
+#endif
+
+#if TDMA_FRAME_US * TDMA_UPLINK_PERMILLE / 1000 <= TDMA_GUARD_US || \
+    TDMA_FRAME_US - TDMA_FRAME_US * TDMA_UPLINK_PERMILLE / 1000 <= TDMA_GUARD_US
+#error "Both TDMA slots must be longer than TDMA_GUARD_US"
+#endif
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+static os_timer_t tdma_timer;
+static void (*tdma_slot_hook)(void) = NULL;
+
+static uint8_t tdma_state = TDMA_STATE_OFF;
+static uint32_t tdma_epoch_us = 0;          /* Start of the current frame */
+static uint32_t tdma_heard_us = 0;          /* Last sync applied */
+static uint32_t tdma_tick_us = 0;           /* Last slot timer run */
+
+/* Leader epoch measured by the RX callback */
+static volatile uint32_t sync_epoch_us = 0;
+static volatile uint8_t sync_pending = 0;
+
+static struct tdma_stats tdma_stats;
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+/**
+ * Frame phase of a local time
+ *
+ * @return: 0..TDMA_FRAME_US-1
+ */
+static uint32_t tdma_phase(uint32_t t)
+{
+    int32_t d = (int32_t)(t - tdma_epoch_us) % TDMA_FRAME_US;
+    return (d < 0) ? d + TDMA_FRAME_US : d;
+}
+
+/**
+ * Time since the own slot started
+ *
+ * @return: 0..TDMA_FRAME_US-1 (< TDMA_OWN_LEN_US inside the slot)
+ */
+static uint32_t tdma_own_phase(uint32_t t)
+{
+    return (tdma_phase(t) + TDMA_FRAME_US - TDMA_OWN_START_US) % TDMA_FRAME_US;
+}
+
+/**
+ * Apply the latest leader epoch from the RX callback
+ */
+static void tdma_apply_sync(uint32_t now)
+{
+    int32_t err = (int32_t)(sync_epoch_us - tdma_epoch_us) % TDMA_FRAME_US;
+
+    if (err > TDMA_FRAME_US / 2) {
+        err -= TDMA_FRAME_US;
+    } else if (err <= -TDMA_FRAME_US / 2) {
+        err += TDMA_FRAME_US;
+    }
+
+    sync_pending = 0;
+    tdma_heard_us = now;
+    tdma_stats.sync_err_us = err;
+
+    if (tdma_state != TDMA_STATE_SYNCED) {
+        tdma_epoch_us = sync_epoch_us;
+        tdma_state = TDMA_STATE_SYNCED;
+        tdma_stats.acquisitions++;
+    } else if (err > TDMA_GUARD_US / 2 || err < -TDMA_GUARD_US / 2) {
+        tdma_epoch_us = sync_epoch_us;
+    } else {
+        tdma_epoch_us += err / (1 << TDMA_SYNC_GAIN_SHIFT);
+    }
+}
+
+/**
+ * Slot timer: runs at the start of each own slot
+ */
+static void tdma_timer_cb(void *arg)
+{
+    uint32_t now = system_get_time();
+
+    if (sync_pending) {
+        tdma_apply_sync(now);
+    }
+
+    /* Follower: silent link - send unslotted until the leader is back */
+    if (!TDMA_LEADER && tdma_state == TDMA_STATE_SYNCED &&
+        now - tdma_heard_us > TDMA_LOST_US) {
+        tdma_state = TDMA_STATE_UNSYNCED;
+    }
+
+    if (tdma_state != TDMA_STATE_SYNCED) {
+        tdma_tick_us = now;
+        os_timer_arm_us(&tdma_timer, TDMA_FRAME_US, 0);
+        return;
+    }
+
+    tdma_stats.synced_us += now - tdma_tick_us;
+    tdma_tick_us = now;
+
+    /* Own slot open: release held frames */
+    if (tdma_own_phase(now) < TDMA_OWN_LEN_US - TDMA_GUARD_US && tdma_slot_hook != NULL) {
+        tdma_slot_hook();
+    }
+
+    /* Keep the epoch within the last frame */
+    tdma_epoch_us = now - tdma_phase(now);
+
+    /* Next own slot start (or this one, if the timer fired early) */
+    os_timer_arm_us(&tdma_timer, TDMA_FRAME_US - tdma_own_phase(system_get_time()), 0);
+}
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void tdma_init(void (*slot_cb)(void))
+{
+    if (!TDMA_ENABLED) {
+        return;
+    }
+
+    os_memset(&tdma_stats, 0, sizeof(tdma_stats));
+    tdma_slot_hook = slot_cb;
+
+    tdma_epoch_us = system_get_time() - TDMA_OWN_START_US;
+    tdma_tick_us = tdma_epoch_us + TDMA_OWN_START_US;
+    tdma_state = TDMA_LEADER ? TDMA_STATE_SYNCED : TDMA_STATE_UNSYNCED;
+
+    os_timer_disarm(&tdma_timer);
+    os_timer_setfn(&tdma_timer, (os_timer_func_t *)tdma_timer_cb, NULL);
+    os_timer_arm_us(&tdma_timer, TDMA_FRAME_US, 0);
+
+    os_printf("TDMA: %s, %u us frame, uplink %u us / downlink %u us\n",
+              TDMA_LEADER ? "leader" : "follower",
+              TDMA_FRAME_US, TDMA_UPLINK_US, TDMA_DOWNLINK_US);
+}
+
+bool tdma_tx_open(void)
+{
+    if (tdma_state != TDMA_STATE_SYNCED) {
+        return true;
+    }
+    return tdma_own_phase(system_get_time()) < TDMA_OWN_LEN_US - TDMA_GUARD_US;
+}
+
+void tdma_fill_sync(uint8_t *sync)
+{
+    uint32_t phase = tdma_phase(system_get_time());
+
+    sync[0] = phase & 0xFF;
+    sync[1] = (phase >> 8) & 0xFF;
+}
+
+void tdma_note_tx(uint32_t airtime_us)
+{
+    if (tdma_state != TDMA_STATE_SYNCED) {
+        return;
+    }
+
+    tdma_stats.tx_frames++;
+    tdma_stats.tx_airtime_us += airtime_us;
+    if (tdma_own_phase(system_get_time()) + airtime_us > TDMA_OWN_LEN_US) {
+        tdma_stats.tx_off_slot++;
+    }
+}
+
+void tdma_rx_sync(const uint8_t *sync, uint32_t rx_us, uint32_t airtime_us)
+{
+    uint32_t start = rx_us - airtime_us;
+
+    /* Peer frames that began in our slot collide with ours */
+    if (tdma_state == TDMA_STATE_SYNCED) {
+        tdma_stats.rx_frames++;
+        tdma_stats.rx_airtime_us += airtime_us;
+        if (tdma_own_phase(start) < TDMA_OWN_LEN_US) {
+            tdma_stats.rx_off_slot++;
+        }
+    }
+
+    if (!TDMA_LEADER) {
+        sync_epoch_us = start - (sync[0] | (sync[1] << 8));
+        sync_pending = 1;
+    }
+}
+
+uint8_t tdma_get_state(void)
+{
+    return tdma_state;
+}
+
+const struct tdma_stats *tdma_get_stats(void)
+{
+    return &tdma_stats;
+}
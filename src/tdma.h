@@ -0,0 +1,92 @@
+/* ==================================================
+ * TDMA Slot Scheduler
+ * Half-duplex time slots: the leader (ground station)
+ * sends in the uplink slot, the follower (aircraft) in
+ * the downlink slot, on the leader's timebase
+ * ================================================== */
+
+#ifndef TDMA_H
+#define TDMA_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * TYPES
+ * ================================================== */
+
+/* Scheduler states (reported in GET_TDMA) */
+#define TDMA_STATE_OFF          0
+#define TDMA_STATE_UNSYNCED     1           /* Follower: no timebase, sends unslotted */
+#define TDMA_STATE_SYNCED       2           /* Sending in the own slot only */
+
+/* Schedule statistics (since boot) */
+struct tdma_stats {
+    uint32_t tx_frames;         /* Frames sent while synced */
+    uint32_t tx_off_slot;       /* ... of which ran past the own slot */
+    uint32_t tx_airtime_us;     /* Own slot time used */
+    uint32_t rx_frames;         /* Link frames received while synced */
+    uint32_t rx_off_slot;       /* ... of which started in our slot */
+    uint32_t rx_airtime_us;     /* Peer slot time used */
+    uint32_t synced_us;         /* Time spent synced (utilization base) */
+    uint32_t acquisitions;      /* Follower: times sync was (re)gained */
+    int32_t sync_err_us;        /* Last phase error seen by the follower */
+};
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Start the schedule (no-op unless TDMA_ENABLED)
+ *
+ * @param slot_cb: Called at the start of each own slot so held
+ *                 frames go out at once (e.g. post the bridge task), or NULL
+ */
+void tdma_init(void (*slot_cb)(void));
+
+/**
+ * Check whether a frame may start now: inside the own slot
+ * and more than TDMA_GUARD_US before its end
+ *
+ * @return: true if TX is allowed (always when TDMA is off or unsynced)
+ */
+bool tdma_tx_open(void);
+
+/**
+ * Write the sync field of an outgoing frame
+ *
+ * @param sync: TDMA_SYNC_SIZE bytes
+ */
+void tdma_fill_sync(uint8_t *sync);
+
+/**
+ * Account an injected frame against the own slot
+ *
+ * @param airtime_us: Frame duration on air
+ */
+void tdma_note_tx(uint32_t airtime_us);
+
+/**
+ * Feed the sync field of an accepted frame (RX callback)
+ *
+ * @param sync: TDMA_SYNC_SIZE bytes
+ * @param rx_us: system_get_time() at the RX callback
+ * @param airtime_us: Frame duration on air
+ */
+void tdma_rx_sync(const uint8_t *sync, uint32_t rx_us, uint32_t airtime_us);
+
+/**
+ * Get scheduler state
+ *
+ * @return: TDMA_STATE_*
+ */
+uint8_t tdma_get_state(void);
+
+/**
+ * Get schedule statistics
+ *
+ * @return: Statistics
+ */
+const struct tdma_stats *tdma_get_stats(void);
+
+#endif /* TDMA_H */
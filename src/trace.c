@@ -0,0 +1,149 @@
+/* ==================================================
+ * Event Trace Ring Implementation
+ *
+ * Writers are the UART ISR, the WiFi callbacks and task
+ * code, so a slot is claimed with interrupts masked: a
+ * few instructions, whatever the ring size. The mask is
+ * raised with RSIL and restored from the saved PS rather
+ * than with ets_intr_lock/unlock, which do not nest and
+ * would unmask interrupts inside an ISR.
+ * ================================================== */
+
+#include "trace.h"
+#include "user_interface.h"
+
+#if TRACE_ENABLED && (TRACE_DEPTH & (TRACE_DEPTH - 1))
+#error "TRACE_DEPTH must be a power of 2"
+#endif
+
+#define TRACE_MASK      (TRACE_DEPTH - 1)
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+#if TRACE_ENABLED
+static struct trace_record trace_ring[TRACE_DEPTH];
+static volatile uint32_t trace_total = 0;   /* Next sequence number */
+static volatile uint8_t trace_running = 1;
+#endif
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+#if TRACE_ENABLED && defined(HOST_BUILD)
+/* Simulator: one thread, nothing can interrupt a record */
+static inline uint32_t trace_lock(void)
+{
+    return 0;
+}
+
+static inline void trace_unlock(uint32_t ps)
+{
+    (void)ps;
+}
+#elif TRACE_ENABLED
+/**
+ * Mask all interrupts (nests, unlike ets_intr_lock)
+ *
+ * @return: Previous PS, for trace_unlock()
+ */
+static inline uint32_t trace_lock(void)
+{
+    uint32_t ps;
+    __asm__ __volatile__("rsil %0, 15" : "=a"(ps) :: "memory");
+    return ps;
+}
+
+static inline void trace_unlock(uint32_t ps)
+{
+    __asm__ __volatile__("wsr %0, ps; rsync" :: "a"(ps) : "memory");
+}
+#endif
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void trace_put(uint8_t event, uint8_t a8, uint16_t a16) ICACHE_RAM_ATTR;
+void trace_put(uint8_t event, uint8_t a8, uint16_t a16)
+{
+#if TRACE_ENABLED
+    struct trace_record *r;
+    uint32_t ps;
+
+    if (!trace_running) {
+        return;
+    }
+
+    ps = trace_lock();
+    r = &trace_ring[trace_total & TRACE_MASK];
+    r->time_us = system_get_time();
+    r->event = event;
+    r->a8 = a8;
+    r->a16 = a16;
+    trace_total++;
+    trace_unlock(ps);
+#endif
+}
+
+void trace_set_running(bool on)
+{
+#if TRACE_ENABLED
+    trace_running = on ? 1 : 0;
+#endif
+}
+
+bool trace_get_running(void)
+{
+#if TRACE_ENABLED
+    return trace_running != 0;
+#else
+    return false;
+#endif
+}
+
+uint32_t trace_get_total(void)
+{
+#if TRACE_ENABLED
+    return trace_total;
+#else
+    return 0;
+#endif
+}
+
+uint8_t trace_read(uint32_t *first, struct trace_record *out, uint8_t max)
+{
+#if TRACE_ENABLED
+    uint32_t total = trace_total;
+    uint32_t oldest = (total > TRACE_DEPTH) ? total - TRACE_DEPTH : 0;
+    uint32_t seq = *first;
+    uint8_t n = 0;
+
+    if ((int32_t)(seq - oldest) < 0) {
+        seq = oldest;
+    } else if ((int32_t)(seq - total) > 0) {
+        seq = total;
+    }
+    *first = seq;
+
+    /* A recording ring may overwrite what is being copied; the
+     * host pauses it (SET_TRACE 0) for a consistent dump */
+    while (n < max && seq != total) {
+        out[n++] = trace_ring[seq & TRACE_MASK];
+        seq++;
+    }
+    return n;
+#else
+    return 0;
+#endif
+}
+
+void trace_clear(void)
+{
+#if TRACE_ENABLED
+    /* Slots past the total are never read, so no need to wipe them */
+    trace_total = 0;
+#endif
+}
@@ -0,0 +1,119 @@
+/* ==================================================
+ * Event Trace Ring
+ * Fixed-size in-RAM ring of timestamped binary events
+ * along the UART <-> air path, read back in-band with
+ * GET_TRACE and decoded on the host by
+ * tools/trace_decode.py. Trace points compile out
+ * entirely with TRACE_ENABLED = 0.
+ * ================================================== */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "c_types.h"
+#include "user_config.h"
+
+/* ==================================================
+ * EVENTS
+ * ================================================== */
+
+/* Event codes (keep in sync with tools/trace_decode.py) */
+enum trace_event {
+    TRACE_EV_NONE,
+    TRACE_EV_UART_RX_START,     /* a8 = LEN_HI (first byte of a frame) */
+    TRACE_EV_UART_RX_END,       /* a8 = LEN_HI flags, a16 = payload length */
+    TRACE_EV_UART_RESYNC,       /* Parser dropped a prefix, a8 = LEN_HI, a16 = bad length */
+    TRACE_EV_UART_RX_OVERFLOW,  /* RX ring full, a16 = bytes dropped */
+    TRACE_EV_UART_TX_OVERFLOW,  /* TX ring full, a8 = ring (1 = priority), a16 = frame length */
+    TRACE_EV_TXQ_STALE,         /* Frame aged out, a8 = class, a16 = age in 100 us */
+    TRACE_EV_TXQ_FULL,          /* Oldest frame evicted, a8 = class */
+    TRACE_EV_TX_SUBMIT,         /* a8 = link << 1 | class, a16 = payload length */
+    TRACE_EV_TX_DONE,           /* a8 = SDK status */
+    TRACE_EV_TX_BUSY,           /* Previous frame still on air, a16 = payload length */
+    TRACE_EV_TX_ERROR,          /* a8 = TRACE_TX_ERR_*, a16 = payload length */
+    TRACE_EV_RX_ACCEPT,         /* a8 = link, a16 = payload length */
+    TRACE_EV_RX_REJECT,         /* a8 = enum rx_stage, a16 = legacy_length */
+    TRACE_EV_CHANNEL,           /* a8 = new channel */
+    TRACE_EV_TXQ_SUPERSEDED,    /* Older frame replaced by a newer one, a8 = class, a16 = link */
+    TRACE_EV_COUNT
+};
+
+/* TRACE_EV_TX_ERROR reasons */
+#define TRACE_TX_ERR_INVALID    0           /* Bad length */
+#define TRACE_TX_ERR_NO_LINK    1           /* Link removed while queued */
+#define TRACE_TX_ERR_SDK        2           /* wifi_send_pkt_freedom() failed */
+
+/* One ring entry (little-endian on the wire, as stored) */
+struct trace_record {
+    uint32_t time_us;           /* system_get_time() */
+    uint8_t event;              /* enum trace_event */
+    uint8_t a8;
+    uint16_t a16;
+};
+
+#define TRACE_RECORD_SIZE       8
+
+/* Saturate a wider argument to a16 */
+#define TRACE_U16(x)            ((x) < 0xFFFF ? (uint16_t)(x) : 0xFFFF)
+
+/* Trace points: no code at all when disabled */
+#if TRACE_ENABLED
+#define TRACE(event, a8, a16)   trace_put((event), (a8), (a16))
+#else
+#define TRACE(event, a8, a16)   do {} while (0)
+#endif
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Record an event (constant time, ISR-safe)
+ *
+ * @param event: enum trace_event
+ * @param a8: 8-bit argument
+ * @param a16: 16-bit argument
+ */
+void trace_put(uint8_t event, uint8_t a8, uint16_t a16);
+
+/**
+ * Pause or resume recording (pause before a dump so the
+ * dump's own UART traffic does not overwrite the ring)
+ *
+ * @param on: true to record
+ */
+void trace_set_running(bool on);
+
+/**
+ * Check whether events are being recorded
+ *
+ * @return: true if recording
+ */
+bool trace_get_running(void);
+
+/**
+ * Get the number of events recorded since boot (or the last
+ * trace_clear); event n is held while n >= total - TRACE_DEPTH
+ *
+ * @return: Events recorded
+ */
+uint32_t trace_get_total(void);
+
+/**
+ * Copy retained events out of the ring, oldest first
+ *
+ * @param first: In: sequence number of the first event wanted,
+ *               out: sequence number of the first event copied
+ *               (moved up to the oldest one still held)
+ * @param out: Destination records
+ * @param max: Records that fit in out
+ * @return: Records copied
+ */
+uint8_t trace_read(uint32_t *first, struct trace_record *out, uint8_t max);
+
+/**
+ * Drop all events
+ */
+void trace_clear(void);
+
+#endif /* TRACE_H */
@@ -0,0 +1,375 @@
+/* ==================================================
+ * Traffic Generator Implementation
+ *
+ * Frames are local aggregate records sent straight to
+ * wifi_raw_send(), so the receiver's ctrl_air_rx() picks
+ * them out of the stream without the flight controller
+ * seeing them. They are not charged to the airtime
+ * budget, which stays with the bridged traffic. Send times come from a schedule (due
+ * time) rather than from the last send: a microsecond
+ * timer fires at the next due time, and the bridge task
+ * pumps again on every TX completion, so a run is only
+ * limited by the radio, not by the 10 ms main timer.
+ * ================================================== */
+
+#include "trafgen.h"
+#include "user_config.h"
+#include "wifi_raw.h"
+#include "links.h"
+#include "ctrl.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+/* Timer re-arm while the radio is busy (TX done pumps sooner) */
+#define TRAFGEN_RETRY_US        1000
+
+/* Shortest timer arm */
+#define TRAFGEN_MIN_ARM_US      20
+
+/* Frames the schedule may fall behind before it restarts from now */
+#define TRAFGEN_MAX_LAG         8
+
+/* ln(2) in Q16 */
+#define TRAFGEN_LN2_Q16         45426
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+static os_timer_t gen_timer;
+static struct trafgen_config gen_cfg;
+static struct trafgen_tx_stats gen_stats;
+static uint8_t gen_state = TRAFGEN_STATE_IDLE;
+static uint8_t gen_run = 0;
+static uint32_t gen_seq = 0;
+static uint32_t gen_interval_us = 0;        /* Mean interval */
+static uint32_t gen_due_us = 0;             /* Next frame due */
+static uint32_t gen_start_us = 0;
+static uint8_t gen_burst_pos = 0;
+static bool gen_blocked = false;            /* Due frame already counted busy */
+static uint32_t gen_rng = 1;
+
+static uint8_t gen_frame[MAX_AIR_PAYLOAD_SIZE];
+
+/* Receiver */
+static struct trafgen_rx_stats rx_stats;
+static bool rx_active = false;
+static uint32_t rx_first_seq = 0;
+static uint32_t rx_max_seq = 0;
+static uint32_t rx_first_us = 0;
+static int32_t rx_last_transit = 0;
+static uint32_t rx_jitter_x16 = 0;
+static uint32_t rx_reported = 0;            /* received at the last push */
+static uint32_t rx_report_us = 0;
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+/**
+ * -log2(u / 65536) in Q16 for u in 1..65536
+ * Integer part from normalization, fraction by repeated squaring.
+ */
+static uint32_t trafgen_neg_log2(uint32_t u)
+{
+    uint32_t frac = 0;
+    uint8_t k = 0;
+    uint8_t i;
+
+    if (u >= 0x10000) {
+        return 0;
+    }
+
+    /* u / 2^16 = 2^-(k+1) * z, z in [1, 2) as Q15 */
+    while (u < 0x8000) {
+        u <<= 1;
+        k++;
+    }
+
+    for (i = 1; i <= 16; i++) {
+        u = (u * u) >> 15;
+        if (u >= 0x10000) {
+            u >>= 1;
+            frac |= 1u << (16 - i);
+        }
+    }
+
+    return ((uint32_t)(k + 1) << 16) - frac;
+}
+
+/**
+ * Exponentially distributed interval (Poisson arrivals)
+ *
+ * @param mean_us: Mean interval
+ * @return: Interval in microseconds
+ */
+static uint32_t trafgen_exp_us(uint32_t mean_us)
+{
+    uint64_t t;
+
+    gen_rng ^= gen_rng << 13;
+    gen_rng ^= gen_rng >> 17;
+    gen_rng ^= gen_rng << 5;
+
+    /* -ln(U) * mean, U uniform in (0, 1] */
+    t = ((uint64_t)mean_us * trafgen_neg_log2((gen_rng & 0xFFFF) + 1)) >> 16;
+    return (uint32_t)((t * TRAFGEN_LN2_Q16) >> 16);
+}
+
+/**
+ * Move the due time past the frame just sent
+ */
+static void trafgen_schedule(uint32_t now)
+{
+    switch (gen_cfg.pattern) {
+        case TRAFGEN_BURST:
+            /* Rest of the burst goes as soon as the radio is free */
+            if (++gen_burst_pos < gen_cfg.burst) {
+                return;
+            }
+            gen_burst_pos = 0;
+            gen_due_us += gen_interval_us * gen_cfg.burst;
+            break;
+
+        case TRAFGEN_POISSON:
+            gen_due_us += trafgen_exp_us(gen_interval_us);
+            break;
+
+        default:
+            gen_due_us += gen_interval_us;
+            break;
+    }
+
+    /* Offered rate above what the radio sustains: don't build a backlog */
+    if ((int32_t)(now - gen_due_us) > (int32_t)(gen_interval_us * TRAFGEN_MAX_LAG)) {
+        gen_due_us = now;
+    }
+}
+
+/**
+ * Build and send one frame
+ *
+ * @return: false if the radio is busy
+ */
+static bool trafgen_send(uint32_t now)
+{
+    uint16_t size = gen_cfg.size;
+
+    if (!wifi_raw_tx_ready()) {
+        return false;
+    }
+
+    gen_frame[0] = ((size >> 8) & 0xFF) | UART_LEN_LOCAL_BIT;
+    gen_frame[1] = size & 0xFF;
+    gen_frame[2] = AIR_MSG_TRAFGEN;
+    gen_frame[3] = gen_run;
+    ctrl_put_u32(gen_frame + 4, gen_seq);
+    ctrl_put_u32(gen_frame + 8, now);
+
+    if (wifi_raw_send(gen_frame, AGG_RECORD_HEADER_SIZE + size, TC_BULK, gen_cfg.link, false) != 0) {
+        gen_stats.errors++;
+    } else {
+        gen_stats.sent++;
+    }
+
+    /* A failed frame is not retried - the receiver sees it as lost */
+    gen_seq++;
+    gen_stats.elapsed_us = now - gen_start_us;
+    return true;
+}
+
+/**
+ * Generator timer: next frame due (or retry while busy)
+ */
+static void trafgen_timer_cb(void *arg)
+{
+    trafgen_pump();
+}
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void trafgen_init(void)
+{
+    os_memset(&gen_cfg, 0, sizeof(gen_cfg));
+    os_memset(&gen_stats, 0, sizeof(gen_stats));
+    os_memset(&rx_stats, 0, sizeof(rx_stats));
+    gen_state = TRAFGEN_STATE_IDLE;
+    rx_active = false;
+
+    os_timer_disarm(&gen_timer);
+    os_timer_setfn(&gen_timer, (os_timer_func_t *)trafgen_timer_cb, NULL);
+}
+
+bool trafgen_start(const struct trafgen_config *cfg)
+{
+    uint16_t i;
+
+    if (!AGG_ENABLED || links_get_bssid(cfg->link) == NULL ||
+        cfg->pattern >= TRAFGEN_PATTERN_COUNT || cfg->rate_pps == 0 ||
+        cfg->size < TRAFGEN_HEADER_SIZE || cfg->size > MAX_BRIDGE_PACKET_SIZE ||
+        (cfg->pattern == TRAFGEN_BURST && cfg->burst == 0)) {
+        return false;
+    }
+
+    os_timer_disarm(&gen_timer);
+
+    gen_cfg = *cfg;
+    os_memset(&gen_stats, 0, sizeof(gen_stats));
+    gen_run++;
+    gen_seq = 0;
+    gen_burst_pos = 0;
+    gen_blocked = false;
+    gen_interval_us = 1000000 / cfg->rate_pps;
+    gen_start_us = system_get_time();
+    gen_due_us = gen_start_us;
+    gen_rng = gen_start_us | 1;
+
+    /* Fill: a counting pattern, so corrupted bytes are easy to spot */
+    for (i = TRAFGEN_HEADER_SIZE; i < cfg->size; i++) {
+        gen_frame[AGG_RECORD_HEADER_SIZE + i] = i & 0xFF;
+    }
+
+    gen_state = TRAFGEN_STATE_RUNNING;
+    trafgen_pump();
+    return true;
+}
+
+void trafgen_stop(void)
+{
+    os_timer_disarm(&gen_timer);
+    if (gen_state == TRAFGEN_STATE_RUNNING) {
+        gen_state = TRAFGEN_STATE_DONE;
+    }
+}
+
+void trafgen_pump(void)
+{
+    uint32_t now;
+    int32_t wait;
+
+    if (gen_state != TRAFGEN_STATE_RUNNING) {
+        return;
+    }
+
+    now = system_get_time();
+    wait = (int32_t)(gen_due_us - now);
+
+    if (wait <= 0) {
+        if (!trafgen_send(now)) {
+            if (!gen_blocked) {
+                gen_blocked = true;
+                gen_stats.busy++;
+            }
+            os_timer_arm_us(&gen_timer, TRAFGEN_RETRY_US, 0);
+            return;
+        }
+
+        gen_blocked = false;
+        if (gen_cfg.count != 0 && gen_seq >= gen_cfg.count) {
+            gen_state = TRAFGEN_STATE_DONE;
+            os_timer_disarm(&gen_timer);
+            return;
+        }
+
+        trafgen_schedule(now);
+        wait = (int32_t)(gen_due_us - system_get_time());
+    }
+
+    /* Already due again: our frame is on air, TX done pumps and
+     * the timer is only a fallback */
+    if (wait <= 0) {
+        wait = TRAFGEN_RETRY_US;
+    } else if (wait < TRAFGEN_MIN_ARM_US) {
+        wait = TRAFGEN_MIN_ARM_US;
+    }
+    os_timer_arm_us(&gen_timer, wait, 0);
+}
+
+void trafgen_poll(void)
+{
+    uint32_t now = system_get_time();
+
+    if (TRAFGEN_REPORT_MS == 0 || !rx_active || rx_stats.received == rx_reported ||
+        now - rx_report_us < TRAFGEN_REPORT_MS * 1000) {
+        return;
+    }
+
+    if (ctrl_send_trafrx()) {
+        rx_reported = rx_stats.received;
+        rx_report_us = now;
+    }
+}
+
+void trafgen_air_rx(const uint8_t *msg, uint16_t len)
+{
+    uint32_t now = system_get_time();
+    uint32_t seq, tx_us;
+    int32_t transit, d;
+
+    if (len < TRAFGEN_HEADER_SIZE) {
+        return;
+    }
+
+    seq = msg[2] | (msg[3] << 8) | ((uint32_t)msg[4] << 16) | ((uint32_t)msg[5] << 24);
+    tx_us = msg[6] | (msg[7] << 8) | ((uint32_t)msg[8] << 16) | ((uint32_t)msg[9] << 24);
+
+    /* The clocks differ by a constant; it cancels in the jitter */
+    transit = (int32_t)(now - tx_us);
+
+    /* New run from the sender: start over */
+    if (!rx_active || msg[1] != rx_stats.run) {
+        os_memset(&rx_stats, 0, sizeof(rx_stats));
+        rx_stats.run = msg[1];
+        rx_active = true;
+        rx_first_seq = seq;
+        rx_max_seq = seq;
+        rx_first_us = now;
+        rx_last_transit = transit;
+        rx_jitter_x16 = 0;
+        rx_reported = 0;
+    } else if ((int32_t)(seq - rx_max_seq) > 0) {
+        rx_max_seq = seq;
+    } else {
+        rx_stats.reordered++;
+    }
+
+    /* J += (|D| - J) / 16 */
+    d = transit - rx_last_transit;
+    if (d < 0) {
+        d = -d;
+    }
+    rx_jitter_x16 += d - (rx_jitter_x16 + 8) / 16;
+    rx_last_transit = transit;
+
+    rx_stats.received++;
+    rx_stats.bytes += len;
+    rx_stats.elapsed_us = now - rx_first_us;
+}
+
+uint8_t trafgen_get_state(void)
+{
+    return gen_state;
+}
+
+const struct trafgen_config *trafgen_get_config(void)
+{
+    return &gen_cfg;
+}
+
+const struct trafgen_tx_stats *trafgen_get_tx_stats(void)
+{
+    return &gen_stats;
+}
+
+const struct trafgen_rx_stats *trafgen_get_rx_stats(void)
+{
+    uint32_t expected = rx_max_seq - rx_first_seq + 1;
+
+    if (rx_active) {
+        rx_stats.lost = (expected > rx_stats.received) ? expected - rx_stats.received : 0;
+        rx_stats.jitter_us = rx_jitter_x16 / 16;
+    }
+    return &rx_stats;
+}
@@ -0,0 +1,130 @@
+/* ==================================================
+ * Traffic Generator
+ * Built-in test traffic for range and throughput runs:
+ * sequence-numbered, timestamped frames at a set size,
+ * rate and pattern, and the receive-side loss,
+ * throughput and jitter measurement
+ * ================================================== */
+
+#ifndef TRAFGEN_H
+#define TRAFGEN_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * TYPES
+ * ================================================== */
+
+/* Inter-frame patterns */
+#define TRAFGEN_CONSTANT        0           /* Fixed interval */
+#define TRAFGEN_BURST           1           /* Back-to-back bursts, same average rate */
+#define TRAFGEN_POISSON         2           /* Exponential intervals */
+#define TRAFGEN_PATTERN_COUNT   3
+
+/* Generator states (reported in GET_TRAFGEN) */
+#define TRAFGEN_STATE_IDLE      0
+#define TRAFGEN_STATE_RUNNING   1
+#define TRAFGEN_STATE_DONE      2
+
+/* Generator settings */
+struct trafgen_config {
+    uint8_t link;               /* Link ID to send on */
+    uint8_t pattern;            /* TRAFGEN_* pattern */
+    uint16_t size;              /* Record length (TRAFGEN_HEADER_SIZE..MAX_BRIDGE_PACKET_SIZE) */
+    uint16_t rate_pps;          /* Average frames per second */
+    uint8_t burst;              /* Frames per burst (TRAFGEN_BURST) */
+    uint32_t count;             /* Frames to send (0 = until stopped) */
+};
+
+/* Sender statistics of the current or last run */
+struct trafgen_tx_stats {
+    uint32_t sent;
+    uint32_t busy;              /* Frames that had to wait for the radio */
+    uint32_t errors;            /* wifi_raw_send() failures */
+    uint32_t elapsed_us;        /* First to last frame sent */
+};
+
+/* Receiver statistics of the last run heard */
+struct trafgen_rx_stats {
+    uint8_t run;                /* Sender's run ID */
+    uint32_t received;
+    uint32_t lost;              /* Sequence numbers never seen */
+    uint32_t reordered;         /* Arrived after a higher sequence number */
+    uint32_t bytes;             /* Record bytes received */
+    uint32_t elapsed_us;        /* First to last frame received */
+    uint32_t jitter_us;         /* RFC 3550 interarrival jitter */
+};
+
+/* Record layout: [AIR_MSG_TRAFGEN][run][seq u32][tx_us u32][fill...] */
+#define TRAFGEN_HEADER_SIZE     10
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Reset generator and receiver state
+ */
+void trafgen_init(void);
+
+/**
+ * Start a generator run (replaces a running one)
+ *
+ * @param cfg: Settings
+ * @return: false if AGG_ENABLED is off or a setting is invalid
+ */
+bool trafgen_start(const struct trafgen_config *cfg);
+
+/**
+ * Stop the generator
+ */
+void trafgen_stop(void);
+
+/**
+ * Send the next frame if it is due and the radio is free
+ * (microsecond timer, and again on every TX completion)
+ */
+void trafgen_pump(void);
+
+/**
+ * Push receiver reports every TRAFGEN_REPORT_MS (main timer)
+ */
+void trafgen_poll(void);
+
+/**
+ * Handle an AIR_MSG_TRAFGEN record (RX callback)
+ *
+ * @param msg: Record
+ * @param len: Record length
+ */
+void trafgen_air_rx(const uint8_t *msg, uint16_t len);
+
+/**
+ * Get generator state
+ *
+ * @return: TRAFGEN_STATE_*
+ */
+uint8_t trafgen_get_state(void);
+
+/**
+ * Get generator settings of the current or last run
+ *
+ * @return: Settings
+ */
+const struct trafgen_config *trafgen_get_config(void);
+
+/**
+ * Get sender statistics
+ *
+ * @return: Statistics
+ */
+const struct trafgen_tx_stats *trafgen_get_tx_stats(void);
+
+/**
+ * Get receiver statistics (lost is brought up to date)
+ *
+ * @return: Statistics
+ */
+const struct trafgen_rx_stats *trafgen_get_rx_stats(void);
+
+#endif /* TRAFGEN_H */
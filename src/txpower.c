@@ -0,0 +1,203 @@
+/* ==================================================
+ * TX Power Control Implementation
+ *
+ * Peer reports arrive in the RX callback, where they
+ * are only stored, one slot per link. txpower_poll()
+ * acts on them from the main timer: there is one power
+ * level for all links, so the weakest link's report
+ * drives the loop and a strong peer cannot pull the
+ * power down under a weak one.
+ * ================================================== */
+
+#include "txpower.h"
+#include "user_config.h"
+#include "wifi_raw.h"
+#include "aggregate.h"
+#include "ctrl.h"
+#include "links.h"
+#include "linkq.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+/* ==================================================
+ * STATE
+ * ================================================== */
+
+static uint8_t txpower_qdbm = TXPOWER_DEFAULT_QDBM;
+static bool txpower_auto = TXPOWER_AUTO_ENABLED;
+
+/* Reports from the peer on each link (written in the RX callback) */
+struct txpower_peer {
+    int8_t rssi;                /* How the peer hears us (dBm) */
+    uint8_t valid;              /* Reports are arriving */
+    uint8_t fresh;              /* Not yet acted on by txpower_poll() */
+    uint32_t report_us;         /* When the last one arrived */
+};
+
+static struct txpower_peer peers[LINK_ID_COUNT];
+
+static int8_t peer_rssi = 0;            /* Weakest valid report */
+
+static uint32_t report_sent_us[LINK_ID_COUNT];  /* Our last report per link */
+
+/* Statistics */
+static uint32_t txpower_change_count = 0;
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+/**
+ * Apply a new power level if it differs from the current one
+ */
+static void txpower_apply(uint8_t qdbm)
+{
+    if (qdbm > TXPOWER_MAX_QDBM) {
+        qdbm = TXPOWER_MAX_QDBM;
+    }
+
+    if (qdbm == txpower_qdbm) {
+        return;
+    }
+
+    system_phy_set_max_tpw(qdbm);
+    txpower_qdbm = qdbm;
+    txpower_change_count++;
+    DEBUG_PRINTF("TX power: %u qdBm (peer rssi %d)\n", qdbm, peer_rssi);
+}
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void txpower_init(void)
+{
+    txpower_qdbm = TXPOWER_DEFAULT_QDBM;
+    txpower_auto = TXPOWER_AUTO_ENABLED;
+    os_memset(peers, 0, sizeof(peers));
+    os_memset(report_sent_us, 0, sizeof(report_sent_us));
+    txpower_change_count = 0;
+
+    /* Always write once - the SDK default is not ours */
+    system_phy_set_max_tpw(txpower_qdbm);
+}
+
+void txpower_set(uint8_t qdbm)
+{
+    txpower_apply(qdbm);
+}
+
+uint8_t txpower_get(void)
+{
+    return txpower_qdbm;
+}
+
+void txpower_set_auto(bool enable)
+{
+    txpower_auto = enable;
+}
+
+bool txpower_get_auto(void)
+{
+    return txpower_auto;
+}
+
+void txpower_peer_report(uint8_t link, int8_t rssi)
+{
+    struct txpower_peer *peer;
+
+    if (link >= LINK_ID_COUNT) {
+        return;
+    }
+
+    peer = &peers[link];
+    peer->rssi = rssi;
+    peer->report_us = system_get_time();
+    peer->valid = 1;
+    peer->fresh = 1;
+}
+
+void txpower_poll(void)
+{
+    uint32_t now = system_get_time();
+    struct linkq_report lq;
+    int8_t weakest = 0;
+    bool heard = false;
+    bool weakest_fresh = false;
+    bool faded = false;
+    uint8_t link;
+
+    for (link = 0; link < LINK_ID_COUNT; link++) {
+        struct txpower_peer *peer = &peers[link];
+
+        /* Tell each peer how we hear it, while we are hearing it */
+        if (now - report_sent_us[link] >= TXPOWER_REPORT_MS * 1000 &&
+            links_get_bssid(link) != NULL && linkq_get(link, &lq) &&
+            lq.age_ms < TXPOWER_REPORT_TIMEOUT_MS) {
+            uint8_t msg[2];
+
+            msg[0] = AIR_MSG_RSSI_REPORT;
+            msg[1] = (uint8_t)lq.rssi;
+            if (agg_submit_local(link, msg, sizeof(msg))) {
+                report_sent_us[link] = now;
+            }
+        }
+
+        if (!peer->valid) {
+            continue;
+        }
+
+        /* Reports stopped: that peer may have faded out */
+        if (now - peer->report_us > TXPOWER_REPORT_TIMEOUT_MS * 1000) {
+            peer->valid = 0;
+            faded = true;
+        } else if (!heard || peer->rssi < weakest) {
+            weakest = peer->rssi;
+            weakest_fresh = peer->fresh;
+            heard = true;
+        }
+        peer->fresh = 0;
+    }
+
+    if (heard) {
+        peer_rssi = weakest;
+    }
+
+    if (!txpower_auto) {
+        return;
+    }
+
+    if (faded) {
+        txpower_apply(TXPOWER_MAX_QDBM);
+    } else if (weakest_fresh) {
+        /* One step per report from the weakest link */
+        int16_t margin = weakest - TXPOWER_RSSI_FLOOR;
+        int16_t level = txpower_qdbm;
+
+        if (margin > TXPOWER_MARGIN_HIGH_DB) {
+            level -= TXPOWER_STEP_DOWN_QDBM;
+            if (level < TXPOWER_MIN_QDBM) {
+                level = TXPOWER_MIN_QDBM;
+            }
+        } else if (margin < TXPOWER_MARGIN_LOW_DB) {
+            level += TXPOWER_STEP_UP_QDBM;
+        }
+
+        txpower_apply(level);
+    }
+}
+
+int8_t txpower_get_peer_rssi(void)
+{
+    return peer_rssi;
+}
+
+int8_t txpower_get_local_rssi(void)
+{
+    return wifi_raw_get_rssi();
+}
+
+uint32_t txpower_get_change_count(void)
+{
+    return txpower_change_count;
+}
@@ -0,0 +1,88 @@
+/* ==================================================
+ * TX Power Control
+ * Runtime TX power via system_phy_set_max_tpw() with an
+ * optional closed loop driven by peer-reported RSSI
+ * ================================================== */
+
+#ifndef TXPOWER_H
+#define TXPOWER_H
+
+#include "c_types.h"
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Apply boot TX power (TXPOWER_DEFAULT_QDBM)
+ * Must be called after WiFi init.
+ */
+void txpower_init(void);
+
+/**
+ * Set TX power
+ *
+ * @param qdbm: Power in 0.25 dBm units (0-82)
+ */
+void txpower_set(uint8_t qdbm);
+
+/**
+ * Get current TX power
+ *
+ * @return: Power in 0.25 dBm units
+ */
+uint8_t txpower_get(void);
+
+/**
+ * Enable or disable the closed loop
+ *
+ * @param enable: true to let peer RSSI reports adjust power
+ */
+void txpower_set_auto(bool enable);
+
+/**
+ * Check whether the closed loop is active
+ *
+ * @return: true if enabled
+ */
+bool txpower_get_auto(void);
+
+/**
+ * Store an RSSI report from the peer on a link (RX callback -
+ * constant work; txpower_poll() acts on it)
+ *
+ * @param link: Link the report arrived on
+ * @param rssi: Peer-measured RSSI of our frames (dBm)
+ */
+void txpower_peer_report(uint8_t link, int8_t rssi);
+
+/**
+ * Periodic work: send each heard peer our RSSI report for its link,
+ * step power by the weakest link's fresh report (down slowly while
+ * the margin is high, up fast when it drops) and fall back to max
+ * power if any peer's reports stop. Call from main timer.
+ */
+void txpower_poll(void);
+
+/**
+ * Get the weakest RSSI reported by the peers (drives the loop)
+ *
+ * @return: dBm (0 if none yet)
+ */
+int8_t txpower_get_peer_rssi(void);
+
+/**
+ * Get RSSI at which we hear the peer (average)
+ *
+ * @return: dBm (0 if none yet)
+ */
+int8_t txpower_get_local_rssi(void);
+
+/**
+ * Get number of power changes
+ *
+ * @return: Changes since init
+ */
+uint32_t txpower_get_change_count(void);
+
+#endif /* TXPOWER_H */
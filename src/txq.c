@@ -0,0 +1,311 @@
+/* ==================================================
+ * Uplink TX Queue Implementation
+ *
+ * Small slot arrays scanned linearly (depths are tiny).
+ * Classes are served in strict priority order; within a
+ * class, NEWEST_FIRST sends the freshest frame first so a
+ * backlog never delays the latest RC update.
+ * ================================================== */
+
+#include "txq.h"
+#include "user_config.h"
+#include "aggregate.h"
+#include "airtime.h"
+#include "wifi_raw.h"
+#include "latency.h"
+#include "trace.h"
+#include "rates.h"
+#include "osapi.h"
+#include "user_interface.h"
+
+/* ==================================================
+ * STATIC BUFFERS
+ * ================================================== */
+
+struct txq_slot {
+    uint32_t timestamp;                 /* UART arrival time (us) */
+    uint16_t len;                       /* 0 = slot free */
+    uint8_t  link;                      /* Link ID (BSSID) */
+    uint8_t  data[MAX_BRIDGE_PACKET_SIZE];
+};
+
+struct txq_class {
+    struct txq_slot *slots;
+    uint8_t  depth;
+    uint8_t  newest_first;
+    uint32_t max_age_us;                /* 0 = no deadline */
+    uint8_t  drop_over_budget;          /* 1 = drop, 0 = wait for airtime */
+
+    /* Statistics */
+    uint32_t stale_drop_count;
+    uint32_t full_drop_count;
+    uint32_t superseded_drop_count;
+    uint8_t  peak;                      /* Most slots occupied at once */
+    struct log_hist age_hist;
+};
+
+/* Frames too long for one 802.11 frame the peer can receive */
+static uint32_t txq_oversize_drop_count = 0;
+
+static struct txq_slot bulk_slots[TXQ_BULK_DEPTH];
+static struct txq_slot prio_slots[TXQ_PRIO_DEPTH];
+
+/* Indexed by traffic class */
+static struct txq_class txq_classes[TC_COUNT] = {
+    { bulk_slots, TXQ_BULK_DEPTH, TXQ_BULK_NEWEST_FIRST, TXQ_BULK_MAX_AGE_US, AIRTIME_BUDGET_DROP_BULK },
+    { prio_slots, TXQ_PRIO_DEPTH, TXQ_PRIO_NEWEST_FIRST, TXQ_PRIO_MAX_AGE_US, AIRTIME_BUDGET_DROP_PRIO },
+};
+
+/* ==================================================
+ * HELPERS
+ * ================================================== */
+
+/**
+ * Find the slot to send next, dropping stale frames on the way
+ * With newest-first, the older frames for the same link are
+ * dropped too: they carry state the chosen frame replaces, and
+ * sending them after it would make the stale one take effect.
+ *
+ * @param q: Class queue
+ * @param now: Current system_get_time()
+ * @return: Slot index, or -1 if queue empty
+ */
+static int txq_select(struct txq_class *q, uint32_t now)
+{
+    int best = -1;
+    uint8_t i;
+
+    for (i = 0; i < q->depth; i++) {
+        struct txq_slot *slot = &q->slots[i];
+        int32_t newer;
+
+        if (slot->len == 0) {
+            continue;
+        }
+
+        if (q->max_age_us > 0 && now - slot->timestamp > q->max_age_us) {
+            TRACE(TRACE_EV_TXQ_STALE, q - txq_classes, TRACE_U16((now - slot->timestamp) / 100));
+            slot->len = 0;
+            q->stale_drop_count++;
+            RATE_ADD(RATE_DROPS, 1);
+            continue;
+        }
+
+        if (best < 0) {
+            best = i;
+            continue;
+        }
+
+        newer = (int32_t)(slot->timestamp - q->slots[best].timestamp);
+        if (q->newest_first ? (newer > 0) : (newer < 0)) {
+            best = i;
+        }
+    }
+
+    if (q->newest_first && best >= 0) {
+        for (i = 0; i < q->depth; i++) {
+            struct txq_slot *slot = &q->slots[i];
+
+            if (i != best && slot->len != 0 && slot->link == q->slots[best].link) {
+                TRACE(TRACE_EV_TXQ_SUPERSEDED, q - txq_classes, slot->link);
+                slot->len = 0;
+                q->superseded_drop_count++;
+                RATE_ADD(RATE_DROPS, 1);
+            }
+        }
+    }
+
+    return best;
+}
+
+/* ==================================================
+ * PUBLIC API IMPLEMENTATION
+ * ================================================== */
+
+void txq_init(void)
+{
+    uint8_t tc;
+    uint8_t i;
+
+    for (tc = 0; tc < TC_COUNT; tc++) {
+        for (i = 0; i < txq_classes[tc].depth; i++) {
+            txq_classes[tc].slots[i].len = 0;
+        }
+    }
+
+    txq_reset_stats();
+}
+
+void txq_push(uint8_t tclass, uint8_t link, const uint8_t *frame, uint16_t len, uint32_t timestamp)
+{
+    struct txq_class *q;
+    int slot = -1;
+    uint8_t i;
+
+    if (tclass >= TC_COUNT || len == 0) {
+        return;
+    }
+
+    /* The receiver only captures MAX_AIR_PAYLOAD_SIZE bytes: refuse
+     * here, before the frame can evict a queued one (this also bounds
+     * the copy into the slot) */
+    if (len > MAX_BRIDGE_PACKET_SIZE) {
+        txq_oversize_drop_count++;
+        RATE_ADD(RATE_DROPS, 1);
+        TRACE(TRACE_EV_TX_ERROR, TRACE_TX_ERR_INVALID, len);
+        return;
+    }
+
+    q = &txq_classes[tclass];
+
+    /* Free slot, otherwise evict the oldest frame */
+    for (i = 0; i < q->depth; i++) {
+        if (q->slots[i].len == 0) {
+            slot = i;
+            break;
+        }
+        if (slot < 0 ||
+            (int32_t)(q->slots[i].timestamp - q->slots[slot].timestamp) < 0) {
+            slot = i;
+        }
+    }
+
+    if (q->slots[slot].len != 0) {
+        q->full_drop_count++;
+        RATE_ADD(RATE_DROPS, 1);
+        TRACE(TRACE_EV_TXQ_FULL, tclass, 0);
+    }
+
+    q->slots[slot].timestamp = timestamp;
+    q->slots[slot].len = len;
+    q->slots[slot].link = link;
+    os_memcpy(q->slots[slot].data, frame, len);
+
+    i = txq_count(tclass);
+    if (i > q->peak) {
+        q->peak = i;
+    }
+}
+
+void txq_pump(void)
+{
+    /* Only pull frames while the radio is free, so the deadline check
+     * happens right before wifi_send_pkt_freedom() */
+    while (wifi_raw_tx_ready()) {
+        uint32_t now = system_get_time();
+        struct txq_class *q = NULL;
+        int slot = -1;
+        int tc;
+
+        /* Strict priority: highest class with a live frame wins */
+        for (tc = TC_COUNT - 1; tc >= 0; tc--) {
+            slot = txq_select(&txq_classes[tc], now);
+            if (slot >= 0) {
+                q = &txq_classes[tc];
+                break;
+            }
+        }
+
+        if (q == NULL) {
+            break;
+        }
+
+        /* Airtime budget: by class, drop the frame or leave it queued
+         * (it still ages out against its deadline while waiting) */
+        if (!airtime_budget_ok()) {
+            if (q->drop_over_budget) {
+                q->slots[slot].len = 0;
+                airtime_budget_note_over(tc, true);
+                RATE_ADD(RATE_DROPS, 1);
+                continue;
+            }
+            airtime_budget_note_over(tc, false);
+            break;
+        }
+
+        if (!agg_submit(tc, q->slots[slot].link, q->slots[slot].data, q->slots[slot].len)) {
+            break;
+        }
+
+        hist_add(&q->age_hist, now - q->slots[slot].timestamp);
+        LAT_US(LAT_TX_QUEUE, now - q->slots[slot].timestamp);
+        q->slots[slot].len = 0;
+    }
+
+    /* Send a partially packed frame once its hold time is up */
+    agg_poll();
+}
+
+uint8_t txq_count(uint8_t tclass)
+{
+    uint8_t count = 0;
+    uint8_t i;
+
+    if (tclass >= TC_COUNT) {
+        return 0;
+    }
+
+    for (i = 0; i < txq_classes[tclass].depth; i++) {
+        if (txq_classes[tclass].slots[i].len != 0) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/* ==================================================
+ * STATISTICS
+ * ================================================== */
+
+uint32_t txq_get_stale_drop_count(uint8_t tclass)
+{
+    return (tclass < TC_COUNT) ? txq_classes[tclass].stale_drop_count : 0;
+}
+
+uint32_t txq_get_full_drop_count(uint8_t tclass)
+{
+    return (tclass < TC_COUNT) ? txq_classes[tclass].full_drop_count : 0;
+}
+
+uint32_t txq_get_superseded_drop_count(uint8_t tclass)
+{
+    return (tclass < TC_COUNT) ? txq_classes[tclass].superseded_drop_count : 0;
+}
+
+uint32_t txq_get_oversize_drop_count(void)
+{
+    return txq_oversize_drop_count;
+}
+
+uint8_t txq_get_peak(uint8_t tclass)
+{
+    return (tclass < TC_COUNT) ? txq_classes[tclass].peak : 0;
+}
+
+void txq_reset_peaks(void)
+{
+    uint8_t tc;
+
+    for (tc = 0; tc < TC_COUNT; tc++) {
+        txq_classes[tc].peak = 0;
+    }
+}
+
+const struct log_hist *txq_get_age_hist(uint8_t tclass)
+{
+    return &txq_classes[(tclass < TC_COUNT) ? tclass : TC_BULK].age_hist;
+}
+
+void txq_reset_stats(void)
+{
+    uint8_t tc;
+
+    txq_oversize_drop_count = 0;
+    for (tc = 0; tc < TC_COUNT; tc++) {
+        txq_classes[tc].stale_drop_count = 0;
+        txq_classes[tc].full_drop_count = 0;
+        txq_classes[tc].superseded_drop_count = 0;
+        hist_reset(&txq_classes[tc].age_hist);
+    }
+}
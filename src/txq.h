@@ -0,0 +1,110 @@
+/* ==================================================
+ * Uplink TX Queues with Deadlines
+ * One queue per traffic class, served in strict
+ * priority order. Holds complete UART frames until the
+ * radio is free, dropping any that exceed their deadline.
+ * ================================================== */
+
+#ifndef TXQ_H
+#define TXQ_H
+
+#include "c_types.h"
+#include "hist.h"
+
+/* ==================================================
+ * PUBLIC API
+ * ================================================== */
+
+/**
+ * Initialize queues (all slots free)
+ */
+void txq_init(void);
+
+/**
+ * Queue one complete UART frame
+ * If the class queue is full its oldest frame is evicted.
+ *
+ * @param tclass: TC_BULK or TC_PRIORITY
+ * @param link: Link ID from the UART frame (selects the BSSID)
+ * @param frame: Payload bytes (without length prefix)
+ * @param len: Payload length (1..MAX_BRIDGE_PACKET_SIZE, longer is dropped)
+ * @param timestamp: system_get_time() when the frame arrived
+ */
+void txq_push(uint8_t tclass, uint8_t link, const uint8_t *frame, uint16_t len, uint32_t timestamp);
+
+/**
+ * Move queued frames into the aggregator while the radio is free
+ * Priority frames always go first. Stale frames are dropped here,
+ * immediately before injection. When the airtime budget is spent,
+ * each class either waits or is dropped (AIRTIME_BUDGET_DROP_*).
+ */
+void txq_pump(void);
+
+/**
+ * Get number of frames waiting in a class queue
+ *
+ * @param tclass: Traffic class
+ * @return: Occupied slots
+ */
+uint8_t txq_count(uint8_t tclass);
+
+/**
+ * Get stale-drop count
+ *
+ * @param tclass: Traffic class
+ * @return: Frames dropped for exceeding the class deadline
+ */
+uint32_t txq_get_stale_drop_count(uint8_t tclass);
+
+/**
+ * Get overflow-drop count
+ *
+ * @param tclass: Traffic class
+ * @return: Frames evicted because the class queue was full
+ */
+uint32_t txq_get_full_drop_count(uint8_t tclass);
+
+/**
+ * Get superseded-drop count
+ *
+ * @param tclass: Traffic class
+ * @return: Older frames dropped when newest-first sent a newer one
+ *          for the same link
+ */
+uint32_t txq_get_superseded_drop_count(uint8_t tclass);
+
+/**
+ * Get oversize-drop count
+ *
+ * @return: Frames refused for exceeding MAX_BRIDGE_PACKET_SIZE
+ */
+uint32_t txq_get_oversize_drop_count(void);
+
+/**
+ * Get queue high-water mark
+ *
+ * @param tclass: Traffic class
+ * @return: Most slots occupied at once since init or the last reset
+ */
+uint8_t txq_get_peak(uint8_t tclass);
+
+/**
+ * Restart the queue high-water marks from zero
+ */
+void txq_reset_peaks(void);
+
+/**
+ * Get age-at-send histogram (microseconds from UART arrival
+ * to hand-off to the radio)
+ *
+ * @param tclass: Traffic class
+ * @return: Histogram (read-only)
+ */
+const struct log_hist *txq_get_age_hist(uint8_t tclass);
+
+/**
+ * Reset statistics counters
+ */
+void txq_reset_stats(void);
+
+#endif /* TXQ_H */
@@ -5,6 +5,9 @@
 
 #include "uart.h"
 #include "user_config.h"
+#include "latency.h"
+#include "trace.h"
+#include "rates.h"
 #include "osapi.h"
 #include "os_type.h"
 #include "user_interface.h"
@@ -32,9 +35,55 @@ static volatile uint8_t uart_tx_buffer[UART_TX_BUFFER_SIZE];
 static volatile uint16_t uart_tx_head = 0;  /* Write index (main) */
 static volatile uint16_t uart_tx_tail = 0;  /* Read index (ISR) */
 
+/* Priority-class TX ring (whole frames only, drained first) */
+static volatile uint8_t uart_txp_buffer[UART_TX_PRIO_BUFFER_SIZE];
+static volatile uint16_t uart_txp_head = 0; /* Write index (main) */
+static volatile uint16_t uart_txp_tail = 0; /* Read index (ISR) */
+
+/* TX ISR frame state: rings are only switched between frames */
+static uint16_t tx_frame_left = 0;          /* Bytes left in current frame */
+static uint8_t tx_from_prio = 0;            /* Current frame is from uart_txp_buffer */
+
+/* Frame completion timestamps (written by ISR, read by main code)
+ * Each entry holds the ring index just past the frame's last byte,
+ * so the parser can match it against its own read position. */
+static volatile uint16_t frame_ts_pos[UART_FRAME_TS_DEPTH];
+static volatile uint32_t frame_ts_time[UART_FRAME_TS_DEPTH];
+static volatile uint8_t frame_ts_head = 0;
+static volatile uint8_t frame_ts_tail = 0;
+
+/* ISR-side frame tracker (mirrors the main loop's length parser) */
+static uint8_t trk_len_hi = 0;
+static uint8_t trk_hdr_count = 0;
+static uint16_t trk_expected = 0;
+static uint16_t trk_received = 0;
+
+#if LATENCY_HIST_ENABLED
+static uint32_t trk_start_cycles = 0;       /* First byte of the frame */
+
+/* Enqueue time of framed writes, keyed like frame_ts by the ring
+ * index just past the frame, one queue per TX ring (0 = bulk) */
+struct uart_tx_stamp {
+    uint16_t end;
+    uint32_t cycles;
+};
+static struct uart_tx_stamp tx_stamp[2][UART_TX_STAMP_DEPTH];
+static volatile uint8_t tx_stamp_head[2] = { 0, 0 };
+static volatile uint8_t tx_stamp_tail[2] = { 0, 0 };
+
+#define TX_STAMP_MASK   (UART_TX_STAMP_DEPTH - 1)
+
+/* CPU cycles to shift one 10-bit character out */
+#define UART_CHAR_CYCLES    (CPU_CYCLES_PER_US * 10000000 / UART_BAUD_RATE)
+#endif
+
 /* Statistics */
 static volatile uint32_t uart_rx_overflow_count = 0;
 static volatile uint32_t uart_tx_overflow_count = 0;
+static volatile uint32_t uart_rx_resync_count = 0;
+
+/* Peak ring occupancy in bytes (enum uart_ring) */
+static volatile uint16_t uart_ring_peak[UART_RING_COUNT];
 
 /* ==================================================
  * RING BUFFER HELPER MACROS
@@ -43,10 +92,106 @@ static volatile uint32_t uart_tx_overflow_count = 0;
 /* Fast modulo using mask (requires power-of-2 size) */
 #define RX_BUFFER_MASK  (UART_RX_BUFFER_SIZE - 1)
 #define TX_BUFFER_MASK  (UART_TX_BUFFER_SIZE - 1)
+#define TXP_BUFFER_MASK (UART_TX_PRIO_BUFFER_SIZE - 1)
 
 /* Increment with wrap */
 #define RX_INCREMENT(idx)  (((idx) + 1) & RX_BUFFER_MASK)
 #define TX_INCREMENT(idx)  (((idx) + 1) & TX_BUFFER_MASK)
+#define TXP_INCREMENT(idx) (((idx) + 1) & TXP_BUFFER_MASK)
+
+/* Hardware TX FIFO depth */
+#define UART_TX_FIFO_SIZE  128
+
+#define FRAME_TS_MASK  (UART_FRAME_TS_DEPTH - 1)
+
+/* ==================================================
+ * RX FRAME TRACKER
+ * ================================================== */
+
+/**
+ * Follow length-prefixed framing on bytes stored in the RX ring
+ * Called from the RX ISR after each stored byte. Applies the same
+ * rules as the main loop parser (bad length drops the prefix), so
+ * both stay aligned on the same frame boundaries.
+ */
+static void uart_rx_track(uint8_t byte) ICACHE_RAM_ATTR;
+static void uart_rx_track(uint8_t byte)
+{
+    if (trk_expected == 0) {
+        if (trk_hdr_count == 0) {
+            trk_len_hi = byte;
+            trk_hdr_count = 1;
+            TRACE(TRACE_EV_UART_RX_START, byte, 0);
+#if LATENCY_HIST_ENABLED
+            trk_start_cycles = cycles_now();
+#endif
+            return;
+        }
+
+        trk_hdr_count = 0;
+        trk_expected = UART_FRAME_LEN(trk_len_hi, byte);
+        trk_received = 0;
+        if (trk_expected > MAX_PACKET_SIZE) {
+            uart_rx_resync_count++;
+            trk_expected = 0;
+        }
+        return;
+    }
+
+    if (++trk_received < trk_expected) {
+        return;
+    }
+
+    /* Frame complete - record where it ends and when */
+    uint8_t next = (frame_ts_head + 1) & FRAME_TS_MASK;
+    if (next != frame_ts_tail) {
+        frame_ts_pos[frame_ts_head] = uart_rx_head;
+        frame_ts_time[frame_ts_head] = system_get_time();
+        frame_ts_head = next;
+    }
+    LAT_CYCLES(LAT_UART_RX, cycles_now() - trk_start_cycles);
+    TRACE(TRACE_EV_UART_RX_END, trk_len_hi & UART_LEN_FLAG_BITS, trk_expected);
+    trk_expected = 0;
+}
+
+#if LATENCY_HIST_ENABLED
+/**
+ * A frame's last byte went into the TX FIFO: if it was a timed
+ * frame, sample enqueue -> last byte out, adding the time the
+ * bytes still ahead of it in the FIFO take to drain
+ *
+ * @param ring: 0 = bulk, 1 = priority
+ * @param tail: Ring index just past the frame
+ * @param fifo_bytes: Bytes in the FIFO, this frame's last included
+ */
+static void uart_tx_frame_done(uint8_t ring, uint16_t tail, uint8_t fifo_bytes) ICACHE_RAM_ATTR;
+static void uart_tx_frame_done(uint8_t ring, uint16_t tail, uint8_t fifo_bytes)
+{
+    uint8_t t = tx_stamp_tail[ring];
+
+    if (t != tx_stamp_head[ring] && tx_stamp[ring][t].end == tail) {
+        LAT_CYCLES(LAT_UART_TX, cycles_now() - tx_stamp[ring][t].cycles +
+                   (uint32_t)fifo_bytes * UART_CHAR_CYCLES);
+        tx_stamp_tail[ring] = (t + 1) & TX_STAMP_MASK;
+    }
+}
+
+/**
+ * Remember when a framed write entered a TX ring
+ * (called with UART interrupts disabled)
+ */
+static void uart_tx_stamp_put(uint8_t ring, uint16_t end)
+{
+    uint8_t h = tx_stamp_head[ring];
+    uint8_t next = (h + 1) & TX_STAMP_MASK;
+
+    if (next != tx_stamp_tail[ring]) {
+        tx_stamp[ring][h].end = end;
+        tx_stamp[ring][h].cycles = cycles_now();
+        tx_stamp_head[ring] = next;
+    }
+}
+#endif
 
 /* ==================================================
  * UART INTERRUPT HANDLERS
@@ -63,6 +208,9 @@ static void uart0_rx_intr_handler(void)
     uint8_t rx_fifo_len;
     uint8_t byte;
     uint16_t next_head;
+    uint16_t used;
+    uint16_t stored = 0;
+    uint16_t dropped = 0;
 
     /* Check interrupt status */
     uint32_t uart_intr_status = READ_PERI_REG(UART_INT_ST(UART0));
@@ -83,9 +231,12 @@ static void uart0_rx_intr_handler(void)
                 /* Space available - store byte */
                 uart_rx_buffer[uart_rx_head] = byte;
                 uart_rx_head = next_head;
+                uart_rx_track(byte);
+                stored++;
             } else {
                 /* Buffer full - drop byte and count overflow */
                 uart_rx_overflow_count++;
+                dropped++;
             }
 
             rx_fifo_len--;
@@ -106,8 +257,11 @@ static void uart0_rx_intr_handler(void)
             if (next_head != uart_rx_tail) {
                 uart_rx_buffer[uart_rx_head] = byte;
                 uart_rx_head = next_head;
+                uart_rx_track(byte);
+                stored++;
             } else {
                 uart_rx_overflow_count++;
+                dropped++;
             }
 
             rx_fifo_len--;
@@ -116,6 +270,85 @@ static void uart0_rx_intr_handler(void)
         /* Clear interrupt */
         WRITE_PERI_REG(UART_INT_CLR(UART0), UART_RXFIFO_TOUT_INT_CLR);
     }
+
+    /* High-water mark once per interrupt, not per byte */
+    used = (uart_rx_head - uart_rx_tail) & RX_BUFFER_MASK;
+    if (used > uart_ring_peak[UART_RING_RX]) {
+        uart_ring_peak[UART_RING_RX] = used;
+    }
+
+    RATE_ADD(RATE_UART_IN, stored);
+
+    /* One event per burst, not per byte */
+    if (dropped > 0) {
+        TRACE(TRACE_EV_UART_RX_OVERFLOW, 0, dropped);
+        RATE_ADD(RATE_DROPS_ISR, 1);
+    }
+}
+
+/**
+ * Move bytes from the TX rings into the hardware FIFO
+ * At each frame boundary the priority ring is checked first,
+ * so a queued priority frame overtakes bulk frames but never
+ * splits one. Called from the ISR and to kick off a write.
+ */
+static void uart_tx_fill_fifo(void) ICACHE_RAM_ATTR;
+static void uart_tx_fill_fifo(void)
+{
+    uint8_t fifo_used = (READ_PERI_REG(UART_STATUS(UART0)) >> UART_TXFIFO_CNT_S) & UART_TXFIFO_CNT;
+    uint8_t tx_fifo_space = (fifo_used < UART_TX_FIFO_SIZE) ? UART_TX_FIFO_SIZE - fifo_used : 0;
+    uint8_t fifo_free = tx_fifo_space;
+
+    while (tx_fifo_space > 0) {
+        if (tx_frame_left == 0) {
+            if (uart_txp_tail != uart_txp_head) {
+                /* Priority ring holds whole frames - read the length prefix */
+                tx_from_prio = 1;
+                tx_frame_left = 2 + UART_FRAME_LEN(uart_txp_buffer[uart_txp_tail],
+                                                   uart_txp_buffer[TXP_INCREMENT(uart_txp_tail)]);
+            } else if (uart_tx_tail != uart_tx_head) {
+                uint16_t avail = (uart_tx_head - uart_tx_tail) & TX_BUFFER_MASK;
+
+                tx_from_prio = 0;
+                tx_frame_left = (avail >= 2)
+                    ? 2 + UART_FRAME_LEN(uart_tx_buffer[uart_tx_tail],
+                                         uart_tx_buffer[TX_INCREMENT(uart_tx_tail)])
+                    : avail;
+
+                /* Raw (unframed) writes: never run past the data */
+                if (tx_frame_left > avail) {
+                    tx_frame_left = avail;
+                }
+            } else {
+                break;
+            }
+        }
+
+        if (tx_from_prio) {
+            WRITE_PERI_REG(UART_FIFO(UART0), uart_txp_buffer[uart_txp_tail]);
+            uart_txp_tail = TXP_INCREMENT(uart_txp_tail);
+        } else {
+            WRITE_PERI_REG(UART_FIFO(UART0), uart_tx_buffer[uart_tx_tail]);
+            uart_tx_tail = TX_INCREMENT(uart_tx_tail);
+        }
+
+        tx_frame_left--;
+        tx_fifo_space--;
+
+#if LATENCY_HIST_ENABLED
+        if (tx_frame_left == 0) {
+            uart_tx_frame_done(tx_from_prio, tx_from_prio ? uart_txp_tail : uart_tx_tail,
+                               UART_TX_FIFO_SIZE - tx_fifo_space);
+        }
+#endif
+    }
+
+    RATE_ADD(RATE_UART_OUT, fifo_free - tx_fifo_space);
+
+    /* If both rings are empty, disable TX interrupt */
+    if (uart_tx_tail == uart_tx_head && uart_txp_tail == uart_txp_head) {
+        CLEAR_PERI_REG_MASK(UART_INT_ENA(UART0), UART_TXFIFO_EMPTY_INT_ENA);
+    }
 }
 
 /**
@@ -129,25 +362,51 @@ static void uart0_tx_intr_handler(void)
 
     if (uart_intr_status & UART_TXFIFO_EMPTY_INT_ST) {
         /* TX FIFO empty - send more data if available */
-        uint8_t tx_fifo_space = 128; /* Max FIFO depth */
-
-        while (tx_fifo_space > 0 && uart_tx_tail != uart_tx_head) {
-            /* Data available in ring buffer - write to FIFO */
-            WRITE_PERI_REG(UART_FIFO(UART0), uart_tx_buffer[uart_tx_tail]);
-            uart_tx_tail = TX_INCREMENT(uart_tx_tail);
-            tx_fifo_space--;
-        }
-
-        /* If ring buffer empty, disable TX interrupt */
-        if (uart_tx_tail == uart_tx_head) {
-            CLEAR_PERI_REG_MASK(UART_INT_ENA(UART0), UART_TXFIFO_EMPTY_INT_ENA);
-        }
+        uart_tx_fill_fifo();
 
         /* Clear interrupt */
         WRITE_PERI_REG(UART_INT_CLR(UART0), UART_TXFIFO_EMPTY_INT_CLR);
     }
 }
 
+/**
+ * UART0 interrupt entry point
+ * One handler is attached per UART, so dispatch RX and TX here
+ */
+static void uart0_intr_handler(void *arg) ICACHE_RAM_ATTR;
+static void uart0_intr_handler(void *arg)
+{
+    uart0_rx_intr_handler();
+    uart0_tx_intr_handler();
+}
+
+/**
+ * Copy bytes into a TX ring (caller has checked space)
+ */
+static void uart_ring_put(volatile uint8_t *ring, volatile uint16_t *head, uint16_t mask,
+                          const uint8_t *data, uint16_t len)
+{
+    uint16_t h = *head;
+    uint16_t i;
+
+    for (i = 0; i < len; i++) {
+        ring[h] = data[i];
+        h = (h + 1) & mask;
+    }
+
+    *head = h;
+}
+
+/**
+ * Raise a ring's high-water mark (called with UART interrupts off)
+ */
+static void uart_note_peak(uint8_t ring, uint16_t used)
+{
+    if (used > uart_ring_peak[ring]) {
+        uart_ring_peak[ring] = used;
+    }
+}
+
 /* ==================================================
  * PUBLIC API IMPLEMENTATION
  * ================================================== */
@@ -187,7 +446,7 @@ void uart_init(uint32_t baud_rate)
     );
 
     /* Register interrupt handler */
-    ETS_UART_INTR_ATTACH((void *)uart0_rx_intr_handler, NULL);
+    ETS_UART_INTR_ATTACH((void *)uart0_intr_handler, NULL);
 
     /* Enable UART interrupts */
     ETS_UART_INTR_ENABLE();
@@ -197,6 +456,13 @@ void uart_init(uint32_t baud_rate)
     uart_rx_tail = 0;
     uart_tx_head = 0;
     uart_tx_tail = 0;
+    uart_txp_head = 0;
+    uart_txp_tail = 0;
+    tx_frame_left = 0;
+    frame_ts_head = 0;
+    frame_ts_tail = 0;
+    trk_hdr_count = 0;
+    trk_expected = 0;
 
     /* Reset statistics */
     uart_rx_overflow_count = 0;
@@ -258,6 +524,7 @@ uint16_t uart_write_bytes(const uint8_t *data, uint16_t len)
         if (next_head == uart_tx_tail) {
             /* Buffer full */
             uart_tx_overflow_count++;
+            RATE_ADD(RATE_DROPS, 1);
             break;
         }
 
@@ -265,12 +532,14 @@ uint16_t uart_write_bytes(const uint8_t *data, uint16_t len)
         uart_tx_head = next_head;
     }
 
+    uart_note_peak(UART_RING_TX, (uart_tx_head - uart_tx_tail) & TX_BUFFER_MASK);
+
     /* Enable TX FIFO empty interrupt to start transmission */
     if (uart_tx_tail != uart_tx_head) {
         SET_PERI_REG_MASK(UART_INT_ENA(UART0), UART_TXFIFO_EMPTY_INT_ENA);
 
-        /* Trigger TX interrupt handler manually to start sending */
-        uart0_tx_intr_handler();
+        /* Fill the FIFO now to start sending */
+        uart_tx_fill_fifo();
     }
 
     ETS_UART_INTR_ENABLE();
@@ -278,6 +547,91 @@ uint16_t uart_write_bytes(const uint8_t *data, uint16_t len)
     return count;
 }
 
+bool uart_rx_frame_time(uint32_t *timestamp)
+{
+    uint16_t tail = uart_rx_tail;
+    uint16_t avail = uart_rx_available();
+
+    while (frame_ts_tail != frame_ts_head) {
+        uint16_t ahead = (frame_ts_pos[frame_ts_tail] - tail) & RX_BUFFER_MASK;
+
+        if (ahead == 0) {
+            /* Frame ends exactly at the read position */
+            *timestamp = frame_ts_time[frame_ts_tail];
+            frame_ts_tail = (frame_ts_tail + 1) & FRAME_TS_MASK;
+            return true;
+        }
+
+        if (ahead <= avail) {
+            /* Entry belongs to a frame not yet read */
+            break;
+        }
+
+        /* Entry for a frame the parser never saw (resync) - discard */
+        frame_ts_tail = (frame_ts_tail + 1) & FRAME_TS_MASK;
+    }
+
+    return false;
+}
+
+bool uart_write_frame(uint8_t flags, const uint8_t *payload, uint16_t len)
+{
+    return uart_write_frame_trailer(flags, payload, len, NULL, 0);
+}
+
+bool uart_write_frame_trailer(uint8_t flags, const uint8_t *payload, uint16_t len,
+                              const uint8_t *trailer, uint16_t trailer_len)
+{
+    uint8_t prefix[2];
+    uint16_t free_space;
+    uint16_t total = len + trailer_len;
+    bool prio = (flags & UART_LEN_CLASS_BIT) != 0;
+
+    /* Length covers payload and trailer */
+    prefix[0] = ((total >> 8) & 0xFF) | (flags & UART_LEN_FLAG_BITS);
+    prefix[1] = total & 0xFF;
+
+    ETS_UART_INTR_DISABLE();
+
+    /* All or nothing - a partial frame would desync the reader */
+    if (prio) {
+        free_space = TXP_BUFFER_MASK - ((uart_txp_head - uart_txp_tail) & TXP_BUFFER_MASK);
+    } else {
+        free_space = TX_BUFFER_MASK - ((uart_tx_head - uart_tx_tail) & TX_BUFFER_MASK);
+    }
+
+    if (free_space < (uint16_t)(total + 2)) {
+        uart_tx_overflow_count++;
+        RATE_ADD(RATE_DROPS, 1);
+        TRACE(TRACE_EV_UART_TX_OVERFLOW, prio ? 1 : 0, total);
+        ETS_UART_INTR_ENABLE();
+        return false;
+    }
+
+    if (prio) {
+        uart_ring_put(uart_txp_buffer, &uart_txp_head, TXP_BUFFER_MASK, prefix, 2);
+        uart_ring_put(uart_txp_buffer, &uart_txp_head, TXP_BUFFER_MASK, payload, len);
+        uart_ring_put(uart_txp_buffer, &uart_txp_head, TXP_BUFFER_MASK, trailer, trailer_len);
+        uart_note_peak(UART_RING_TX_PRIO, (uart_txp_head - uart_txp_tail) & TXP_BUFFER_MASK);
+    } else {
+        uart_ring_put(uart_tx_buffer, &uart_tx_head, TX_BUFFER_MASK, prefix, 2);
+        uart_ring_put(uart_tx_buffer, &uart_tx_head, TX_BUFFER_MASK, payload, len);
+        uart_ring_put(uart_tx_buffer, &uart_tx_head, TX_BUFFER_MASK, trailer, trailer_len);
+        uart_note_peak(UART_RING_TX, (uart_tx_head - uart_tx_tail) & TX_BUFFER_MASK);
+    }
+
+#if LATENCY_HIST_ENABLED
+    uart_tx_stamp_put(prio ? 1 : 0, prio ? uart_txp_head : uart_tx_head);
+#endif
+
+    SET_PERI_REG_MASK(UART_INT_ENA(UART0), UART_TXFIFO_EMPTY_INT_ENA);
+    uart_tx_fill_fifo();
+
+    ETS_UART_INTR_ENABLE();
+
+    return true;
+}
+
 bool uart_write_byte(uint8_t byte)
 {
     return uart_write_bytes(&byte, 1) == 1;
@@ -293,8 +647,28 @@ uint32_t uart_get_tx_overflow_count(void)
     return uart_tx_overflow_count;
 }
 
+uint32_t uart_get_rx_resync_count(void)
+{
+    return uart_rx_resync_count;
+}
+
+uint16_t uart_get_ring_peak(uint8_t ring)
+{
+    return (ring < UART_RING_COUNT) ? uart_ring_peak[ring] : 0;
+}
+
+void uart_reset_ring_peaks(void)
+{
+    uint8_t ring;
+
+    for (ring = 0; ring < UART_RING_COUNT; ring++) {
+        uart_ring_peak[ring] = 0;
+    }
+}
+
 void uart_reset_stats(void)
 {
     uart_rx_overflow_count = 0;
     uart_tx_overflow_count = 0;
+    uart_rx_resync_count = 0;
 }
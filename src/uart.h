@@ -46,6 +46,16 @@ uint16_t uart_read_bytes(uint8_t *buffer, uint16_t max_len);
  */
 bool uart_read_byte(uint8_t *byte);
 
+/**
+ * Get the arrival time of the frame just read
+ * Call after reading the last byte of a length-prefixed frame.
+ * The RX ISR timestamps each frame when its last byte arrives.
+ *
+ * @param timestamp: Receives system_get_time() at frame completion
+ * @return: true if found, false if not tracked (timestamp untouched)
+ */
+bool uart_rx_frame_time(uint32_t *timestamp);
+
 /**
  * Write bytes to TX buffer (non-blocking)
  * Queues data for transmission via interrupt
@@ -56,6 +66,33 @@ bool uart_read_byte(uint8_t *byte);
  */
 uint16_t uart_write_bytes(const uint8_t *data, uint16_t len);
 
+/**
+ * Write one length-prefixed frame to the TX path (all or nothing)
+ * Adds the [LEN_HI][LEN_LO] prefix with the given flag bits.
+ * Priority frames use their own ring and are sent ahead of queued
+ * bulk frames, switching only at frame boundaries.
+ *
+ * @param flags: LEN_HI flag bits (UART_LEN_CLASS_BIT, UART_LEN_LOCAL_BIT)
+ * @param payload: Frame payload
+ * @param len: Payload length
+ * @return: true if queued, false if not enough space (frame dropped)
+ */
+bool uart_write_frame(uint8_t flags, const uint8_t *payload, uint16_t len);
+
+/**
+ * Write one length-prefixed frame with bytes appended after the
+ * payload (all or nothing). The length prefix covers both.
+ *
+ * @param flags: LEN_HI flag bits
+ * @param payload: Frame payload
+ * @param len: Payload length
+ * @param trailer: Bytes to append (may be NULL if trailer_len is 0)
+ * @param trailer_len: Trailer length
+ * @return: true if queued, false if not enough space (frame dropped)
+ */
+bool uart_write_frame_trailer(uint8_t flags, const uint8_t *payload, uint16_t len,
+                              const uint8_t *trailer, uint16_t trailer_len);
+
 /**
  * Write single byte to TX buffer
  *
@@ -80,6 +117,38 @@ uint32_t uart_get_rx_overflow_count(void);
  */
 uint32_t uart_get_tx_overflow_count(void);
 
+/**
+ * Get RX stream desync count (diagnostic)
+ * Increments when a length prefix is out of range and dropped,
+ * i.e. the framing was lost and the parser hunts for the next frame
+ *
+ * @return: Number of resync events since init
+ */
+uint32_t uart_get_rx_resync_count(void);
+
+/* Ring buffers, for uart_get_ring_peak() */
+enum uart_ring {
+    UART_RING_RX,       /* RX ring (UART_RX_BUFFER_SIZE) */
+    UART_RING_TX,       /* Bulk TX ring (UART_TX_BUFFER_SIZE) */
+    UART_RING_TX_PRIO,  /* Priority TX ring (UART_TX_PRIO_BUFFER_SIZE) */
+    UART_RING_COUNT
+};
+
+/**
+ * Get a ring's high-water mark (diagnostic)
+ * The most bytes it has held since init or the last reset;
+ * a ring holds at most its size - 1
+ *
+ * @param ring: enum uart_ring
+ * @return: Peak occupancy in bytes
+ */
+uint16_t uart_get_ring_peak(uint8_t ring);
+
+/**
+ * Restart the ring high-water marks from zero
+ */
+void uart_reset_ring_peaks(void);
+
 /**
  * Reset statistics counters
  */
@@ -24,12 +24,45 @@
 #define UART_BAUD_RATE          460800      /* Required for encryption overhead */
 #define UART_RX_BUFFER_SIZE     1024        /* Power of 2 for fast masking */
 #define UART_TX_BUFFER_SIZE     1024        /* Power of 2 for fast masking */
+#define UART_TX_PRIO_BUFFER_SIZE 512        /* Priority-class TX ring (power of 2) */
+#define UART_FRAME_TS_DEPTH     32          /* Frame completion timestamps (power of 2) */
 
 /* ==================================================
  * PACKET CONFIGURATION
  * ================================================== */
 #define MAX_PACKET_SIZE         256         /* Maximum payload size (bytes) */
 
+/* ==================================================
+ * TRAFFIC CLASSES
+ * ================================================== */
+
+/* LEN_HI layout: [7]=class [6]=local [5:1]=link ID [0]=length bit 8
+ * Length is at most 256, so the top bits are free for flags.
+ * Priority frames (RC control) are served strictly before bulk
+ * frames (telemetry, logs) in both directions.
+ * Local frames are addressed to the ESP itself (commands, status,
+ * peer feedback) and are never forwarded.
+ * The link ID selects the BSSID a frame is sent on, and tags each
+ * received frame with the link it arrived on (0 on a single link).
+ */
+#define TC_BULK                 0           /* Default class (bit clear) */
+#define TC_PRIORITY             1           /* Strict priority (bit set) */
+#define TC_COUNT                2
+
+#define UART_LEN_CLASS_BIT      0x80
+#define UART_LEN_LOCAL_BIT      0x40
+#define UART_LEN_LINK_MASK      0x3E
+#define UART_LEN_LINK_SHIFT     1
+#define UART_LEN_FLAG_BITS      (UART_LEN_CLASS_BIT | UART_LEN_LOCAL_BIT | UART_LEN_LINK_MASK)
+
+/* Payload length from the 2-byte UART/record prefix */
+#define UART_FRAME_LEN(hi, lo)  ((uint16_t)((((hi) & ~UART_LEN_FLAG_BITS) << 8) | (lo)))
+#define UART_FRAME_CLASS(hi)    (((hi) & UART_LEN_CLASS_BIT) ? TC_PRIORITY : TC_BULK)
+#define UART_FRAME_IS_LOCAL(hi) (((hi) & UART_LEN_LOCAL_BIT) != 0)
+#define UART_CLASS_FLAGS(tc)    (((tc) == TC_PRIORITY) ? UART_LEN_CLASS_BIT : 0)
+#define UART_FRAME_LINK(hi)     (((hi) & UART_LEN_LINK_MASK) >> UART_LEN_LINK_SHIFT)
+#define UART_LINK_FLAGS(link)   (((link) << UART_LEN_LINK_SHIFT) & UART_LEN_LINK_MASK)
+
 /* Frame size calculation:
  * - RP2040 app frame: [0xAA][SEQ][LEN][payload][CRC8]
  * - After encryption: +28 bytes (12B nonce + 16B MAC)
@@ -42,14 +75,262 @@
  * WIFI CONFIGURATION
  * ================================================== */
 #define WIFI_DEFAULT_CHANNEL    11           /* 2.4GHz channel 1-14 */
+
+/* Boot channel survey: dwell on channels SURVEY_FIRST..SURVEY_LAST in
+ * promiscuous mode, measuring frames, airtime and RSSI, then settle on
+ * the least busy channel from CHANNEL_SURVEY_ALLOWED (bit n = channel n).
+ * Both ends must agree, so only the LEADER (typically the ground
+ * station) chooses. A follower surveys too (for the report), then
+ * hunts the allowed channels until it hears its link, and hunts again
+ * if the link goes silent. Results are sent to the flight controller
+ * as a GET_SURVEY response.
+ */
+#define CHANNEL_SURVEY_ENABLED  0
+#define CHANNEL_SURVEY_LEADER   1           /* 1=choose channel, 0=follow */
+#define CHANNEL_SURVEY_FIRST    1
+#define CHANNEL_SURVEY_LAST     13
+#define CHANNEL_SURVEY_ALLOWED  ((1 << 1) | (1 << 6) | (1 << 11))
+#define CHANNEL_SURVEY_DWELL_MS 200         /* Per channel */
+#define CHANNEL_SURVEY_BUCKET_PERMILLE 50   /* Busy levels this close are a tie */
+#define CHANNEL_HUNT_DWELL_MS   500         /* Follower: listen per channel */
+#define CHANNEL_HUNT_LOST_MS    3000        /* Follower: silence before re-hunting */
+
+/* Frequency hopping (FHSS): both ends hop over FHSS_CHANNELS in a
+ * pseudo-random order derived from CUSTOM_BSSID, one hop every
+ * FHSS_DWELL_US. The leader owns the timebase; every frame carries
+ * its hop index and phase so the follower can lock on. Must match
+ * on both ends (except FHSS_LEADER). Replaces the channel survey.
+ */
+#define FHSS_ENABLED            0
+#define FHSS_LEADER             1           /* 1=own the timebase, 0=sync to the peer */
+#define FHSS_CHANNELS           0x3FFE      /* Bit n = channel n (default 1-13) */
+#define FHSS_MIN_SPACING        3           /* Preferred distance between consecutive hops */
+#define FHSS_DWELL_US           40000       /* Time on each channel */
+#define FHSS_GUARD_US           3000        /* No TX this close to a hop (> longest frame) */
+#define FHSS_SYNC_GAIN_SHIFT    2           /* Follower: correct 1/4 of the phase error per hop */
+#define FHSS_COAST_HOPS         50          /* Follower: hops without frames before reacquiring */
+
+/* TDMA: the air time is cut into frames of one leader slot (uplink,
+ * ground station) and one follower slot (downlink, aircraft). Each
+ * end transmits only in its own slot. The leader owns the timebase;
+ * every frame carries its phase so the follower can lock on. Must
+ * match on both ends (except TDMA_LEADER). Point-to-point links only.
+ */
+#define TDMA_ENABLED            0
+#define TDMA_LEADER             1           /* 1=ground station (owns timebase) */
+#define TDMA_FRAME_US           20000       /* Uplink + downlink slot */
+#define TDMA_UPLINK_PERMILLE    500         /* Leader share of each frame */
+#define TDMA_GUARD_US           2600        /* No TX start this close to slot end (> longest frame) */
+#define TDMA_SYNC_GAIN_SHIFT    2           /* Follower: correct 1/4 of the phase error per frame */
+#define TDMA_LOST_US            500000      /* Follower: silence before sending unslotted */
+
+/* TX rate identifiers (L = long preamble, S = short preamble) */
+#define PHY_RATE_1M_L           0
+#define PHY_RATE_2M_L           1
+#define PHY_RATE_5M_S           2
+#define PHY_RATE_11M_S          3
+
 #define WIFI_TX_RATE            PHY_RATE_1M_L  /* 1 Mbps for max range */
 
-/* Custom BSSID for RX filtering (avoids payload inspection) */
+/* Custom BSSID for RX filtering (avoids payload inspection)
+ * This is link 0; a ground station adds one link per aircraft at
+ * runtime (SET_LINK command). */
 #define CUSTOM_BSSID            {0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0x00}
 
+/* Link table: accepted BSSIDs, looked up by hash in the RX callback */
+#define LINK_ID_COUNT           32          /* IDs 0..31 (5-bit UART tag) */
+#define LINK_MAX_COUNT          16          /* Links active at once */
+#define RX_LINK_SLOTS           32          /* Hash slots (power of 2, >= 2x links) */
+
+/* Hardware pre-filter: ask the SDK MAC filter (wifi_promiscuous_set_mac)
+ * to drop foreign frames before the RX callback runs. The software
+ * BSSID check always stays in place. If the link goes quiet with the
+ * filter on, it is briefly lifted; if link frames then show up, the
+ * hardware filter was hiding them and software-only filtering is kept.
+ */
+#define RX_HW_FILTER_ENABLED    1
+#define RX_HW_FILTER_QUIET_MS   1000        /* No link frames this long: probe */
+#define RX_HW_FILTER_PROBE_MS   100         /* Software-only probe window */
+
+/* RX callback profiler: CCOUNT cycles per call, split by filter
+ * outcome, published as a snapshot every RX_PROFILE_PERIOD_MS */
+#define RX_PROFILE_PERIOD_MS    1000
+
+/* Pipeline latency histograms (log-scale, 0.1 us resolution) per stage:
+ * UART RX, TX queue, aggregation hold, radio TX, RX callback, UART TX.
+ * 0 removes every sample point from the build. */
+#define LATENCY_HIST_ENABLED    1
+#define UART_TX_STAMP_DEPTH     16          /* Framed UART writes timed at once, per ring (power of 2) */
+
+/* Event trace: ring of timestamped events (UART frames, TX/RX outcomes,
+ * overflows, channel changes) read back with GET_TRACE and decoded by
+ * tools/trace_decode.py. 8 bytes of RAM per entry. RX rejects are only
+ * traced once a frame has matched a link BSSID, so ambient traffic does
+ * not flush the ring. 0 removes every trace point from the build. */
+#define TRACE_ENABLED           1
+#define TRACE_DEPTH             256         /* Events kept (power of 2) */
+
+/* Duplicate suppression: drop frames whose 12-bit sequence number was
+ * already seen from the same sender (addr2) and link within the last
+ * RX_DEDUP_WINDOW sequence numbers - retransmissions, reflections and
+ * re-injected copies. A sender that jumps back further than the window
+ * or goes quiet for RX_DEDUP_RESYNC_MS is assumed to have restarted.
+ */
+#define RX_DEDUP_ENABLED        1
+#define RX_DEDUP_SENDERS        8           /* Sender/link pairs tracked (least recent evicted) */
+#define RX_DEDUP_WINDOW         32          /* Sequence numbers remembered (bitmap) */
+#define RX_DEDUP_RESYNC_MS      1000        /* Quiet sender state expires */
+
+/* RX metadata trailer: append RX_META_SIZE bytes to every frame
+ * forwarded to the flight controller, counted in its length field:
+ *   [rssi int8][rate][channel][seq u16][arrival_us u32] (little-endian)
+ * Off by default - the flight controller must expect it. Can also be
+ * switched at runtime (SET_RX_META).
+ */
+#define RX_META_TRAILER         0
+#define RX_META_SIZE            9
+
 /* Broadcast MAC for TX (Addr1 in 802.11 header) */
 #define BROADCAST_MAC           {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF}
 
+/* ==================================================
+ * AGGREGATION CONFIGURATION
+ * ================================================== */
+
+/* Pack several small UART frames into one 802.11 frame so they share
+ * one preamble, header and FCS. On-air payload is a sequence of
+ * [LEN_HI][LEN_LO][payload] records - same format as the UART side.
+ * Must match on both ends of the link.
+ */
+#define AGG_ENABLED             1           /* 0=one UART frame per 802.11 frame */
+#define AGG_MAX_PAYLOAD         MAX_AIR_PAYLOAD_SIZE /* Pack limit (at most the RX capture) */
+#define AGG_HOLD_TIME_US        0           /* Max wait for more frames (0=flush each tick) */
+#define AGG_RECORD_HEADER_SIZE  2           /* Length prefix per record */
+
+/* ==================================================
+ * TX DEADLINE CONFIGURATION
+ * ================================================== */
+
+/* Uplink frames are timestamped when their last byte reaches the UART
+ * RX ring. Frames older than their class's max age when they would be
+ * handed to the radio are dropped - a stale RC update is worse than none.
+ * Each class has its own queue; priority is always served first.
+ */
+#define TXQ_PRIO_DEPTH          4           /* Pending priority frames */
+#define TXQ_PRIO_MAX_AGE_US     30000       /* Deadline (0=never drop) */
+#define TXQ_PRIO_NEWEST_FIRST   1           /* 1=send newest, drop older for its link; 0=FIFO */
+
+#define TXQ_BULK_DEPTH          8           /* Pending bulk frames */
+#define TXQ_BULK_MAX_AGE_US     500000      /* Deadline (0=never drop) */
+#define TXQ_BULK_NEWEST_FIRST   0           /* Telemetry keeps its order */
+
+/* ==================================================
+ * AIRTIME BUDGET CONFIGURATION
+ * ================================================== */
+
+/* Token bucket in microseconds of airtime: refills at a share of real
+ * time, every injected frame is charged its on-air duration. Keeps a
+ * misbehaving flight controller from hogging a shared channel.
+ * When over budget, each class either waits in its queue or is dropped.
+ */
+#define AIRTIME_BUDGET_ENABLED  1
+#define AIRTIME_BUDGET_PERMILLE 250         /* Channel share (250 = 25%) */
+#define AIRTIME_BUDGET_BURST_US 20000       /* Bucket depth */
+#define AIRTIME_BUDGET_DROP_PRIO 0          /* Priority: 0=wait for tokens */
+#define AIRTIME_BUDGET_DROP_BULK 1          /* Bulk: 1=drop when over budget */
+
+/* Uplink frames per second the flight controller sends at up to
+ * MAX_BRIDGE_PACKET_SIZE. The build prints a "capacity" note when they
+ * do not fit the channel or the budget at WIFI_TX_RATE (0 = no check) */
+#define LINK_PACKET_RATE_HZ     50
+
+/* ==================================================
+ * TX POWER CONFIGURATION
+ * ================================================== */
+
+/* Units are 0.25 dBm (system_phy_set_max_tpw range 0-82 = 0-20.5 dBm).
+ * The optional closed loop uses the RSSI the peer reports for our
+ * frames: step down slowly while the margin above TXPOWER_RSSI_FLOOR
+ * is high, step up fast when it drops, jump to max if reports stop.
+ * With several links the weakest peer's report drives the loop.
+ * Peer reports ride in aggregated frames (needs AGG_ENABLED).
+ */
+#define TXPOWER_DEFAULT_QDBM    82          /* Boot power (max) */
+#define TXPOWER_MIN_QDBM        20          /* Loop never goes below 5 dBm */
+#define TXPOWER_MAX_QDBM        82
+#define TXPOWER_AUTO_ENABLED    0           /* 1=closed loop at boot */
+#define TXPOWER_RSSI_FLOOR      -85         /* dBm needed for a clean link */
+#define TXPOWER_MARGIN_HIGH_DB  20          /* Above: step down */
+#define TXPOWER_MARGIN_LOW_DB   10          /* Below: step up */
+#define TXPOWER_STEP_DOWN_QDBM  2           /* 0.5 dB per report */
+#define TXPOWER_STEP_UP_QDBM    12          /* 3 dB per report */
+#define TXPOWER_REPORT_MS       100         /* RSSI report interval to peer */
+#define TXPOWER_REPORT_TIMEOUT_MS 500       /* No reports: back to max */
+
+/* ==================================================
+ * LINK QUALITY CONFIGURATION
+ * ================================================== */
+
+/* Per-link estimator fed by every accepted frame: loss from sequence
+ * gaps over LINKQ_WINDOW_MS windows, RSSI EWMA, inter-arrival jitter
+ * and time since the last frame. A 0-100 score can be pushed to the
+ * flight controller every LINKQ_REPORT_MS (or SET_LINKQ_REPORT) as a
+ * local frame, so failsafe logic does not have to wait for the 5 s
+ * heartbeat. Off by default: a flight controller that does not know
+ * the local bit would read the pushes as bad lengths.
+ */
+#define LINKQ_WINDOW_MS         100         /* Loss measurement window */
+#define LINKQ_REPORT_MS         0           /* Push interval (0 = on request only) */
+#define LINKQ_TIMEOUT_MS        200         /* No frames this long: score 0 */
+#define LINKQ_RSSI_FLOOR        -90         /* dBm scoring 0 */
+#define LINKQ_RSSI_GOOD         -60         /* dBm scoring 100 */
+#define LINKQ_MAX_GAP           512         /* Larger sequence jumps are a restart */
+
+/* ==================================================
+ * LINK TEST CONFIGURATION
+ * ================================================== */
+
+/* Over-the-air ping: the responder sends every accepted frame straight
+ * back on its link (enable on one end only). START_PING makes the other
+ * end send probes as local records (needs AGG_ENABLED) and time each
+ * echo with CCOUNT. A probe with no echo after PING_TIMEOUT_MS is lost.
+ */
+#define PING_ECHO_ENABLED       0           /* Boot state of the echo responder */
+#define PING_INTERVAL_MS        20          /* Default probe interval */
+#define PING_PROBE_SIZE         32          /* Probe record length (bytes, >= 3) */
+#define PING_TIMEOUT_MS         500         /* Echo deadline */
+
+/* Traffic generator: START_TRAFGEN sends sequence-numbered, timestamped
+ * local records (needs AGG_ENABLED) at a set size, rate and pattern,
+ * straight to the radio. The receiving end measures loss, throughput
+ * and jitter and pushes a GET_TRAFRX report every TRAFGEN_REPORT_MS.
+ */
+#define TRAFGEN_REPORT_MS       1000        /* Receiver push interval (0 = on request only) */
+
+/* ==================================================
+ * SNIFFER CONFIGURATION
+ * ================================================== */
+
+/* Sniffer mode (SET_SNIFFER) streams every frame heard on the channel
+ * to the UART as SNIFF_BATCH local frames for tools/sniff_pcap.py.
+ * Frames are paid for from SNIFFER_UART_PERCENT of the line rate; past
+ * that they are cut to the MAC header, then skipped, and counted.
+ */
+#define SNIFFER_BATCH_SIZE      480         /* Batch frame size (128..511 bytes) */
+#define SNIFFER_BATCH_MS        20          /* Send a partial batch after this long */
+#define SNIFFER_UART_PERCENT    75          /* UART line rate the stream may use */
+
+/* ==================================================
+ * MEMORY DIAGNOSTICS CONFIGURATION
+ * ================================================== */
+
+/* Stack painting: at boot the stack below user_init's frame is filled
+ * with a pattern; the deepest word overwritten since is found by a scan
+ * (heartbeat, GET_MEMORY). Painting stops at the end of dram0, where
+ * the Non-OS SDK stack ends.
+ */
+#define STACK_PAINT_BYTES       2048        /* Region size (0 = no stack check) */
+
 /* ==================================================
  * TIMING CONFIGURATION
  * ================================================== */
@@ -83,6 +364,7 @@
 /* Frame Control field values */
 #define IEEE80211_FCTL_FTYPE    0x000C      /* Frame type mask */
 #define IEEE80211_FCTL_MGMT     0x0000      /* Management frame type */
+#define IEEE80211_FCTL_STYPE    0x00F0      /* Frame subtype mask */
 
 /* We use Probe Request management frames (type=0, subtype=4) instead of
  * data frames because ESP8266 promiscuous mode only captures full
@@ -99,8 +381,39 @@
  * MEMORY LAYOUT
  * ================================================== */
 
+/* Timebase sync fields between the 802.11 header and the payload:
+ * FHSS [hop index][phase_us u16], then TDMA [phase_us u16] */
+#if FHSS_ENABLED
+#define FHSS_SYNC_SIZE          3
+#else
+#define FHSS_SYNC_SIZE          0
+#endif
+
+#if TDMA_ENABLED
+#define TDMA_SYNC_SIZE          2
+#else
+#define TDMA_SYNC_SIZE          0
+#endif
+
+#define AIR_SYNC_SIZE           (FHSS_SYNC_SIZE + TDMA_SYNC_SIZE)
+
+/* Management frame bytes the SDK hands the promiscuous callback:
+ * sniffer_buf2.buf[112], followed by its cnt/len fields. Nothing past
+ * them ever reaches the receiver. */
+#define RX_MGMT_CAPTURE_SIZE    112
+
+/* Largest 802.11 payload the receiver sees whole (after the sync fields) */
+#define MAX_AIR_PAYLOAD_SIZE    (RX_MGMT_CAPTURE_SIZE - IEEE80211_HEADER_SIZE - AIR_SYNC_SIZE)
+
+/* Largest UART frame bridged over the air (one record, or one frame) */
+#if AGG_ENABLED
+#define MAX_BRIDGE_PACKET_SIZE  (MAX_AIR_PAYLOAD_SIZE - AGG_RECORD_HEADER_SIZE)
+#else
+#define MAX_BRIDGE_PACKET_SIZE  MAX_AIR_PAYLOAD_SIZE
+#endif
+
 /* Static buffer allocations (avoid heap fragmentation) */
-#define TX_FRAME_BUFFER_SIZE    (IEEE80211_HEADER_SIZE + MAX_PACKET_SIZE)
+#define TX_FRAME_BUFFER_SIZE    (IEEE80211_HEADER_SIZE + AIR_SYNC_SIZE + MAX_AIR_PAYLOAD_SIZE)
 
 /* ==================================================
  * HARDWARE CONFIGURATION
@@ -6,6 +6,21 @@
 #include "wifi_raw.h"
 #include "user_config.h"
 #include "uart.h"
+#include "aggregate.h"
+#include "airtime.h"
+#include "cycles.h"
+#include "rx_filter.h"
+#include "links.h"
+#include "dedup.h"
+#include "linkq.h"
+#include "survey.h"
+#include "fhss.h"
+#include "tdma.h"
+#include "latency.h"
+#include "trace.h"
+#include "rates.h"
+#include "ping.h"
+#include "sniffer.h"
 #include "osapi.h"
 #include "user_interface.h"
 #include "mem.h"
@@ -19,19 +34,65 @@ static uint8_t tx_frame_buffer[TX_FRAME_BUFFER_SIZE];
 
 /* MAC addresses */
 static const uint8_t broadcast_mac[6] = BROADCAST_MAC;
-static const uint8_t custom_bssid[6] = CUSTOM_BSSID;
 
-/* Sequence number for TX frames */
-static uint16_t tx_sequence = 0;
+/* Sequence numbers for TX frames, one counter per link, so a
+ * receiver's loss estimate only sees frames sent to its link */
+static uint16_t tx_sequence[LINK_ID_COUNT];
 
 /* TX ready flag: cleared when TX in progress, set by callback */
 static volatile uint8_t tx_ready = 1;
 
+#if LATENCY_HIST_ENABLED
+static uint32_t tx_start_cycles = 0;        /* wifi_send_pkt_freedom() call */
+#endif
+
+/* Frame in flight, for the capacity model check */
+static uint32_t tx_start_us = 0;
+static uint16_t tx_payload_len = 0;
+
+/* Optional hook run when a TX completes (queues next frame) */
+static void (*tx_done_hook)(void) = NULL;
+
 /* Statistics */
 static uint32_t tx_count = 0;
 static uint32_t rx_count = 0;
 static uint32_t tx_error_count = 0;
-static uint32_t rx_drop_count = 0;
+static uint32_t tx_busy_count = 0;
+static uint32_t rx_reject_count[RX_STAGE_COUNT];
+static uint32_t tx_airtime_us = 0;
+
+/* RX filter mode (hardware pre-filter state machine) */
+enum rx_filter_state {
+    RXF_SOFTWARE,       /* Software filter only */
+    RXF_HARDWARE,       /* SDK MAC filter + software check */
+    RXF_PROBE           /* Filter briefly lifted to see if it hides link frames */
+};
+
+static uint8_t rxf_state = RXF_SOFTWARE;
+static uint8_t rxf_hw_active = 0;       /* SDK filter currently installed */
+static bool rxf_verified = false;       /* Link frames seen through the HW filter */
+static uint32_t rxf_since_us = 0;       /* Last mode change */
+static uint32_t rxf_probe_rx_count = 0; /* rx_count when the probe started */
+static uint32_t rxf_fallback_count = 0;
+static bool rxf_requested = false;      /* Config / SET_RX_FILTER choice */
+static bool rxf_fell_back = false;      /* Probe found it hiding link frames */
+
+/* Append RX metadata to forwarded frames */
+static bool rx_meta_enabled = RX_META_TRAILER;
+
+/* RX callback profile: window being filled, last full window */
+static struct rx_profile rx_prof_live;
+static struct rx_profile rx_prof_snapshot;
+static uint32_t rx_prof_start_us = 0;
+
+/* RX callback cost, indexed by rxf_hw_active */
+static uint32_t rx_cb_calls[2];
+static uint32_t rx_cb_cycles[2];
+static uint32_t rx_mode_time_us[2];
+
+/* RX signal: RSSI average (x16 fixed point, alpha 1/8) and last arrival */
+static int16_t rx_rssi_x16 = 0;
+static uint32_t rx_last_us = 0;
 
 /* ==================================================
  * FORWARD DECLARATIONS
@@ -50,8 +111,11 @@ static void wifi_freedom_tx_cb(uint8_t status);
  * Addr1: Broadcast
  * Addr2: ESP8266 MAC address
  * Addr3: Custom BSSID (used for RX filtering)
+ * Sequence number: the link's own counter
+ * Fragment number: traffic class (always a single fragment)
  */
-static void build_80211_header(struct ieee80211_hdr *hdr)
+static void build_80211_header(struct ieee80211_hdr *hdr, uint8_t tclass, uint8_t link,
+                               const uint8_t *bssid)
 {
     /* Frame Control: Probe Request management frame (type 0, subtype 4)
      * Using management frames because ESP8266 promiscuous mode only
@@ -68,12 +132,13 @@ static void build_80211_header(struct ieee80211_hdr *hdr)
     /* Addr2: Our MAC address (source) */
     wifi_get_macaddr(STATION_IF, hdr->addr2);
 
-    /* Addr3: Custom BSSID (RX filtering key) */
-    os_memcpy(hdr->addr3, custom_bssid, 6);
+    /* Addr3: Link BSSID (RX filtering key) */
+    os_memcpy(hdr->addr3, bssid, 6);
 
-    /* Sequence Control: [15:4] = sequence, [3:0] = fragment (0) */
-    hdr->seq_ctrl = (tx_sequence << 4) & 0xFFF0;
-    tx_sequence++;
+    /* Sequence Control: [15:4] = sequence, [3:0] = traffic class
+     * We never fragment, so the fragment field carries the class */
+    hdr->seq_ctrl = ((tx_sequence[link] << 4) & 0xFFF0) | (tclass & 0x000F);
+    tx_sequence[link]++;
 }
 
 /* ==================================================
@@ -86,38 +151,70 @@ static void build_80211_header(struct ieee80211_hdr *hdr)
  */
 static void wifi_freedom_tx_cb(uint8_t status)
 {
+    LAT_CYCLES(LAT_TX_AIR, cycles_now() - tx_start_cycles);
+    TRACE(TRACE_EV_TX_DONE, status, 0);
+    airtime_model_note(tx_payload_len, system_get_time() - tx_start_us);
     tx_ready = 1;
+
+    if (tx_done_hook != NULL) {
+        tx_done_hook();
+    }
 }
 
 /* ==================================================
  * TX IMPLEMENTATION
  * ================================================== */
 
-int wifi_raw_send(const uint8_t *raw_data, uint16_t len)
+int wifi_raw_send(const uint8_t *raw_data, uint16_t len, uint8_t tclass, uint8_t link,
+                  bool budgeted)
 {
+    const uint8_t *bssid = links_get_bssid(link);
+
     /* Validate input */
-    if (raw_data == NULL || len == 0 || len > MAX_PACKET_SIZE) {
+    if (raw_data == NULL || len == 0 || len > MAX_AIR_PAYLOAD_SIZE) {
         DEBUG_PRINTF("wifi_raw_send: Invalid input (len=%u)\n", len);
+        TRACE(TRACE_EV_TX_ERROR, TRACE_TX_ERR_INVALID, len);
+        tx_error_count++;
+        RATE_ADD(RATE_DROPS, 1);
+        return -1;
+    }
+
+    /* Link removed while its frames were queued */
+    if (bssid == NULL) {
+        DEBUG_PRINTF("wifi_raw_send: Unknown link %u\n", link);
+        TRACE(TRACE_EV_TX_ERROR, TRACE_TX_ERR_NO_LINK, len);
         tx_error_count++;
+        RATE_ADD(RATE_DROPS, 1);
         return -1;
     }
 
     /* Check if previous TX is still in progress */
     if (!tx_ready) {
         DEBUG_PRINTF("TX BUSY\n");
+        TRACE(TRACE_EV_TX_BUSY, 0, len);
         tx_error_count++;
+        RATE_ADD(RATE_DROPS, 1);
+        tx_busy_count++;
         return -1;
     }
 
     /* Build 802.11 header */
     struct ieee80211_hdr *hdr = (struct ieee80211_hdr *)tx_frame_buffer;
-    build_80211_header(hdr);
+    build_80211_header(hdr, tclass, link, bssid);
+
+#if FHSS_ENABLED
+    /* Hop index and phase, so the follower can track our timebase */
+    fhss_fill_sync(tx_frame_buffer + IEEE80211_HEADER_SIZE);
+#endif
+#if TDMA_ENABLED
+    tdma_fill_sync(tx_frame_buffer + IEEE80211_HEADER_SIZE + FHSS_SYNC_SIZE);
+#endif
 
     /* Append raw payload (encrypted by RP2040) */
-    os_memcpy(tx_frame_buffer + IEEE80211_HEADER_SIZE, raw_data, len);
+    os_memcpy(tx_frame_buffer + IEEE80211_HEADER_SIZE + AIR_SYNC_SIZE, raw_data, len);
 
     /* Total frame size */
-    uint16_t frame_len = IEEE80211_HEADER_SIZE + len;
+    uint16_t frame_len = IEEE80211_HEADER_SIZE + AIR_SYNC_SIZE + len;
 
     /* Mark TX as in-progress before sending */
     tx_ready = 0;
@@ -130,96 +227,387 @@ int wifi_raw_send(const uint8_t *raw_data, uint16_t len)
      *
      * Returns: 0 on success, -1 on error (queue full, etc.)
      */
+#if LATENCY_HIST_ENABLED
+    tx_start_cycles = cycles_now();
+#endif
+    tx_start_us = system_get_time();
+    tx_payload_len = AIR_SYNC_SIZE + len;
     int result = wifi_send_pkt_freedom(tx_frame_buffer, frame_len, 0);
 
     if (result == 0) {
+        uint32_t frame_us = airtime_frame_us(AIR_SYNC_SIZE + len);
+
+        TRACE(TRACE_EV_TX_SUBMIT, (link << 1) | tclass, len);
         tx_count++;
-        DEBUG_PRINTF("TX: len=%u, seq=%u\n", len, tx_sequence - 1);
+        RATE_ADD(RATE_TX_FRAMES, 1);
+        RATE_ADD(RATE_TX_BYTES, len);
+        tx_airtime_us += frame_us;
+        if (budgeted) {
+            airtime_budget_charge(frame_us);
+        }
+        tdma_note_tx(frame_us);
+        DEBUG_PRINTF("TX: len=%u, seq=%u\n", len, tx_sequence[link] - 1);
     } else {
         tx_ready = 1;  /* Reset on failure so we can retry */
         tx_error_count++;
+        RATE_ADD(RATE_DROPS, 1);
+        TRACE(TRACE_EV_TX_ERROR, TRACE_TX_ERR_SDK, len);
         DEBUG_PRINTF("TX FAILED: len=%u\n", len);
     }
 
     return result;
 }
 
+bool wifi_raw_tx_ready(void)
+{
+    /* With FHSS or TDMA, also hold frames that would overlap a hop
+     * or fall outside our slot */
+    return tx_ready != 0 && fhss_tx_open() && tdma_tx_open();
+}
+
+void wifi_raw_set_tx_done_cb(void (*cb)(void))
+{
+    tx_done_hook = cb;
+}
+
 /* ==================================================
  * RX IMPLEMENTATION
  * ================================================== */
 
 /**
- * Promiscuous mode RX callback
+ * On-air time of any received frame, for the channel survey
+ * 802.11n frames are timed at the nearest OFDM rate for their
+ * MCS (single stream, 20 MHz), which is close enough for load.
+ *
+ * @return: Frame duration in microseconds
+ */
+static uint32_t rx_airtime_us(const struct RxControl *rx_ctrl)
+{
+    /* RxControl rate code of the 802.11g rate nearest MCS 0-7 */
+    static const uint8_t mcs_rate_code[8] = { 11, 10, 15, 9, 13, 8, 12, 12 };
+
+    if (rx_ctrl->sig_mode != 0) {
+        return airtime_rx_frame_us(mcs_rate_code[rx_ctrl->MCS & 7], rx_ctrl->HT_length);
+    }
+    return airtime_rx_frame_us(rx_ctrl->rate, rx_ctrl->legacy_length);
+}
+
+/**
+ * Filter and forward one promiscuous frame
  * CRITICAL: Runs in interrupt context - keep SHORT!
  *
- * Filtering strategy:
- * 1. Check sig_mode and minimum length (early reject)
- * 2. Parse frame control (data frames only)
- * 3. Check BSSID (custom MAC address filter)
- * 4. Extract payload and send to UART
+ * While the boot channel survey runs, every frame is first
+ * counted towards the current channel's load. In sniffer mode
+ * every frame is also copied to the capture stream.
+ *
+ * Filtering strategy (cheapest reject first):
+ * 1. Check sig_mode and minimum length (RxControl)
+ * 2. Frame control: our type and subtype only (one halfword)
+ * 3. BSSID: tail halfword, then head word - always done, even
+ *    with the SDK MAC filter installed, so correctness never
+ *    depends on what the hardware filter matches
+ * 4. Sequence number: drop repeats from the same sender before
+ *    any UART work
+ * 5. Extract payload and send to UART
+ *
+ * @return: RX_STAGE_ACCEPT, or the stage that rejected the frame
  */
-static void wifi_promiscuous_rx_cb(uint8_t *buf, uint16_t len)
+static uint8_t wifi_rx_process(uint8_t *buf, uint16_t len)
 {
     /* Parse RxControl structure (SDK metadata) */
     struct RxControl *rx_ctrl = (struct RxControl *)buf;
+    uint8_t stage;
+    uint8_t link = 0;
+    uint32_t now;
+
+    /* Boot survey: every frame heard counts towards channel load */
+    if (survey_get_state() == SURVEY_STATE_SCANNING) {
+        survey_rx(rx_ctrl->rssi, rx_airtime_us(rx_ctrl));
+    }
+
+    /* Sniffer: everything heard, before any filter */
+    if (sniffer_active()) {
+        sniffer_rx(buf, len);
+    }
 
     /* Filter 1: Only accept legacy 802.11b/g frames
      * Skip 802.11n frames (sig_mode != 0)
      * Minimum length: RxControl + 802.11 header + payload + FCS
      */
     if ((rx_ctrl->sig_mode != 0) || (len < (sizeof(struct RxControl) + 28))) {
-        rx_drop_count++;
-        return;
+        return RX_STAGE_PHY;
     }
 
     /* Parse 802.11 MAC header (follows RxControl) */
     struct ieee80211_hdr *hdr = (struct ieee80211_hdr *)(buf + sizeof(struct RxControl));
 
-    /* Filter 2: Only accept management frames (type 0x00)
-     * We use Probe Request frames for full payload capture
+    /* Filters 2-3: Probe Request with a BSSID from the link table
+     * The BSSID is the KEY filter - rejects >99% of ambient WiFi
      */
-    uint16_t frame_type = hdr->frame_control & IEEE80211_FCTL_FTYPE;
-    if (frame_type != IEEE80211_FCTL_MGMT) {
-        rx_drop_count++;
-        return;
+    stage = rx_match_header(links_get_match(), (const uint8_t *)hdr, &link);
+    if (stage != RX_STAGE_ACCEPT) {
+        return stage;
     }
 
-    /* Filter 3: Only accept frames with our custom BSSID
-     * This is the KEY filter - rejects >99% of ambient WiFi
-     */
-    if (os_memcmp(hdr->addr3, custom_bssid, 6) != 0) {
-        rx_drop_count++;
-        return;
+    /* Filter 4: Retransmissions, reflections and replayed copies */
+    now = system_get_time();
+    if (dedup_check(hdr->addr2, link, hdr->seq_ctrl >> 4, now)) {
+        TRACE(TRACE_EV_RX_REJECT, RX_STAGE_DUPLICATE, rx_ctrl->legacy_length);
+        return RX_STAGE_DUPLICATE;
     }
 
     /* Frame passed all filters - extract payload */
-    uint8_t *payload = (uint8_t *)hdr + IEEE80211_HEADER_SIZE;
+    uint8_t *payload = (uint8_t *)hdr + IEEE80211_HEADER_SIZE + AIR_SYNC_SIZE;
 
     /* Calculate payload length from legacy_length (actual over-the-air frame size)
-     * legacy_length = MAC header + payload + FCS(4)
+     * legacy_length = MAC header + [sync fields] + payload + FCS(4)
      * The 'len' parameter is always 128 for management frames (fixed buffer).
      */
-    uint16_t payload_len = rx_ctrl->legacy_length - IEEE80211_HEADER_SIZE - 4;
+    uint16_t payload_len = rx_ctrl->legacy_length - IEEE80211_HEADER_SIZE - AIR_SYNC_SIZE - 4;
 
-    /* Sanity check payload length */
-    if (payload_len > MAX_PACKET_SIZE) {
+    /* The SDK keeps only RX_MGMT_CAPTURE_SIZE frame bytes: anything
+     * longer would be read from the buffer's cnt/len tail and beyond */
+    if (payload_len > MAX_AIR_PAYLOAD_SIZE) {
         DEBUG_PRINTF("RX: Payload too large (%u bytes)\n", payload_len);
-        rx_drop_count++;
-        return;
+        TRACE(TRACE_EV_RX_REJECT, RX_STAGE_LENGTH, rx_ctrl->legacy_length);
+        return RX_STAGE_LENGTH;
     }
 
-    rx_count++;
+#if FHSS_ENABLED || TDMA_ENABLED
+    {
+        /* Follower: the leader's timebases, as of this frame */
+        const uint8_t *sync = (const uint8_t *)hdr + IEEE80211_HEADER_SIZE;
+        uint32_t frame_us = airtime_rx_frame_us(rx_ctrl->rate, rx_ctrl->legacy_length);
+
+#if FHSS_ENABLED
+        fhss_rx_sync(sync, now, frame_us);
+#endif
+#if TDMA_ENABLED
+        tdma_rx_sync(sync + FHSS_SYNC_SIZE, now, frame_us);
+#endif
+    }
+#endif
 
-    /* WiFi → UART bridge: forward payload with length prefix
-     * Protocol: [LEN_HI][LEN_LO][payload...]
+    /* Air-side link quality (loss, RSSI, jitter) */
+    linkq_rx(link, hdr->seq_ctrl >> 4, rx_ctrl->rssi, now);
+
+    uint8_t tclass = (hdr->seq_ctrl & 0x000F) ? TC_PRIORITY : TC_BULK;
+
+    /* Echo responder: send it back before the UART copy */
+    ping_echo(payload, payload_len, tclass, link);
+
+    /* WiFi → UART bridge: split into length-prefixed UART frames
+     * Protocol: [LEN_HI][LEN_LO][payload...] per frame
      */
-    uint8_t len_prefix[2];
-    len_prefix[0] = (payload_len >> 8) & 0xFF;
-    len_prefix[1] = payload_len & 0xFF;
-    uart_write_bytes(len_prefix, 2);
-    uart_write_bytes(payload, payload_len);
+    uint8_t meta[RX_META_SIZE];
+    uint8_t meta_len = 0;
+
+    /* Optional metadata trailer: [rssi][rate][channel][seq u16][arrival_us u32] */
+    if (rx_meta_enabled) {
+        uint16_t seq = hdr->seq_ctrl >> 4;
+
+        meta[0] = (uint8_t)rx_ctrl->rssi;
+        meta[1] = rx_ctrl->rate;
+        meta[2] = rx_ctrl->channel;
+        meta[3] = seq & 0xFF;
+        meta[4] = seq >> 8;
+        meta[5] = now & 0xFF;
+        meta[6] = (now >> 8) & 0xFF;
+        meta[7] = (now >> 16) & 0xFF;
+        meta[8] = (now >> 24) & 0xFF;
+        meta_len = RX_META_SIZE;
+    }
+
+    if (agg_deliver(payload, payload_len, tclass, link, meta, meta_len) < 0) {
+        TRACE(TRACE_EV_RX_REJECT, RX_STAGE_DELIVER, rx_ctrl->legacy_length);
+        return RX_STAGE_DELIVER;
+    }
+
+    /* Track how well we hear the link (first sample seeds the average) */
+    if (rx_count == 0) {
+        rx_rssi_x16 = rx_ctrl->rssi * 16;
+    } else {
+        rx_rssi_x16 += (rx_ctrl->rssi * 16 - rx_rssi_x16) / 8;
+    }
+    rx_last_us = now;
+
+    links_note_rx(link);
+    rx_count++;
+    RATE_ADD(RATE_RX_FRAMES, 1);
+    RATE_ADD(RATE_RX_BYTES, payload_len);
+    TRACE(TRACE_EV_RX_ACCEPT, link, payload_len);
 
     DEBUG_PRINTF("WiFi->UART: %u bytes rssi=%d\n", payload_len, rx_ctrl->rssi);
+    return RX_STAGE_ACCEPT;
+}
+
+/**
+ * Promiscuous mode RX callback
+ * Counts rejects per stage, and CCOUNT cycles per filter mode (so the
+ * effect of the hardware pre-filter can be measured directly) and per
+ * outcome (so the cost of each filter stage is visible).
+ */
+static void wifi_promiscuous_rx_cb(uint8_t *buf, uint16_t len)
+{
+    uint32_t start = cycles_now();
+    uint32_t cycles;
+    uint8_t hw = rxf_hw_active;
+    uint8_t outcome;
+
+    outcome = wifi_rx_process(buf, len);
+    cycles = cycles_now() - start;
+
+    if (outcome != RX_STAGE_ACCEPT) {
+        rx_reject_count[outcome]++;
+    }
+
+    rx_cb_calls[hw]++;
+    rx_cb_cycles[hw] += cycles;
+
+    rx_prof_live.calls++;
+    rx_prof_live.cycles += cycles;
+    if (cycles > rx_prof_live.max_cycles) {
+        rx_prof_live.max_cycles = cycles;
+    }
+    rx_prof_live.outcome_calls[outcome]++;
+    rx_prof_live.outcome_cycles[outcome] += cycles;
+
+    /* Accepted frames end with the UART ring enqueue */
+    if (outcome == RX_STAGE_ACCEPT) {
+        LAT_CYCLES(LAT_RX_PROCESS, cycles);
+    }
+}
+
+/**
+ * Publish the profiler window once RX_PROFILE_PERIOD_MS has passed
+ */
+static void rx_profile_poll(uint32_t now)
+{
+    uint32_t period_us = now - rx_prof_start_us;
+
+    if (period_us < RX_PROFILE_PERIOD_MS * 1000) {
+        return;
+    }
+
+    rx_prof_live.period_us = period_us;
+    rx_prof_snapshot = rx_prof_live;
+    os_memset(&rx_prof_live, 0, sizeof(rx_prof_live));
+    rx_prof_start_us = now;
+}
+
+/* ==================================================
+ * HARDWARE PRE-FILTER
+ * ================================================== */
+
+/**
+ * Install or remove the SDK MAC filter
+ * The filter is cleared whenever promiscuous mode is re-enabled,
+ * so toggle promiscuous mode and re-install as needed.
+ */
+static void rxf_apply(bool hw)
+{
+    uint32_t now = system_get_time();
+    const uint8_t *bssid;
+
+    rx_mode_time_us[rxf_hw_active] += now - rxf_since_us;
+    rxf_since_us = now;
+
+    wifi_promiscuous_enable(0);
+    wifi_promiscuous_enable(1);
+
+    /* Only possible with a single link (one hardware address) */
+    bssid = links_get_sole_bssid();
+    rxf_hw_active = (hw && bssid != NULL && wifi_promiscuous_set_mac(bssid)) ? 1 : 0;
+}
+
+/**
+ * Enter hardware or software filtering and restart verification
+ */
+static void rxf_install(bool enable)
+{
+    rxf_state = enable ? RXF_HARDWARE : RXF_SOFTWARE;
+    rxf_verified = false;
+    rxf_probe_rx_count = rx_count;
+    rxf_apply(enable);
+
+    if (enable && !rxf_hw_active) {
+        DEBUG_PRINTF("RX: SDK MAC filter unavailable, software only\n");
+        rxf_state = RXF_SOFTWARE;
+    }
+}
+
+void wifi_raw_set_hw_filter(bool enable)
+{
+    rxf_requested = enable;
+    rxf_fell_back = false;
+    rxf_install(enable);
+}
+
+void wifi_raw_refresh_hw_filter(void)
+{
+    /* Only the request counts: the filter itself is down during a
+     * probe window and for several links */
+    if (rxf_requested && !rxf_fell_back) {
+        rxf_install(true);
+    }
+}
+
+bool wifi_raw_get_hw_filter(void)
+{
+    return rxf_hw_active != 0;
+}
+
+bool wifi_raw_get_hw_filter_request(void)
+{
+    return rxf_requested;
+}
+
+void wifi_raw_poll(void)
+{
+    uint32_t now = system_get_time();
+    uint32_t last = rx_last_us;
+
+    rx_profile_poll(now);
+
+    switch (rxf_state) {
+        case RXF_HARDWARE:
+            if (rx_count != rxf_probe_rx_count) {
+                /* A link frame made it through the hardware filter */
+                rxf_verified = true;
+            }
+            if (rxf_verified) {
+                break;
+            }
+
+            /* Quiet and never verified: lift the filter briefly */
+            if ((int32_t)(rxf_since_us - last) > 0) {
+                last = rxf_since_us;
+            }
+            if (now - last > RX_HW_FILTER_QUIET_MS * 1000) {
+                rxf_state = RXF_PROBE;
+                rxf_probe_rx_count = rx_count;
+                rxf_apply(false);
+            }
+            break;
+
+        case RXF_PROBE:
+            if (rx_count != rxf_probe_rx_count) {
+                /* Link frames appear only without the filter - it was
+                 * hiding them. Stay on software filtering. */
+                rxf_state = RXF_SOFTWARE;
+                rxf_fell_back = true;
+                rxf_fallback_count++;
+                os_printf("RX: SDK MAC filter hides link frames, software filter only\n");
+            } else if (now - rxf_since_us > RX_HW_FILTER_PROBE_MS * 1000) {
+                /* Links may have changed during the probe */
+                rxf_apply(true);
+                rxf_state = rxf_hw_active ? RXF_HARDWARE : RXF_SOFTWARE;
+            }
+            break;
+
+        default:
+            break;
+    }
 }
 
 /* ==================================================
@@ -243,6 +631,10 @@ void wifi_raw_init(uint8_t channel)
     /* Register TX completion callback (REQUIRED for wifi_send_pkt_freedom) */
     wifi_register_send_pkt_freedom_cb(wifi_freedom_tx_cb);
 
+    /* Sender sequence windows and link quality (before the first RX callback) */
+    dedup_init();
+    linkq_init();
+
     /* Register promiscuous callback */
     wifi_set_promiscuous_rx_cb(wifi_promiscuous_rx_cb);
 
@@ -253,13 +645,18 @@ void wifi_raw_init(uint8_t channel)
     tx_count = 0;
     rx_count = 0;
     tx_error_count = 0;
-    rx_drop_count = 0;
-    tx_sequence = 0;
+    tx_busy_count = 0;
+    os_memset(rx_reject_count, 0, sizeof(rx_reject_count));
+    tx_airtime_us = 0;
+    os_memset(tx_sequence, 0, sizeof(tx_sequence));
+
+    /* Hardware pre-filter on our BSSID (after promiscuous enable) */
+    rxf_since_us = system_get_time();
+    rx_prof_start_us = rxf_since_us;
+    wifi_raw_set_hw_filter(RX_HW_FILTER_ENABLED);
 
     DEBUG_PRINTF("WiFi Raw initialized: channel %u\n", channel);
-    DEBUG_PRINTF("BSSID filter: %02X:%02X:%02X:%02X:%02X:%02X\n",
-                 custom_bssid[0], custom_bssid[1], custom_bssid[2],
-                 custom_bssid[3], custom_bssid[4], custom_bssid[5]);
+    DEBUG_PRINTF("BSSID filter: %u link(s)\n", links_count());
     os_printf("Frame type: Probe Request (0x0040), legacy_length for RX sizing\n");
 }
 
@@ -274,8 +671,9 @@ void wifi_raw_set_channel(uint8_t channel)
         return;
     }
 
+    /* No debug print: called on every FHSS hop */
     wifi_set_channel(channel);
-    DEBUG_PRINTF("Channel changed to: %u\n", channel);
+    TRACE(TRACE_EV_CHANNEL, channel, 0);
 }
 
 uint8_t wifi_raw_get_channel(void)
@@ -302,9 +700,64 @@ uint32_t wifi_get_tx_error_count(void)
     return tx_error_count;
 }
 
-uint32_t wifi_get_rx_drop_count(void)
+uint32_t wifi_get_tx_busy_count(void)
+{
+    return tx_busy_count;
+}
+
+uint32_t wifi_get_rx_reject_count(uint8_t stage)
+{
+    return (stage < RX_STAGE_COUNT) ? rx_reject_count[stage] : 0;
+}
+
+uint32_t wifi_get_tx_airtime_us(void)
+{
+    return tx_airtime_us;
+}
+
+const struct rx_profile *wifi_raw_get_rx_profile(void)
+{
+    return &rx_prof_snapshot;
+}
+
+void wifi_raw_set_rx_meta(bool enable)
+{
+    rx_meta_enabled = enable;
+}
+
+bool wifi_raw_get_rx_meta(void)
+{
+    return rx_meta_enabled;
+}
+
+void wifi_raw_get_rx_cb_stats(bool hw, uint32_t *calls, uint32_t *cycles, uint32_t *time_us)
+{
+    uint8_t mode = hw ? 1 : 0;
+    uint32_t time = rx_mode_time_us[mode];
+
+    /* Include the time spent in the current mode so far */
+    if (rxf_hw_active == mode) {
+        time += system_get_time() - rxf_since_us;
+    }
+
+    *calls = rx_cb_calls[mode];
+    *cycles = rx_cb_cycles[mode];
+    *time_us = time;
+}
+
+uint32_t wifi_raw_get_hw_filter_fallback_count(void)
+{
+    return rxf_fallback_count;
+}
+
+int8_t wifi_raw_get_rssi(void)
+{
+    return (int8_t)(rx_rssi_x16 / 16);
+}
+
+uint32_t wifi_raw_get_last_rx_us(void)
 {
-    return rx_drop_count;
+    return rx_last_us;
 }
 
 void wifi_reset_stats(void)
@@ -312,5 +765,12 @@ void wifi_reset_stats(void)
     tx_count = 0;
     rx_count = 0;
     tx_error_count = 0;
-    rx_drop_count = 0;
+    tx_busy_count = 0;
+    os_memset(rx_reject_count, 0, sizeof(rx_reject_count));
+    tx_airtime_us = 0;
+
+    rx_cb_calls[0] = rx_cb_calls[1] = 0;
+    rx_cb_cycles[0] = rx_cb_cycles[1] = 0;
+    rx_mode_time_us[0] = rx_mode_time_us[1] = 0;
+    rxf_since_us = system_get_time();
 }
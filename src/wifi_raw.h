@@ -7,6 +7,7 @@
 #define WIFI_RAW_H
 
 #include "c_types.h"
+#include "rx_filter.h"
 
 /* ==================================================
  * 802.11 MAC HEADER STRUCTURES
@@ -56,6 +57,20 @@ struct RxControl {
     unsigned:12;
 };
 
+/**
+ * RX callback CPU profile over one RX_PROFILE_PERIOD_MS window
+ * Outcomes are indexed by enum rx_stage; RX_STAGE_ACCEPT is the
+ * last entry (frames forwarded to the UART).
+ */
+struct rx_profile {
+    uint32_t period_us;                             /* Window length */
+    uint32_t calls;
+    uint32_t cycles;                                /* CCOUNT cycles in the callback */
+    uint32_t max_cycles;                            /* Longest single call */
+    uint32_t outcome_calls[RX_STAGE_COUNT + 1];
+    uint32_t outcome_cycles[RX_STAGE_COUNT + 1];
+};
+
 /* ==================================================
  * PUBLIC API
  * ================================================== */
@@ -63,6 +78,7 @@ struct RxControl {
 /**
  * Initialize WiFi in raw mode
  * Sets up promiscuous mode and configures channel
+ * Call after links_init() (the RX filter reads the link table).
  *
  * @param channel: WiFi channel 1-14
  */
@@ -73,10 +89,29 @@ void wifi_raw_init(uint8_t channel);
  * Builds minimal 802.11 header and injects packet
  *
  * @param raw_data: Payload bytes (encrypted by RP2040)
- * @param len: Payload length
- * @return: 0 on success, -1 on error
+ * @param len: Payload length (up to MAX_AIR_PAYLOAD_SIZE)
+ * @param tclass: Traffic class, carried in the fragment-number field
+ * @param link: Link ID; its BSSID goes in Addr3
+ * @param budgeted: Charge the airtime budget (false for test traffic)
+ * @return: 0 on success, -1 on error (including an unknown link)
  */
-int wifi_raw_send(const uint8_t *raw_data, uint16_t len);
+int wifi_raw_send(const uint8_t *raw_data, uint16_t len, uint8_t tclass, uint8_t link,
+                  bool budgeted);
+
+/**
+ * Check whether the previous injected frame has completed
+ *
+ * @return: true if wifi_raw_send() can be called now
+ */
+bool wifi_raw_tx_ready(void);
+
+/**
+ * Register a hook called when an injected frame completes
+ * Runs in SDK callback context - keep it short (e.g. post a task).
+ *
+ * @param cb: Hook function, or NULL to remove
+ */
+void wifi_raw_set_tx_done_cb(void (*cb)(void));
 
 /**
  * Set WiFi channel (runtime configuration)
@@ -114,11 +149,120 @@ uint32_t wifi_get_rx_count(void);
 uint32_t wifi_get_tx_error_count(void);
 
 /**
- * Get RX drop count
+ * Get TX busy count
+ * Sends refused because the previous frame had not completed
+ * (included in the TX error count)
+ *
+ * @return: Number of busy refusals
+ */
+uint32_t wifi_get_tx_busy_count(void);
+
+/**
+ * Get number of RX frames rejected at one filter stage
+ *
+ * @param stage: enum rx_stage (rx_filter.h)
+ * @return: Reject count
+ */
+uint32_t wifi_get_rx_reject_count(uint8_t stage);
+
+/**
+ * Get cumulative TX airtime (diagnostic)
+ * Estimated on-air time of all injected frames
+ *
+ * @return: Microseconds of airtime since init (wraps at ~71 min)
+ */
+uint32_t wifi_get_tx_airtime_us(void);
+
+/**
+ * Install or remove the SDK hardware MAC pre-filter
+ * The software BSSID check runs either way. The choice is kept:
+ * link table changes re-apply it (see wifi_raw_refresh_hw_filter()).
+ *
+ * @param enable: true to filter on our BSSID in hardware
+ */
+void wifi_raw_set_hw_filter(bool enable);
+
+/**
+ * Re-apply the requested filter after a link table change
+ * Installs it on the sole BSSID, or lifts it for several links;
+ * stays off if it was requested off or the probe gave up on it.
+ */
+void wifi_raw_refresh_hw_filter(void);
+
+/**
+ * Check whether the hardware pre-filter is installed
+ *
+ * @return: true if active
+ */
+bool wifi_raw_get_hw_filter(void);
+
+/**
+ * Check whether the hardware pre-filter is requested
+ * Unlike wifi_raw_get_hw_filter(), not cleared by several links
+ * or a probe window; use it to save and restore the setting.
+ *
+ * @return: true if requested (config or last SET_RX_FILTER)
+ */
+bool wifi_raw_get_hw_filter_request(void);
+
+/**
+ * Periodic RX housekeeping (hardware filter probe)
+ * Call from the main timer.
+ */
+void wifi_raw_poll(void);
+
+/**
+ * Get the last complete RX callback profile window
+ *
+ * @return: Snapshot (read-only, replaced every RX_PROFILE_PERIOD_MS)
+ */
+const struct rx_profile *wifi_raw_get_rx_profile(void);
+
+/**
+ * Enable or disable the RX metadata trailer (RX_META_SIZE bytes
+ * appended to each frame forwarded to the UART)
+ *
+ * @param enable: true to append metadata
+ */
+void wifi_raw_set_rx_meta(bool enable);
+
+/**
+ * Check whether the RX metadata trailer is on
+ *
+ * @return: true if enabled
+ */
+bool wifi_raw_get_rx_meta(void);
+
+/**
+ * Get promiscuous callback cost for one filter mode
+ *
+ * @param hw: true for hardware-filter mode, false for software-only
+ * @param calls: Receives callback invocations in that mode
+ * @param cycles: Receives CPU cycles spent in the callback
+ * @param time_us: Receives time spent in that mode (for rates)
+ */
+void wifi_raw_get_rx_cb_stats(bool hw, uint32_t *calls, uint32_t *cycles, uint32_t *time_us);
+
+/**
+ * Get number of times the hardware filter was abandoned
+ *
+ * @return: Fallbacks to software-only filtering
+ */
+uint32_t wifi_raw_get_hw_filter_fallback_count(void);
+
+/**
+ * Get average RSSI of accepted frames
+ *
+ * @return: dBm (0 before the first frame)
+ */
+int8_t wifi_raw_get_rssi(void);
+
+/**
+ * Get arrival time of the last accepted frame
  *
- * @return: Number of packets dropped (failed filters)
+ * @return: system_get_time() value (0 before the first frame)
  */
-uint32_t wifi_get_rx_drop_count(void);
+uint32_t wifi_raw_get_last_rx_us(void);
 
 /**
  * Reset statistics counters
@@ -0,0 +1,149 @@
+#!/usr/bin/env python3
+"""
+Airtime model check for the ESP raw 802.11 radio
+
+Validates the capacity model (src/airtime.c, `make capacity`) against
+the module itself. For each payload size the traffic generator runs
+above the model's frame rate, so the radio sends back to back, and the
+module times every frame from wifi_send_pkt_freedom() to its TX-complete
+callback. GET_AIRTIME before and after gives the mean modeled and
+measured cycle; the frames actually sent give the achieved rate.
+
+    airtime_check.py --port /dev/ttyUSB0
+    airtime_check.py --port /tmp/esp-a --sizes 32,64,86 --seconds 5
+
+Frames taking more than twice the model (busy channel, other senders)
+are counted as late and left out of the means.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+# ==================================================
+# FIRMWARE CONSTANTS (src/ctrl.h, src/trafgen.h, src/airtime.h)
+# ==================================================
+
+CTRL_CMD_GET_AIRTIME = 0x29
+CTRL_CMD_START_TRAFGEN = 0x64
+CTRL_CMD_STOP_TRAFGEN = 0x65
+CTRL_RESPONSE_BIT = 0x80
+UART_LEN_CLASS_BIT = 0x80
+UART_LEN_LOCAL_BIT = 0x40
+UART_LEN_FLAG_BITS = 0xFE
+
+AIRTIME = struct.Struct("<BHIIII")      # [rate][access_us u16][frames][late][model_us][measured_us]
+TRAFGEN = struct.Struct("<BBBHHIIII")   # [state][link][pattern][size][rate][sent][busy][errors][elapsed_ms]
+TRAFGEN_CONSTANT = 0
+
+RATE_NAMES = ["1M", "2M", "5.5M", "11M"]
+
+
+# ==================================================
+# UART LINK
+# ==================================================
+
+
+class Link:
+    """Local command channel on the flight controller UART"""
+
+    def __init__(self, port, baud):
+        try:
+            import serial
+        except ImportError:
+            sys.exit("pyserial is needed (pip install pyserial)")
+        self.ser = serial.Serial(port, baud, timeout=0.05)
+        self.buf = bytearray()
+
+    def command(self, cmd, args=b"", timeout=1.0):
+        payload = bytes([cmd]) + args
+        hi = UART_LEN_CLASS_BIT | UART_LEN_LOCAL_BIT | ((len(payload) >> 8) & 0x01)
+        self.ser.write(bytes([hi, len(payload) & 0xFF]) + payload)
+
+        # The console shares the UART: scan for our response frame
+        want = cmd | CTRL_RESPONSE_BIT
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            self.buf += self.ser.read(512)
+            i = 0
+            while i + 4 <= len(self.buf):
+                hi = self.buf[i]
+                n = ((hi & ~UART_LEN_FLAG_BITS & 0xFF) << 8) | self.buf[i + 1]
+                if hi & UART_LEN_LOCAL_BIT and self.buf[i + 2] == want and n >= 2:
+                    if i + 2 + n > len(self.buf):
+                        break
+                    frame = bytes(self.buf[i + 2:i + 2 + n])
+                    del self.buf[:i + 2 + n]
+                    return frame[1], frame[2:]
+                i += 1
+            del self.buf[:i]
+        sys.exit("no response to command 0x%02X" % cmd)
+
+
+# ==================================================
+# CHECK
+# ==================================================
+
+
+def get_airtime(link):
+    status, data = link.command(CTRL_CMD_GET_AIRTIME)
+    if status != 0:
+        sys.exit("GET_AIRTIME failed (status %u)" % status)
+    return AIRTIME.unpack_from(data)
+
+
+def run_size(link, size, seconds, rate_pps):
+    rate, access_us, frames0, late0, model0, meas0 = get_airtime(link)
+
+    args = struct.pack("<BBHHIB", 0, TRAFGEN_CONSTANT, size, rate_pps, 0, 1)
+    status, _ = link.command(CTRL_CMD_START_TRAFGEN, args)
+    if status != 0:
+        sys.exit("START_TRAFGEN refused (AGG_ENABLED=0, or size over MAX_BRIDGE_PACKET_SIZE?)")
+    time.sleep(seconds)
+    _, data = link.command(CTRL_CMD_STOP_TRAFGEN)
+    report = TRAFGEN.unpack_from(data)
+    sent, elapsed_ms = report[5], report[8]
+
+    _, _, frames1, late1, model1, meas1 = get_airtime(link)
+    frames = (frames1 - frames0) & 0xFFFFFFFF
+    late = (late1 - late0) & 0xFFFFFFFF
+    model_us = (model1 - model0) & 0xFFFFFFFF
+    meas_us = (meas1 - meas0) & 0xFFFFFFFF
+    fitted = frames - late
+
+    if fitted == 0:
+        print("%8u  no frames measured" % size)
+        return rate, access_us
+
+    model = model_us / fitted
+    meas = meas_us / fitted
+    fps = sent * 1e3 / elapsed_ms if elapsed_ms else 0
+    print("%8u %7u %5u %9.0f %9.0f %+6.1f%% %8.0f %8.0f" %
+          (size, frames, late, model, meas, (meas - model) * 100.0 / model, 1e6 / model, fps))
+    return rate, access_us
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Check the airtime model against measured TX cycles")
+    ap.add_argument("--port", required=True, help="serial port of the module")
+    ap.add_argument("--baud", type=int, default=460800, help="UART baud rate (default 460800)")
+    ap.add_argument("--sizes", default="16,32,64,86", help="record sizes to test (bytes)")
+    ap.add_argument("--seconds", type=float, default=3.0, help="run time per size")
+    ap.add_argument("--rate", type=int, default=5000, help="offered frames/s (above the channel's)")
+    args = ap.parse_args()
+
+    link = Link(args.port, args.baud)
+    print("%8s %7s %5s %9s %9s %7s %8s %8s" %
+          ("size", "frames", "late", "model us", "meas us", "error", "model/s", "sent/s"))
+
+    rate = access_us = None
+    for size in [int(s) for s in args.sizes.split(",")]:
+        rate, access_us = run_size(link, size, args.seconds, min(args.rate, 65535))
+
+    print("rate %s, channel access %u us; sizes are trafgen records (payload adds "
+          "the 2-byte aggregation header)" % (RATE_NAMES[rate & 3], access_us))
+
+
+if __name__ == "__main__":
+    main()
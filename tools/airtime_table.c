@@ -0,0 +1,65 @@
+/* ==================================================
+ * Airtime Capacity Table
+ * Prints the capacity model of src/airtime.c for every
+ * TX rate and a sweep of payload sizes: on-air time,
+ * send-to-TX-complete cycle (channel access + frame),
+ * frames per second and payload throughput one sender
+ * gets from an idle channel. Then checks the configured
+ * LINK_PACKET_RATE_HZ full-size frames against it.
+ *
+ * Build and run:  make capacity
+ * ================================================== */
+
+#include <stdio.h>
+
+#include "airtime.h"
+#include "user_config.h"
+
+/* airtime.c reads the clock for its budget only */
+uint32 system_get_time(void)
+{
+    return 0;
+}
+
+static const char *rate_name[] = { "1M", "2M", "5.5M", "11M" };
+
+int main(void)
+{
+    static const uint16_t sizes[] = { 16, 32, 64, 128, 256, AIR_SYNC_SIZE + MAX_AIR_PAYLOAD_SIZE };
+    uint16_t cfg_len = AIR_SYNC_SIZE + MAX_AIR_PAYLOAD_SIZE;
+    uint32_t cfg_permille;
+    uint8_t rate;
+    unsigned s;
+
+    printf("channel access: DIFS %u us + %u/2 slots of %u us = %u us per frame\n\n",
+           AIRTIME_DIFS_US, AIRTIME_CW_MIN, AIRTIME_SLOT_US, AIRTIME_ACCESS_US);
+    printf("%-5s %8s %9s %9s %8s %13s\n",
+           "rate", "payload", "frame us", "cycle us", "max fps", "goodput kbps");
+
+    for (rate = PHY_RATE_1M_L; rate <= PHY_RATE_11M_S; rate++) {
+        for (s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            printf("%-5s %8u %9u %9u %8u %13u%s\n",
+                   rate_name[rate], sizes[s],
+                   airtime_frame_us_at(rate, sizes[s]),
+                   airtime_tx_cycle_us_at(rate, sizes[s]),
+                   airtime_max_fps_at(rate, sizes[s]),
+                   airtime_goodput_bps_at(rate, sizes[s]) / 1000,
+                   (rate == WIFI_TX_RATE && sizes[s] == cfg_len) ? "  <- configured" : "");
+        }
+        printf("\n");
+    }
+
+    if (LINK_PACKET_RATE_HZ == 0) {
+        printf("LINK_PACKET_RATE_HZ=0: no capacity check\n");
+        return 0;
+    }
+
+    cfg_permille = LINK_PACKET_RATE_HZ * airtime_tx_cycle_us_at(WIFI_TX_RATE, cfg_len) / 1000;
+    printf("configured: %u Hz x %u bytes at %s = %u.%u%% of the channel, budget %u.%u%%: %s\n",
+           LINK_PACKET_RATE_HZ, cfg_len, rate_name[WIFI_TX_RATE],
+           cfg_permille / 10, cfg_permille % 10,
+           AIRTIME_BUDGET_PERMILLE / 10, AIRTIME_BUDGET_PERMILLE % 10,
+           cfg_permille > 1000 ? "DOES NOT FIT THE CHANNEL" :
+           (AIRTIME_BUDGET_ENABLED && cfg_permille > AIRTIME_BUDGET_PERMILLE) ? "OVER BUDGET" : "fits");
+    return 0;
+}
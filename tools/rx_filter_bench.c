@@ -0,0 +1,237 @@
+/* ==================================================
+ * RX Filter Host Benchmark
+ * Times the promiscuous header filter over a synthetic
+ * ambient-traffic mix: byte-wise (os_memcmp) reference
+ * versus the word-wise hash matcher in src/rx_filter.h,
+ * then lookup cost as the link table grows
+ *
+ * Build and run:  make bench
+ * ================================================== */
+
+#define HOST_BUILD
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "rx_filter.h"
+#include "user_config.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_UNIT "cycles"
+static uint64_t bench_now(void) { return __rdtsc(); }
+#else
+#define BENCH_UNIT "ns"
+static uint64_t bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+#endif
+
+#define FRAMES_PER_KIND     256
+#define ROUNDS              2000
+
+/* ==================================================
+ * SYNTHETIC TRAFFIC
+ * ================================================== */
+
+struct traffic_kind {
+    const char *name;
+    uint16_t fc;
+    uint8_t bssid[6];
+    int vary_bssid;         /* Randomise BSSID bytes per frame */
+    unsigned share;         /* Percent of ambient traffic */
+};
+
+static const uint8_t our_bssid[6] = CUSTOM_BSSID;
+
+static struct traffic_kind kinds[] = {
+    { "beacon",        0x0080, { 0 },                                  1, 45 },
+    { "data",          0x0208, { 0 },                                  1, 25 },
+    { "probe-phone",   0x0040, { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF }, 0, 15 },
+    { "probe-aircraft",0x0040, { 0 },                                  0, 10 },
+    { "probe-ours",    0x0040, { 0 },                                  0,  5 },
+};
+#define KIND_COUNT  (sizeof(kinds) / sizeof(kinds[0]))
+
+/* Headers kept word aligned, as in the SDK RX buffer */
+static uint32_t frames[KIND_COUNT][FRAMES_PER_KIND][IEEE80211_HEADER_SIZE / 4];
+
+static uint32_t rng_state = 0x12345678;
+
+static uint8_t rng_byte(void)
+{
+    rng_state = rng_state * 1103515245u + 12345u;
+    return (rng_state >> 16) & 0xFF;
+}
+
+static void build_traffic(void)
+{
+    unsigned k, i, b;
+
+    /* Other aircraft share our prefix and differ in the last bytes */
+    memcpy(kinds[3].bssid, our_bssid, 6);
+    kinds[3].bssid[5] ^= 0x01;
+    memcpy(kinds[4].bssid, our_bssid, 6);
+
+    for (k = 0; k < KIND_COUNT; k++) {
+        for (i = 0; i < FRAMES_PER_KIND; i++) {
+            uint8_t *hdr = (uint8_t *)frames[k][i];
+
+            memset(hdr, 0, IEEE80211_HEADER_SIZE);
+            hdr[0] = kinds[k].fc & 0xFF;
+            hdr[1] = kinds[k].fc >> 8;
+            for (b = 0; b < 6; b++) {
+                hdr[RX_HDR_ADDR3_OFFSET + b] = kinds[k].vary_bssid ? rng_byte() : kinds[k].bssid[b];
+            }
+        }
+    }
+}
+
+/* ==================================================
+ * FILTERS UNDER TEST
+ * ================================================== */
+
+/* Previous filter: frame type mask, then os_memcmp of addr3 */
+static __attribute__((noinline)) uint8_t match_bytewise(const uint8_t *hdr)
+{
+    uint16_t fc;
+
+    memcpy(&fc, hdr, 2);
+    if ((fc & IEEE80211_FCTL_FTYPE) != IEEE80211_FCTL_MGMT) {
+        return RX_STAGE_TYPE;
+    }
+    if (memcmp(hdr + RX_HDR_ADDR3_OFFSET, our_bssid, 6) != 0) {
+        return RX_STAGE_BSSID;
+    }
+    return RX_STAGE_ACCEPT;
+}
+
+static struct rx_match pattern;
+
+static __attribute__((noinline)) uint8_t match_wordwise(const uint8_t *hdr)
+{
+    uint8_t link;
+    return rx_match_header(&pattern, hdr, &link);
+}
+
+/* Linear scan over a BSSID list, for the table-size sweep */
+static uint8_t scan_bssids[LINK_MAX_COUNT][6];
+static unsigned scan_count;
+
+static __attribute__((noinline)) uint8_t match_linear(const uint8_t *hdr)
+{
+    uint16_t fc;
+    unsigned i;
+
+    memcpy(&fc, hdr, 2);
+    if ((fc & (IEEE80211_FCTL_FTYPE | IEEE80211_FCTL_STYPE)) != IEEE80211_FC_PROBE_REQ) {
+        return RX_STAGE_TYPE;
+    }
+    for (i = 0; i < scan_count; i++) {
+        if (memcmp(hdr + RX_HDR_ADDR3_OFFSET, scan_bssids[i], 6) == 0) {
+            return RX_STAGE_ACCEPT;
+        }
+    }
+    return RX_STAGE_BSSID;
+}
+
+/**
+ * Fill both the hash pattern and the scan list with n aircraft
+ * (our BSSID with the last byte counting up)
+ */
+static void build_links(unsigned n)
+{
+    unsigned i;
+
+    rx_match_init(&pattern, IEEE80211_FCTL_FTYPE | IEEE80211_FCTL_STYPE, IEEE80211_FC_PROBE_REQ);
+    for (i = 0; i < n; i++) {
+        /* Link 0 is our own BSSID, the rest count up from it */
+        memcpy(scan_bssids[i], our_bssid, 6);
+        scan_bssids[i][5] = (uint8_t)(our_bssid[5] + (i ? 0x10 + i : 0));
+        rx_match_add(&pattern, scan_bssids[i], (uint8_t)i);
+    }
+    scan_count = n;
+}
+
+/* ==================================================
+ * BENCHMARK
+ * ================================================== */
+
+static volatile uint32_t sink;
+
+static double time_kind(uint8_t (*match)(const uint8_t *), unsigned k, uint8_t *result)
+{
+    uint64_t start, elapsed;
+    unsigned r, i;
+    uint32_t acc = 0;
+
+    start = bench_now();
+    for (r = 0; r < ROUNDS; r++) {
+        for (i = 0; i < FRAMES_PER_KIND; i++) {
+            acc += match((const uint8_t *)frames[k][i]);
+        }
+    }
+    elapsed = bench_now() - start;
+
+    sink = acc;
+    *result = match((const uint8_t *)frames[k][0]);
+    return (double)elapsed / ((double)ROUNDS * FRAMES_PER_KIND);
+}
+
+static const char *stage_name(uint8_t stage)
+{
+    switch (stage) {
+        case RX_STAGE_TYPE:   return "type";
+        case RX_STAGE_BSSID:  return "bssid";
+        case RX_STAGE_ACCEPT: return "accept";
+        default:              return "?";
+    }
+}
+
+int main(void)
+{
+    static const unsigned sweep[] = { 1, 4, 16 };
+    double mix_old = 0, mix_new = 0;
+    unsigned k;
+
+    build_traffic();
+    build_links(1);
+
+    printf("%-15s %5s  %-8s %-8s %10s %10s\n",
+           "traffic", "share", "old", "new", "old " BENCH_UNIT, "new " BENCH_UNIT);
+
+    for (k = 0; k < KIND_COUNT; k++) {
+        uint8_t old_stage, new_stage;
+        double t_old = time_kind(match_bytewise, k, &old_stage);
+        double t_new = time_kind(match_wordwise, k, &new_stage);
+
+        printf("%-15s %4u%%  %-8s %-8s %10.2f %10.2f\n",
+               kinds[k].name, kinds[k].share,
+               stage_name(old_stage), stage_name(new_stage), t_old, t_new);
+
+        mix_old += t_old * kinds[k].share / 100.0;
+        mix_new += t_new * kinds[k].share / 100.0;
+    }
+
+    printf("%-15s %5s  %-8s %-8s %10.2f %10.2f\n", "weighted mix", "", "", "", mix_old, mix_new);
+
+    /* Foreign aircraft and our own frames against growing tables */
+    printf("\n%-6s %-15s %12s %12s\n", "links", "traffic", "scan " BENCH_UNIT, "hash " BENCH_UNIT);
+    for (k = 0; k < sizeof(sweep) / sizeof(sweep[0]); k++) {
+        unsigned t;
+
+        build_links(sweep[k]);
+        for (t = 3; t <= 4; t++) {
+            uint8_t stage;
+            double t_scan = time_kind(match_linear, t, &stage);
+            double t_hash = time_kind(match_wordwise, t, &stage);
+
+            printf("%-6u %-15s %12.2f %12.2f\n", sweep[k], kinds[t].name, t_scan, t_hash);
+        }
+    }
+    return 0;
+}
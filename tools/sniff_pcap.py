@@ -0,0 +1,247 @@
+#!/usr/bin/env python3
+"""
+Sniffer capture to pcap for the ESP raw 802.11 radio
+
+Puts the module into sniffer mode (SET_SNIFFER), reads the SNIFF_BATCH
+frames it streams over the UART (src/sniffer.c) and writes every frame
+to a pcap file with a radiotap header built from the RxControl fields,
+ready for Wireshark:
+
+    sniff_pcap.py --port /dev/ttyUSB0 --channel 6 -w ch6.pcap
+    sniff_pcap.py --port /dev/ttyUSB0 -w - | wireshark -k -i -
+
+The SDK only hands over the start of each frame (112 bytes for
+management frames, 36 for data frames, none for control frames), so
+most records are truncated; Wireshark shows the original length.
+Frames the module had to cut or skip for UART bandwidth, and batches
+lost in its UART ring, are counted and reported at the end.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+# ==================================================
+# FIRMWARE CONSTANTS (src/sniffer.h, src/ctrl.h)
+# ==================================================
+
+CTRL_CMD_GET_SNIFFER = 0x70
+CTRL_CMD_SET_SNIFFER = 0x71
+CTRL_CMD_SNIFF_BATCH = 0x72
+CTRL_RESPONSE_BIT = 0x80
+UART_LEN_CLASS_BIT = 0x80
+UART_LEN_LOCAL_BIT = 0x40
+UART_LEN_FLAG_BITS = 0xFE
+
+BATCH = struct.Struct("<HIB")           # [seq u16][dropped u32][count]
+RECORD = struct.Struct("<IbBBBHB")      # [time_us u32][rssi][rate][channel][flags][orig_len u16][cap_len]
+SNIFF_STATS = struct.Struct("<BBBIIIIII")
+
+SNIFF_FLAG_HT = 0x01
+SNIFF_FLAG_40MHZ = 0x02
+SNIFF_FLAG_SGI = 0x04
+SNIFF_FLAG_CUT = 0x10
+
+# RxControl rate code -> 500 kbps units (0-3 = 802.11b, 8-15 = OFDM)
+RX_RATE_500KBPS = [2, 4, 11, 22, 0, 0, 0, 0, 96, 48, 24, 12, 108, 72, 36, 18]
+
+# ==================================================
+# PCAP
+# ==================================================
+
+LINKTYPE_IEEE802_11_RADIOTAP = 127
+SNAPLEN = 65535
+
+
+def radiotap(rssi, rate, channel, flags):
+    """Radiotap header: Flags, Rate (legacy) or MCS (HT), Channel, dBm signal"""
+    freq = 2484 if channel == 14 else 2407 + 5 * channel
+    ht = flags & SNIFF_FLAG_HT
+    chan_flags = 0x0080 | (0x0040 if ht or rate >= 8 else 0x0020)
+
+    if ht:
+        mcs_flags = (1 if flags & SNIFF_FLAG_40MHZ else 0) | (0x04 if flags & SNIFF_FLAG_SGI else 0)
+        present = (1 << 1) | (1 << 3) | (1 << 5) | (1 << 19)
+        fields = struct.pack("<BxHHbBBB", 0, freq, chan_flags, rssi, 0x07, mcs_flags, rate & 0x7F)
+    else:
+        present = (1 << 1) | (1 << 2) | (1 << 3) | (1 << 5)
+        fields = struct.pack("<BBHHb", 0, RX_RATE_500KBPS[rate & 0x0F], freq, chan_flags, rssi)
+
+    return struct.pack("<BBHI", 0, 0, 8 + len(fields), present) + fields
+
+
+class PcapWriter:
+    def __init__(self, f):
+        self.f = f
+        f.write(struct.pack("<IHHiIII", 0xA1B2C3D4, 2, 4, 0, 0, SNAPLEN,
+                            LINKTYPE_IEEE802_11_RADIOTAP))
+
+    def write(self, ts, data, orig_len):
+        sec = int(ts)
+        usec = int((ts - sec) * 1000000)
+        self.f.write(struct.pack("<IIII", sec, usec, len(data), orig_len))
+        self.f.write(data)
+
+
+# ==================================================
+# UART LINK
+# ==================================================
+
+
+def parse_batch(payload):
+    """SNIFF_BATCH frame -> (seq, dropped, records), or None if malformed"""
+    if len(payload) < 2 + BATCH.size or payload[1] != 0:
+        return None
+    seq, dropped, count = BATCH.unpack_from(payload, 2)
+    records = []
+    i = 2 + BATCH.size
+    for _ in range(count):
+        if i + RECORD.size > len(payload):
+            return None
+        rec = RECORD.unpack_from(payload, i)
+        i += RECORD.size
+        cap_len = rec[6]
+        if i + cap_len > len(payload):
+            return None
+        records.append(rec + (bytes(payload[i:i + cap_len]),))
+        i += cap_len
+    return (seq, dropped, records) if i == len(payload) else None
+
+
+class Link:
+    """Local frames on the flight controller UART, shared with the console"""
+
+    def __init__(self, port, baud):
+        try:
+            import serial
+        except ImportError:
+            sys.exit("pyserial is needed (pip install pyserial)")
+        self.ser = serial.Serial(port, baud, timeout=0.05)
+        self.buf = bytearray()
+
+    def send(self, cmd, args=b""):
+        payload = bytes([cmd]) + args
+        hi = UART_LEN_CLASS_BIT | UART_LEN_LOCAL_BIT | ((len(payload) >> 8) & 0x01)
+        self.ser.write(bytes([hi, len(payload) & 0xFF]) + payload)
+
+    def frames(self):
+        """Read what is waiting and return complete local response frames"""
+        self.buf += self.ser.read(4096)
+        out = []
+        i = 0
+        while i + 4 <= len(self.buf):
+            hi = self.buf[i]
+            n = ((hi & ~UART_LEN_FLAG_BITS & 0xFF) << 8) | self.buf[i + 1]
+            if hi & UART_LEN_LOCAL_BIT and self.buf[i + 2] & CTRL_RESPONSE_BIT and n >= 2:
+                if i + 2 + n > len(self.buf):
+                    break
+                frame = bytes(self.buf[i + 2:i + 2 + n])
+                # Console text can look like a header: batches must parse
+                if frame[0] != CTRL_CMD_SNIFF_BATCH | CTRL_RESPONSE_BIT or parse_batch(frame):
+                    out.append(frame)
+                    i += 2 + n
+                    continue
+            i += 1
+        del self.buf[:i]
+        return out
+
+    def command(self, cmd, args=b"", timeout=1.0, on_frame=None):
+        """Send a command and wait for its response (other frames go to on_frame)"""
+        self.send(cmd, args)
+        want = cmd | CTRL_RESPONSE_BIT
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            for frame in self.frames():
+                if frame[0] == want:
+                    return frame[1], frame[2:]
+                if on_frame:
+                    on_frame(frame)
+        sys.exit("no response to command 0x%02X" % cmd)
+
+
+# ==================================================
+# CAPTURE
+# ==================================================
+
+
+class Capture:
+    def __init__(self, writer):
+        self.writer = writer
+        self.frames = 0
+        self.cut = 0
+        self.batches = 0
+        self.batches_lost = 0
+        self.last_seq = None
+        self.base = None        # Host time of the first record
+        self.dev_last = 0
+        self.dev_time = 0       # Unwrapped device microseconds
+
+    def on_frame(self, frame):
+        if frame[0] != CTRL_CMD_SNIFF_BATCH | CTRL_RESPONSE_BIT:
+            return
+        seq, _, records = parse_batch(frame)
+        if self.last_seq is not None:
+            self.batches_lost += (seq - self.last_seq - 1) & 0xFFFF
+        self.last_seq = seq
+        self.batches += 1
+
+        for time_us, rssi, rate, channel, flags, orig_len, _, data in records:
+            if self.base is None:
+                self.base = time.time()
+                self.dev_last = time_us
+            self.dev_time += (time_us - self.dev_last) & 0xFFFFFFFF
+            self.dev_last = time_us
+
+            rt = radiotap(rssi, rate, channel, flags)
+            self.writer.write(self.base + self.dev_time / 1e6, rt + data, len(rt) + orig_len)
+            self.frames += 1
+            if flags & SNIFF_FLAG_CUT:
+                self.cut += 1
+        self.writer.f.flush()
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Capture the radio's sniffer stream to pcap")
+    ap.add_argument("--port", required=True, help="serial port of the module")
+    ap.add_argument("--baud", type=int, default=460800, help="UART baud rate (default 460800)")
+    ap.add_argument("--channel", type=int, default=0, help="channel to sniff (default: stay)")
+    ap.add_argument("--snaplen", type=int, default=0, help="bytes kept per frame (default: all captured)")
+    ap.add_argument("--seconds", type=float, help="stop after this long")
+    ap.add_argument("-w", "--write", required=True, help="pcap file to write ('-' for stdout)")
+    args = ap.parse_args()
+
+    if args.write == "-":
+        out = sys.stdout.buffer
+    else:
+        out = open(args.write, "wb")
+    cap = Capture(PcapWriter(out))
+    link = Link(args.port, args.baud)
+
+    status, _ = link.command(CTRL_CMD_SET_SNIFFER, bytes([1, args.channel, min(args.snaplen, 255)]))
+    if status != 0:
+        sys.exit("SET_SNIFFER refused (channel set while FHSS_ENABLED=1?)")
+    print("sniffing, Ctrl-C to stop", file=sys.stderr)
+
+    end = time.time() + args.seconds if args.seconds else None
+    try:
+        while end is None or time.time() < end:
+            for frame in link.frames():
+                cap.on_frame(frame)
+    except (KeyboardInterrupt, BrokenPipeError):
+        pass
+
+    link.command(CTRL_CMD_SET_SNIFFER, bytes([0, 0, 0]), on_frame=cap.on_frame)
+    _, data = link.command(CTRL_CMD_GET_SNIFFER)
+    _, channel, _, _, _, _, skipped, _, drops = SNIFF_STATS.unpack_from(data)
+
+    if out is not sys.stdout.buffer:
+        out.close()
+    print("channel %u: wrote %u frames (%u cut to the MAC header) in %u batches" %
+          (channel, cap.frames, cap.cut, cap.batches), file=sys.stderr)
+    print("not captured: %u frames skipped for UART bandwidth, %u batches lost (%u on the module)" %
+          (skipped, cap.batches_lost, drops), file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
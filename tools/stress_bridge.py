@@ -0,0 +1,415 @@
+#!/usr/bin/env python3
+"""
+Saturation stress harness for the UART <-> WiFi bridge
+
+Runs a pair of host simulators (`make host`) and drives the UART of
+module A with frames addressed to the air. Module B's UART output is
+read back and checked. Every load point starts a fresh pair, so the
+counters cover that point only. Three scenarios push the bridge where
+it loses data:
+
+    uart      small frames back to back on a fast UART (3 Mbaud)
+    rx_burst  fast UART and radio into B, whose slow UART cannot drain
+    tx_busy   largest bridged frames faster than the radio can send
+
+Each scenario sweeps the offered load as a share of A's line rate and
+records, per point:
+
+    offered / delivered kbps, loss %   payload bytes, unique frames
+    desync                              bytes B's stream skipped to re-frame
+    a_rx_ovf, a_resync                  UART RX ring overflow, bad lengths (A)
+    b_tx_ovf                            UART TX ring overflow (B)
+    tx_busy, txq_drop, budget_drop      TX refused busy, queue full/stale, budget
+    line                                sim FIFO overruns + PTY drops, both ends
+
+Configurations are firmware builds. --set applies to all of them and
+--sweep makes one build per value, so buffer sizes can be compared:
+
+    stress_bridge.py
+    stress_bridge.py --sweep UART_RX_BUFFER_SIZE=256,1024,4096
+    stress_bridge.py --scenario tx_busy --sweep TXQ_BULK_DEPTH=2,8,32 --csv out.csv
+
+Only the simulator is supported: the sweep restarts both ends per point.
+"""
+
+import argparse
+import csv
+import os
+import re
+import select
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import termios
+import time
+import tty
+
+# ==================================================
+# FIRMWARE CONSTANTS (src/user_config.h, src/ctrl.h)
+# ==================================================
+
+CTRL_CMD_GET_BRIDGE = 0x2A
+CTRL_RESPONSE_BIT = 0x80
+UART_LEN_CLASS_BIT = 0x80
+UART_LEN_LOCAL_BIT = 0x40
+UART_LEN_FLAG_BITS = 0xFE
+
+# [rx_ovf][tx_ovf][resync][tx][tx_busy][tx_errors] + per class [stale][full][budget_drop]
+BRIDGE = struct.Struct("<" + "I" * 12)
+
+# Test payload: [magic][seq u32][fill]
+MAGIC = 0xB5
+HEADER = struct.Struct("<BI")
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+SIM = os.path.join(ROOT, "build", "host", "esp-radio-sim")
+
+FAST_BAUD = 3000000
+DRAIN_BAUD = 115200
+
+# name: (size, A baud, B baud, description)
+SCENARIOS = {
+    "uart":     (16,   FAST_BAUD, FAST_BAUD,  "16-byte frames back to back at 3 Mbaud"),
+    "rx_burst": (64,   FAST_BAUD, DRAIN_BAUD, "3 Mbaud in, B drains at 115200"),
+    "tx_busy":  (None, FAST_BAUD, FAST_BAUD,  "MAX_BRIDGE_PACKET_SIZE frames over radio capacity"),
+}
+
+# ==================================================
+# BUILDS
+# ==================================================
+
+
+def read_define(path, name):
+    with open(path) as f:
+        m = re.search(r"^#define\s+%s\s+(\S+)" % name, f.read(), re.M)
+    return m.group(1) if m else None
+
+
+def eval_define(path, name):
+    """Evaluate a derived user_config.h macro through the preprocessor"""
+    src = "#include \"user_config.h\"\n%s\n" % name
+    out = subprocess.run([os.environ.get("HOSTCC", "cc"), "-E", "-P", "-DHOST_BUILD",
+                          "-I" + os.path.join(ROOT, "host", "sdk"),
+                          "-I" + os.path.dirname(path), "-"],
+                         input=src, capture_output=True, text=True, check=True).stdout
+    return int(eval(out.strip().splitlines()[-1], {}))
+
+
+def build(settings, workdir):
+    """Build the simulator with user_config.h overrides; return its path"""
+    if not settings:
+        subprocess.run(["make", "-s", "host"], cwd=ROOT, check=True)
+        return SIM, os.path.join(ROOT, "src", "user_config.h")
+
+    tag = "_".join("%s=%s" % kv for kv in settings)
+    src = os.path.join(workdir, tag, "src")
+    shutil.copytree(os.path.join(ROOT, "src"), src)
+    cfg = os.path.join(src, "user_config.h")
+    with open(cfg) as f:
+        text = f.read()
+    for name, value in settings:
+        text, n = re.subn(r"^(#define\s+%s\s+)\S+" % name, r"\g<1>%s" % value, text, flags=re.M)
+        if n == 0:
+            sys.exit("%s is not defined in user_config.h" % name)
+    with open(cfg, "w") as f:
+        f.write(text)
+
+    out = os.path.join(workdir, tag, "build")
+    subprocess.run(["make", "-s", "host", "SRC_DIR=" + src, "HOST_BUILD_DIR=" + out],
+                   cwd=ROOT, check=True)
+    return os.path.join(out, "esp-radio-sim"), cfg
+
+
+# ==================================================
+# SIMULATOR PAIR
+# ==================================================
+
+
+class Port:
+    """Raw, non-blocking access to a simulator PTY"""
+
+    def __init__(self, path):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY | os.O_NONBLOCK)
+        tty.setraw(self.fd)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+
+    def write(self, data):
+        try:
+            return os.write(self.fd, data)
+        except BlockingIOError:
+            return 0
+
+    def read(self, timeout):
+        if not select.select([self.fd], [], [], timeout)[0]:
+            return b""
+        try:
+            return os.read(self.fd, 65536)
+        except BlockingIOError:
+            return b""
+
+    def close(self):
+        os.close(self.fd)
+
+
+class Pair:
+    """Simulators A and B on a private pair of air ports"""
+
+    def __init__(self, sim, workdir, port, baud_a, baud_b):
+        self.procs = []
+        self.logs = []
+        links = []
+        for i, baud in enumerate((baud_a, baud_b)):
+            link = os.path.join(workdir, "esp-%c" % "ab"[i])
+            log = open(os.path.join(workdir, "sim-%c.log" % "ab"[i]), "w+")
+            self.procs.append(subprocess.Popen(
+                [sim, "--pty-link", link, "--air", str(port + i), "--peer", str(port + 1 - i),
+                 "--baud", str(baud)], stdout=log, stderr=subprocess.STDOUT))
+            self.logs.append(log)
+            links.append(link)
+
+        deadline = time.time() + 5
+        while not all(os.path.exists(l) for l in links):
+            if time.time() > deadline or any(p.poll() is not None for p in self.procs):
+                self.stop()
+                sys.exit("simulator did not start (see %s)" % workdir)
+            time.sleep(0.02)
+        time.sleep(0.3)     # boot: link table, promiscuous mode
+        self.a = Port(links[0])
+        self.b = Port(links[1])
+
+    def stop(self):
+        """Stop both ends; return their line losses (FIFO overruns + PTY drops)"""
+        lost = []
+        for proc, log in zip(self.procs, self.logs):
+            proc.terminate()
+            proc.wait()
+            log.seek(0)
+            m = re.search(r"rx_overrun=(\d+) pty_drop=(\d+)", log.read())
+            lost.append(int(m.group(1)) + int(m.group(2)) if m else 0)
+            log.close()
+        for port in (getattr(self, "a", None), getattr(self, "b", None)):
+            if port is not None:
+                port.close()
+        return lost
+
+
+# ==================================================
+# STREAM
+# ==================================================
+
+
+def frame(payload, local=False):
+    hi = (UART_LEN_CLASS_BIT | UART_LEN_LOCAL_BIT) if local else 0
+    hi |= (len(payload) >> 8) & 0x01
+    return bytes([hi, len(payload) & 0xFF]) + payload
+
+
+class Receiver:
+    """Re-frames B's UART output: test frames, ctrl responses, desync"""
+
+    def __init__(self, size, max_len):
+        self.size = size
+        self.max_len = max_len
+        self.buf = bytearray()
+        self.seqs = set()
+        self.bytes = 0
+        self.desync = 0
+        self.responses = {}
+
+    def feed(self, data):
+        self.buf += data
+        i = 0
+        while i + 2 <= len(self.buf):
+            hi = self.buf[i]
+            n = ((hi & ~UART_LEN_FLAG_BITS & 0xFF) << 8) | self.buf[i + 1]
+            if n == 0 or n > self.max_len:
+                self.desync += 1
+                i += 1
+                continue
+            if i + 2 + n > len(self.buf):
+                break
+            body = bytes(self.buf[i + 2:i + 2 + n])
+            if hi & UART_LEN_LOCAL_BIT:
+                if body[0] & CTRL_RESPONSE_BIT:
+                    self.responses[body[0] & ~CTRL_RESPONSE_BIT & 0xFF] = body[1:]
+            elif n == self.size and body[0] == MAGIC:
+                self.seqs.add(HEADER.unpack_from(body)[1])
+                self.bytes += n
+            else:
+                self.desync += 1
+                i += 1
+                continue
+            i += 2 + n
+        del self.buf[:i]
+
+
+def get_bridge(port, rx, max_len):
+    """GET_BRIDGE through a port whose output `rx` is parsing"""
+    # After RX overflow the module's parser may sit inside a frame whose
+    # bytes were lost. Zeros complete it and then parse as empty frames;
+    # which byte the request starts on depends on parity, so vary it.
+    for attempt in range(4):
+        rx.responses.pop(CTRL_CMD_GET_BRIDGE, None)
+        port.write(bytes(max_len + 2 + attempt) + frame(bytes([CTRL_CMD_GET_BRIDGE]), local=True))
+        deadline = time.time() + 1
+        while time.time() < deadline:
+            rx.feed(port.read(0.05))
+            resp = rx.responses.get(CTRL_CMD_GET_BRIDGE)
+            if resp is not None and resp[0] == 0:
+                return BRIDGE.unpack_from(resp, 1)
+    sys.exit("no GET_BRIDGE response (firmware without 0x2A?)")
+
+
+# ==================================================
+# LOAD POINT
+# ==================================================
+
+
+def run_point(sim, workdir, port, scenario, size, load, seconds, max_len):
+    _, baud_a, baud_b, _ = SCENARIOS[scenario]
+    rx_b = Receiver(size, max_len)
+    rx_a = Receiver(size, max_len)
+
+    # Offered load: a share of A's line rate, in frames per second
+    fps = baud_a / 10 * load / (size + 2)
+    fill = bytes(size - HEADER.size)
+    pending = bytearray()
+    seq = 0
+    sent_bytes = 0
+
+    pair = Pair(sim, workdir, port, baud_a, baud_b)
+    try:
+        start = time.time()
+        end = start + seconds
+        while True:
+            now = time.time()
+            if now >= end and not pending:
+                break
+            # Frames due by now, queued behind what the line has not taken
+            # (bounded: the PTY pushes back once the line is full)
+            while len(pending) < 4096 and now < end and seq < (now - start) * fps:
+                pending += frame(HEADER.pack(MAGIC, seq) + fill)
+                seq += 1
+            if pending:
+                put = pair.a.write(pending)
+                del pending[:put]
+                sent_bytes += put
+            rx_b.feed(pair.b.read(0.0005 if pending else 0.002))
+            rx_a.feed(pair.a.read(0))
+        elapsed = time.time() - start
+
+        # Drain what is still queued or on air (B's UART need not go quiet:
+        # link quality pushes may keep arriving, so wait for test frames only)
+        quiet = time.time()
+        last = rx_b.bytes
+        while time.time() - quiet < 0.5:
+            rx_b.feed(pair.b.read(0.05))
+            if rx_b.bytes != last:
+                last = rx_b.bytes
+                quiet = time.time()
+
+        delivered = (rx_b.bytes, len(rx_b.seqs), rx_b.desync)
+        b = get_bridge(pair.b, rx_b, max_len)
+        a = get_bridge(pair.a, rx_a, max_len)
+    finally:
+        line_a, line_b = pair.stop()
+
+    return {
+        "scenario": scenario,
+        "size": size,
+        "load_pct": round(load * 100),
+        "offered_kbps": round(sent_bytes * 8 / elapsed / 1000, 1),
+        "delivered_kbps": round(delivered[0] * 8 / elapsed / 1000, 1),
+        "frames": seq,
+        "loss_pct": round(100.0 * (seq - delivered[1]) / seq, 2) if seq else 0.0,
+        "desync": delivered[2],
+        "a_rx_ovf": a[0],
+        "a_resync": a[2],
+        "b_tx_ovf": b[1],
+        "tx_busy": a[4],
+        "txq_drop": a[6] + a[7] + a[9] + a[10],
+        "budget_drop": a[8] + a[11],
+        "line_a": line_a,
+        "line_b": line_b,
+    }
+
+
+# ==================================================
+# MAIN
+# ==================================================
+
+COLUMNS = ["config", "scenario", "size", "load_pct", "offered_kbps", "delivered_kbps", "frames",
+           "loss_pct", "desync", "a_rx_ovf", "a_resync", "b_tx_ovf", "tx_busy", "txq_drop",
+           "budget_drop", "line_a", "line_b"]
+
+
+def parse_assign(text):
+    if "=" not in text:
+        sys.exit("expected NAME=VALUE, got '%s'" % text)
+    return text.split("=", 1)
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Throughput versus loss of the UART/WiFi bridge "
+                                             "under saturation (host simulator)")
+    ap.add_argument("--scenario", action="append", choices=sorted(SCENARIOS),
+                    help="scenario to run (repeatable, default all)")
+    ap.add_argument("--loads", default="10,25,50,75,100",
+                    help="offered load points, %% of A's line rate")
+    ap.add_argument("--seconds", type=float, default=2.0, help="traffic time per point")
+    ap.add_argument("--set", action="append", default=[], metavar="NAME=VALUE",
+                    help="user_config.h override for every build (repeatable)")
+    ap.add_argument("--sweep", metavar="NAME=V1,V2,...",
+                    help="one build per value of a user_config.h setting")
+    ap.add_argument("--port", type=int, default=47300, help="first UDP air port")
+    ap.add_argument("--csv", help="also write the results to this file")
+    args = ap.parse_args()
+
+    base = [parse_assign(s) for s in args.set]
+    configs = [base]
+    if args.sweep:
+        name, values = parse_assign(args.sweep)
+        configs = [base + [(name, v)] for v in values.split(",")]
+    loads = [int(l) / 100.0 for l in args.loads.split(",")]
+    scenarios = args.scenario or list(SCENARIOS)
+
+    workdir = tempfile.mkdtemp(prefix="stress-bridge-")
+    rows = []
+    try:
+        print("%-28s %-9s %5s %5s %9s %9s %7s %7s %6s %6s %6s %6s %6s %6s %9s" %
+              ("config", "scenario", "size", "load", "offered", "delivered", "loss%", "desync",
+               "rxovf", "resync", "txovf", "busy", "txq", "budget", "line a/b"))
+        for settings in configs:
+            name = " ".join("%s=%s" % kv for kv in settings) or "default"
+            sim, cfg = build(settings, workdir)
+            max_len = int(read_define(cfg, "MAX_PACKET_SIZE"))
+            bridge_len = eval_define(cfg, "MAX_BRIDGE_PACKET_SIZE")
+            for scenario in scenarios:
+                size = min(SCENARIOS[scenario][0] or bridge_len, bridge_len)
+                for load in loads:
+                    r = run_point(sim, workdir, args.port, scenario, size, load,
+                                  args.seconds, max_len)
+                    r["config"] = name
+                    rows.append(r)
+                    print("%-28s %-9s %5u %4u%% %9.1f %9.1f %7.2f %7u %6u %6u %6u %6u %6u %6u %4u/%-4u" %
+                          (name, scenario, size, r["load_pct"], r["offered_kbps"],
+                           r["delivered_kbps"], r["loss_pct"], r["desync"], r["a_rx_ovf"],
+                           r["a_resync"], r["b_tx_ovf"], r["tx_busy"], r["txq_drop"],
+                           r["budget_drop"], r["line_a"], r["line_b"]))
+                    sys.stdout.flush()
+    finally:
+        shutil.rmtree(workdir, ignore_errors=True)
+
+    if args.csv:
+        with open(args.csv, "w", newline="") as f:
+            w = csv.DictWriter(f, fieldnames=COLUMNS)
+            w.writeheader()
+            for r in rows:
+                w.writerow({k: r[k] for k in COLUMNS})
+        print("wrote %s" % args.csv)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,250 @@
+#!/usr/bin/env python3
+"""
+Event trace decoder for the ESP raw 802.11 radio
+
+Reads the firmware's trace ring (src/trace.c) and prints it as a
+timeline, or writes Chrome trace JSON (chrome://tracing, Perfetto).
+
+The ring comes either straight from the module over the UART, using
+the SET_TRACE / GET_TRACE local commands, or from a file of raw 8-byte
+records saved earlier with --save:
+
+    trace_decode.py --port /dev/ttyUSB0 --save glitch.bin
+    trace_decode.py glitch.bin --chrome glitch.json
+
+Fetching pauses recording first, so the dump's own UART frames do not
+overwrite the ring, and resumes it afterwards (unless --keep-paused).
+"""
+
+import argparse
+import json
+import struct
+import sys
+import time
+
+# ==================================================
+# FIRMWARE CONSTANTS (src/trace.h, src/ctrl.h, src/rx_filter.h)
+# ==================================================
+
+RECORD = struct.Struct("<IBBH")     # [time_us u32][event][a8][a16 u16]
+
+CTRL_CMD_GET_TRACE = 0x27
+CTRL_CMD_SET_TRACE = 0x28
+CTRL_RESPONSE_BIT = 0x80
+UART_LEN_CLASS_BIT = 0x80
+UART_LEN_LOCAL_BIT = 0x40
+UART_LEN_FLAG_BITS = 0xFE
+
+RX_STAGES = ["phy", "type", "bssid", "dup", "len", "deliver"]
+TX_ERRORS = ["invalid", "no_link", "sdk"]
+
+
+def _flags(a8):
+    link = (a8 & 0x3E) >> 1
+    cls = "prio" if a8 & UART_LEN_CLASS_BIT else "bulk"
+    return "%s link=%u%s" % (cls, link, " local" if a8 & UART_LEN_LOCAL_BIT else "")
+
+
+def _name(table, i):
+    return table[i] if i < len(table) else str(i)
+
+
+# Event code -> (name, track, args formatter)
+EVENTS = {
+    1: ("uart_rx_start", "uart", lambda a8, a16: "len_hi=0x%02X" % a8),
+    2: ("uart_rx_end", "uart", lambda a8, a16: "%s len=%u" % (_flags(a8), a16)),
+    3: ("uart_resync", "uart", lambda a8, a16: "len_hi=0x%02X bad_len=%u" % (a8, a16)),
+    4: ("uart_rx_overflow", "uart", lambda a8, a16: "dropped=%u bytes" % a16),
+    5: ("uart_tx_overflow", "uart", lambda a8, a16: "ring=%s len=%u" % ("prio" if a8 else "bulk", a16)),
+    6: ("txq_stale", "txq", lambda a8, a16: "class=%u age=%.1fms" % (a8, a16 / 10.0)),
+    7: ("txq_full", "txq", lambda a8, a16: "class=%u" % a8),
+    8: ("tx_submit", "radio_tx", lambda a8, a16: "link=%u class=%u len=%u" % (a8 >> 1, a8 & 1, a16)),
+    9: ("tx_done", "radio_tx", lambda a8, a16: "status=%u" % a8),
+    10: ("tx_busy", "radio_tx", lambda a8, a16: "len=%u" % a16),
+    11: ("tx_error", "radio_tx", lambda a8, a16: "%s len=%u" % (_name(TX_ERRORS, a8), a16)),
+    12: ("rx_accept", "radio_rx", lambda a8, a16: "link=%u len=%u" % (a8, a16)),
+    13: ("rx_reject", "radio_rx", lambda a8, a16: "%s frame_len=%u" % (_name(RX_STAGES, a8), a16)),
+    14: ("channel", "radio", lambda a8, a16: "ch=%u" % a8),
+    15: ("txq_superseded", "txq", lambda a8, a16: "class=%u link=%u" % (a8, a16)),
+}
+
+# Start event -> (end event, span name) shown as spans in the Chrome trace
+SPANS = {1: (2, "uart_rx_frame"), 8: (9, "tx_air")}
+
+# ==================================================
+# RECORDS
+# ==================================================
+
+
+def parse_records(data):
+    """Split raw bytes into (time_us, event, a8, a16) tuples"""
+    return [RECORD.unpack_from(data, i) for i in range(0, len(data) - RECORD.size + 1, RECORD.size)]
+
+
+def unwrap_times(records):
+    """Make system_get_time() continuous across its 32-bit wrap (~71 min)"""
+    out = []
+    t = 0
+    last = None
+    for time_us, ev, a8, a16 in records:
+        if last is not None:
+            t += (time_us - last) & 0xFFFFFFFF
+        last = time_us
+        out.append((t, ev, a8, a16))
+    return out
+
+
+# ==================================================
+# FETCH OVER UART
+# ==================================================
+
+
+class Link:
+    """Local command channel on the flight controller UART"""
+
+    def __init__(self, port, baud):
+        try:
+            import serial
+        except ImportError:
+            sys.exit("pyserial is needed for --port (pip install pyserial)")
+        self.ser = serial.Serial(port, baud, timeout=0.05)
+        self.buf = bytearray()
+
+    def command(self, cmd, args=b"", timeout=1.0):
+        payload = bytes([cmd]) + args
+        hi = UART_LEN_CLASS_BIT | UART_LEN_LOCAL_BIT | ((len(payload) >> 8) & 0x01)
+        self.ser.write(bytes([hi, len(payload) & 0xFF]) + payload)
+
+        # The console shares the UART: scan for our response frame
+        want = cmd | CTRL_RESPONSE_BIT
+        deadline = time.time() + timeout
+        while time.time() < deadline:
+            self.buf += self.ser.read(512)
+            i = 0
+            while i + 4 <= len(self.buf):
+                hi = self.buf[i]
+                n = ((hi & ~UART_LEN_FLAG_BITS & 0xFF) << 8) | self.buf[i + 1]
+                if hi & UART_LEN_LOCAL_BIT and self.buf[i + 2] == want and n >= 2:
+                    if i + 2 + n > len(self.buf):
+                        break
+                    frame = bytes(self.buf[i + 2:i + 2 + n])
+                    del self.buf[:i + 2 + n]
+                    return frame[1], frame[2:]
+                i += 1
+            del self.buf[:i]
+        sys.exit("no response to command 0x%02X" % cmd)
+
+
+def fetch(port, baud, keep_paused):
+    """Pause recording, read the ring page by page, resume"""
+    link = Link(port, baud)
+
+    status, data = link.command(CTRL_CMD_SET_TRACE, bytes([0]))
+    if status != 0:
+        sys.exit("SET_TRACE refused (firmware built with TRACE_ENABLED=0?)")
+    depth, total = struct.unpack_from("<HI", data, 1)
+
+    raw = bytearray()
+    first = 0
+    while True:
+        status, data = link.command(CTRL_CMD_GET_TRACE, struct.pack("<I", first))
+        if status != 0:
+            sys.exit("GET_TRACE failed: status %u" % status)
+        total, first, n = struct.unpack_from("<IIB", data)
+        raw += data[9:9 + n * RECORD.size]
+        first += n
+        if n == 0 or first >= total:
+            break
+
+    if not keep_paused:
+        link.command(CTRL_CMD_SET_TRACE, bytes([1]))
+
+    print("fetched %u of %u events (ring holds %u)" % (len(raw) // RECORD.size, total, depth),
+          file=sys.stderr)
+    return bytes(raw)
+
+
+# ==================================================
+# OUTPUT
+# ==================================================
+
+
+def print_timeline(records, out):
+    """One line per event: time since the first event, gap, name, args"""
+    prev = None
+    for t, ev, a8, a16 in records:
+        name, _, fmt = EVENTS.get(ev, ("event_%u" % ev, "", lambda a8, a16: "a8=%u a16=%u" % (a8, a16)))
+        gap = t - prev if prev is not None else 0
+        prev = t
+        out.write("%12.3f ms  +%8u us  %-17s %s\n" % (t / 1000.0, gap, name, fmt(a8, a16)))
+
+
+def chrome_trace(records):
+    """Chrome trace events: spans for UART frames and TX, instants otherwise"""
+    tracks = {}
+    events = []
+    open_span = {}
+
+    for t, ev, a8, a16 in records:
+        name, track, fmt = EVENTS.get(ev, ("event_%u" % ev, "other", lambda a8, a16: ""))
+        tid = tracks.setdefault(track, len(tracks) + 1)
+        args = {"info": fmt(a8, a16)}
+
+        if ev in SPANS:
+            end, span = SPANS[ev]
+            open_span[end] = (t, span, args)
+            continue
+
+        start = open_span.pop(ev, None)
+        if start is not None:
+            events.append({"name": start[1], "ph": "X", "ts": start[0],
+                           "dur": t - start[0], "pid": 1, "tid": tid,
+                           "args": {"start": start[2]["info"], "end": args["info"]}})
+        else:
+            events.append({"name": name, "ph": "i", "s": "t", "ts": t,
+                           "pid": 1, "tid": tid, "args": args})
+
+    for track, tid in tracks.items():
+        events.append({"name": "thread_name", "ph": "M", "pid": 1, "tid": tid,
+                       "args": {"name": track}})
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+# ==================================================
+# MAIN
+# ==================================================
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Decode the radio firmware's event trace ring")
+    ap.add_argument("dump", nargs="?", help="raw record file (from --save)")
+    ap.add_argument("--port", help="fetch the ring from the module on this serial port")
+    ap.add_argument("--baud", type=int, default=460800, help="UART baud rate (default 460800)")
+    ap.add_argument("--keep-paused", action="store_true", help="leave recording paused after --port")
+    ap.add_argument("--save", help="write the raw records fetched with --port to this file")
+    ap.add_argument("--chrome", help="write Chrome trace JSON to this file instead of a timeline")
+    args = ap.parse_args()
+
+    if args.port:
+        raw = fetch(args.port, args.baud, args.keep_paused)
+        if args.save:
+            with open(args.save, "wb") as f:
+                f.write(raw)
+    elif args.dump:
+        with open(args.dump, "rb") as f:
+            raw = f.read()
+    else:
+        ap.error("give a dump file or --port")
+
+    records = unwrap_times(parse_records(raw))
+
+    if args.chrome:
+        with open(args.chrome, "w") as f:
+            json.dump(chrome_trace(records), f)
+        print("wrote %u events to %s" % (len(records), args.chrome), file=sys.stderr)
+    else:
+        print_timeline(records, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()